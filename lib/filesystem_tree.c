@@ -28,7 +28,7 @@ filesystem_tree_file_t* _create_file(const char* _name, const char* _file_path,
 {
     filesystem_tree_file_t* file = (filesystem_tree_file_t*)malloc(sizeof(filesystem_tree_file_t));
     file->name_ = strdup(_name);
-    file->path_ = strdup(_file_path);
+    file->path_ = _file_path ? strdup(_file_path) : NULL;
     file->entry_ = _entry;
 
     return file;
@@ -129,10 +129,10 @@ void filesystem_tree_add_directory(filesystem_tree_node_t* _root, const char* _p
     free(dir_path);
 }
 
-void filesystem_tree_add_file(filesystem_tree_node_t* _root, const char* _path, const char* _file_path, pak_entry_t _entry)
+filesystem_tree_file_t* filesystem_tree_add_file(filesystem_tree_node_t* _root, const char* _path, const char* _file_path, pak_entry_t _entry)
 {
     if (!_root || !_path || !*_path)
-        return;
+        return NULL;
 
     char* dir_path = strdup(_path);
     char* dir_name = strtok(dir_path, "/");
@@ -155,10 +155,12 @@ void filesystem_tree_add_file(filesystem_tree_node_t* _root, const char* _path,
             break;
     }
 
+    filesystem_tree_file_t* file = NULL;
     if (dir_name && !file_name)
-        _add_file(current, dir_name, _file_path, _entry);
+        file = _add_file(current, dir_name, _file_path, _entry);
 
     free(dir_path);
+    return file;
 }
 
 filesystem_tree_node_t* filesystem_tree_find_directory(filesystem_tree_node_t* _root, const char* _path) 
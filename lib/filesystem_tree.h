@@ -61,8 +61,9 @@ extern "C" {
 	 * @param _path The path of the directory where the file will be added.
 	 * @param _file_path The file path of the file to add.
 	 * @param _entry The pak_entry_t associated with the file.
+	 * @return A pointer to the added filesystem_tree_file_t or NULL if the path is invalid.
 	 */
-	GPAK_API void filesystem_tree_add_file(filesystem_tree_node_t* _root, const char* _path, const char* _file_path, pak_entry_t _entry);
+	GPAK_API filesystem_tree_file_t* filesystem_tree_add_file(filesystem_tree_node_t* _root, const char* _path, const char* _file_path, pak_entry_t _entry);
 
 	/**
 	 * @brief Finds a directory in the filesystem tree.
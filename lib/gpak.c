@@ -2,17 +2,30 @@
 
 #include "filesystem_tree.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
 
-#ifdef _WIN32
-#include "libfmemopen.h"
-#endif
-
 #include "gpak_compressors.h"
 #include "gpak_helper.h"
+#include "gpak_threads.h"
+#include "gpak_cache.h"
+#include "gpak_uring.h"
+
+#include <zlib.h>
+
+// Directory structures are used in place, their layout must not depend on the compiler
+_Static_assert(sizeof(pak_entry_t) == 48, "pak_entry_t must not contain padding");
+_Static_assert(sizeof(pak_footer_t) == 72, "pak_footer_t must not contain padding");
+_Static_assert(sizeof(pak_index_bucket_t) == 16, "pak_index_bucket_t must not contain padding");
+_Static_assert(sizeof(pak_chunk_table_t) == 8, "pak_chunk_table_t must not contain padding");
+_Static_assert(sizeof(pak_chunk_t) == 16, "pak_chunk_t must not contain padding");
+_Static_assert(sizeof(pak_block_t) == 24, "pak_block_t must not contain padding");
+_Static_assert(sizeof(pak_dictionary_t) == 32, "pak_dictionary_t must not contain padding");
+_Static_assert(sizeof(pak_dictionary_table_t) == 16, "pak_dictionary_table_t must not contain padding");
+_Static_assert(sizeof(pak_dictionary_file_header_t) == 32, "pak_dictionary_file_header_t must not contain padding");
 
 //-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
 //-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
@@ -29,80 +42,201 @@ pak_header_t _pak_make_header()
 	_header.compression_level_ = 0;
 	_header.entry_count_ = 0u;
 	_header.dictionary_size_ = 0u;
+	_header.version_ = GPAK_FORMAT_VERSION;
+	_header.alignment_ = 0u;
 
 	return _header;
 }
 
 int _pak_validate_header(gpak_t* _pak)
 {
-	if (strcmp(_pak->header_.format_, "gpak") != 0)
+	if (strcmp(_pak->header_.format_, "gpak") != 0 || _pak->header_.version_ != GPAK_FORMAT_VERSION ||
+		(_pak->header_.alignment_ & (_pak->header_.alignment_ - 1u)) != 0u)
 		return _gpak_make_error(_pak, GPAK_ERROR_INCORRECT_HEADER);
 
 	return _gpak_make_error(_pak, GPAK_ERROR_OK);
 }
 
-long _write_entry_header(gpak_t* _pak, const char* _path, pak_entry_t* _entry)
+uint64_t _write_padding(gpak_t* _pak, uint64_t _written, uint32_t _alignment)
 {
-	long bytes_writen = 0u;
+	static const char _padding[64] = { 0 };
+
+	if (_alignment <= 1u)
+		return 0ull;
+
+	uint64_t padding_size = (_alignment - _written % _alignment) % _alignment;
+
+	uint64_t written = 0ull;
+	while (written < padding_size)
+	{
+		size_t part = padding_size - written < sizeof(_padding) ? (size_t)(padding_size - written) : sizeof(_padding);
+		size_t part_written = _fwriteb(_padding, 1ull, part, _pak->stream_);
+		written += part_written;
 
-	// Write filename
-	short name_size = strlen(_path);
-	bytes_writen += _fwriteb(&name_size, sizeof(short), 1ull, _pak->stream_);
-	bytes_writen += _fwriteb(_path, 1ull, name_size, _pak->stream_);
-	bytes_writen += _fwriteb(_entry, sizeof(pak_entry_t), 1ull, _pak->stream_);
+		if (part_written != part)
+			break;
+	}
+
+	return written;
+}
+
+uint64_t _gpak_archive_size(gpak_t* _pak)
+{
+	if (_pak->memory_)
+		return _pak->memory_size_;
 
-	return bytes_writen;
+	_gpak_fseek64(_pak->stream_, 0ll, SEEK_END);
+	return _gpak_ftell64(_pak->stream_);
 }
 
-long _read_entry_header(gpak_t* _pak, char* _path, pak_entry_t* _entry)
+size_t _gpak_read_at(gpak_t* _pak, uint64_t _offset, void* _dst, size_t _size)
 {
-	long bytes_readed = 0u;
+	if (_pak->memory_)
+	{
+		if (_offset > _pak->memory_size_ || _size > _pak->memory_size_ - _offset)
+			return 0ull;
 
-	short name_size;
-	bytes_readed += _freadb(&name_size, sizeof(short), 1ull, _pak->stream_);
-	bytes_readed += _freadb(_path, 1ull, name_size, _pak->stream_);
-	bytes_readed += _freadb(_entry, sizeof(pak_entry_t), 1ull, _pak->stream_);
-	_path[name_size] = '\0';
+		memcpy(_dst, _pak->memory_ + _offset, _size);
+		return _size;
+	}
 
-	return bytes_readed;
+	// Positional reads leave the stream position alone, readers on several threads do not move it under each other
+	return _gpak_pread(_pak->stream_, _offset, _dst, _size);
 }
 
-int _update_entry_header(gpak_t* _pak, size_t _commressed_size, size_t _uncompressed_size, long _entry_size, uint32_t _crc32)
+const char* _gpak_read_view(gpak_t* _pak, uint64_t _offset, size_t _size, char** _buffer)
 {
-	pak_entry_t _entry;
+	*_buffer = NULL;
 
-	if (!_pak->stream_ )
-		return _gpak_make_error(_pak, GPAK_ERROR_STREAM_IS_NULL);
+	// Archive images are used in place, streams are read into a buffer owned by the caller
+	if (_pak->memory_)
+	{
+		if (_offset > _pak->memory_size_ || _size > _pak->memory_size_ - _offset)
+			return NULL;
 
-	size_t _shift = 0ull;
-	if (_uncompressed_size == _commressed_size)
-		_shift = _uncompressed_size;
-	else
-		_shift = _commressed_size;
+		return _pak->memory_ + _offset;
+	}
 
-	long _cur_pos = ftell(_pak->stream_);
-	fseek(_pak->stream_, -((long)_shift), SEEK_CUR);
-	long _offset = ftell(_pak->stream_);
-	fseek(_pak->stream_, -_entry_size, SEEK_CUR);
+	*_buffer = (char*)malloc(_size + 1ull);
+	if (_gpak_read_at(_pak, _offset, *_buffer, _size) != _size)
+	{
+		free(*_buffer);
+		*_buffer = NULL;
+	}
+
+	return *_buffer;
+}
 
-	char _entry_path[256];
-	_read_entry_header(_pak, _entry_path, &_entry);
+struct gpak_block_cache
+{
+	gpak_mutex_t mutex_;
+	gpak_block_cache_entry_t entries_[GPAK_BLOCK_CACHE_SIZE];
+	uint64_t clock_;
+};
 
-	_entry.compressed_size_ = _commressed_size;
-	_entry.uncompressed_size_ = _uncompressed_size;
-	_entry.crc32_ = _crc32;
-	_entry.offset_ = _offset;
+struct gpak_block_cache* _gpak_block_cache_create()
+{
+	struct gpak_block_cache* cache = (struct gpak_block_cache*)calloc(1, sizeof(struct gpak_block_cache));
+	_gpak_mutex_init(&cache->mutex_);
+	return cache;
+}
 
-	fseek(_pak->stream_, -_entry_size, SEEK_CUR);
+void _gpak_block_cache_free(struct gpak_block_cache* _cache)
+{
+	if (!_cache)
+		return;
 
-	_write_entry_header(_pak, _entry_path, &_entry);
+	for (uint32_t idx = 0u; idx < GPAK_BLOCK_CACHE_SIZE; ++idx)
+		free(_cache->entries_[idx].data_);
 
-	fseek(_pak->stream_, 0l, SEEK_END);
+	_gpak_mutex_destroy(&_cache->mutex_);
+	free(_cache);
+}
 
-	if (_cur_pos != ftell(_pak->stream_))
-		return _gpak_make_error(_pak, GPAK_ERROR_WRITE);
+// Decodes the payload at an archive offset, the compressed bytes are read into the scratch buffer of a pooled decoder
+int _gpak_decode_at(gpak_t* _pak, uint64_t _offset, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id, int _stored)
+{
+	gpak_decoder_t* decoder = _gpak_decoder_acquire(_pak);
+	if (!decoder)
+		return GPAK_ERROR_READ;
 
-	return GPAK_ERROR_OK;
+	// Archive images are decoded in place
+	char* buffer = NULL;
+	const char* source = NULL;
+	if (_pak->memory_)
+		source = _gpak_read_view(_pak, _offset, _src_size, &buffer);
+	else if ((buffer = _gpak_decoder_scratch(decoder, _src_size)) && _gpak_read_at(_pak, _offset, buffer, _src_size) == _src_size)
+		source = buffer;
+
+	int result = source ? GPAK_ERROR_OK : GPAK_ERROR_READ;
+	if (result == GPAK_ERROR_OK)
+	{
+		size_t decoded = 0ull;
+		if (_stored && _src_size == _dst_size)
+		{
+			memcpy(_dst, source, _dst_size);
+			decoded = _dst_size;
+		}
+		else
+			decoded = _gpak_decoder_decompress(decoder, source, _src_size, _dst, _dst_size, _dictionary_id);
+
+		if (decoded != _dst_size)
+			result = GPAK_ERROR_FILE_CRC_NOT_MATCH;
+	}
+
+	_gpak_decoder_release(_pak, decoder);
+
+	return result;
+}
+
+// Returns the size of the buffer decoding a plain entry in place, or 0 if the entry is not decoded in place
+size_t _gpak_in_place_capacity(gpak_t* _pak, const pak_entry_t* _entry)
+{
+	if (!_pak->in_place_decoding_ || _pak->memory_ || (_entry->flags_ & (GPAK_ENTRY_FLAG_CHUNKED | GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_CHUNK_LIST)))
+		return 0ull;
+
+	size_t margin = _gpak_in_place_margin(_pak, (size_t)_entry->uncompressed_size_);
+	if (margin == SIZE_MAX)
+		return 0ull;
+
+	size_t capacity = (size_t)_entry->uncompressed_size_ + margin;
+	return capacity > _entry->compressed_size_ ? capacity : (size_t)_entry->compressed_size_;
+}
+
+// Reads a plain payload into the tail of its destination buffer and decodes it towards the head, without a staging copy
+int _gpak_decode_in_place(gpak_t* _pak, const pak_entry_t* _entry, char* _dst, size_t _capacity)
+{
+	size_t compressed_size = (size_t)_entry->compressed_size_;
+	size_t uncompressed_size = (size_t)_entry->uncompressed_size_;
+
+	char* source = _dst + _capacity - compressed_size;
+	if (_gpak_read_at(_pak, _entry->offset_, source, compressed_size) != compressed_size)
+		return GPAK_ERROR_READ;
+
+	// Stored payloads have no margin, they are read right where they belong
+	if (!(_pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)))
+		return source == _dst && compressed_size == uncompressed_size ? GPAK_ERROR_OK : GPAK_ERROR_FILE_CRC_NOT_MATCH;
+
+	gpak_decoder_t* decoder = _gpak_decoder_acquire(_pak);
+	if (!decoder)
+		return GPAK_ERROR_READ;
+
+	size_t decoded = _gpak_decoder_decompress(decoder, source, compressed_size, _dst, uncompressed_size, _entry->dictionary_id_);
+	_gpak_decoder_release(_pak, decoder);
+
+	return decoded == uncompressed_size ? GPAK_ERROR_OK : GPAK_ERROR_FILE_CRC_NOT_MATCH;
+}
+
+gpak_thread_pool_t* _gpak_get_thread_pool(gpak_t* _pak)
+{
+	// Readers sharing the archive may race to create the pool, the cache lock settles it
+	_gpak_mutex_lock(&_pak->block_cache_->mutex_);
+	if (!_pak->thread_pool_)
+		_pak->thread_pool_ = _gpak_thread_pool_create(0u);
+	gpak_thread_pool_t* pool = _pak->thread_pool_;
+	_gpak_mutex_unlock(&_pak->block_cache_->mutex_);
+
+	return pool;
 }
 
 int _update_pak_header(gpak_t* _pak)
@@ -124,352 +258,4665 @@ int _update_pak_header(gpak_t* _pak)
 //--------------------------------FILE TREE-------------------------------
 //-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
 //-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
-int _gpak_archivate_file_tree(gpak_t* _pak)
+// Appends a block compressed with _gpak_compress_block to the archive and to the block table
+int _gpak_append_block(gpak_t* _pak, const char* _compressed, uint32_t _compressed_size, uint32_t _size, uint32_t _crc32, uint32_t _dictionary_id)
 {
-	filesystem_tree_iterator_t* iterator = filesystem_iterator_create(_pak->root_);
-	filesystem_tree_node_t* next_directory = _pak->root_;
-	do 
-	{
-		filesystem_tree_file_t* next_file = NULL;
-		while ((next_file = filesystem_iterator_next_file(iterator)))
-		{
-			// Write file header first
-			_pak->current_file_ = filesystem_tree_file_path(next_directory, next_file);
-			pak_entry_t _entry;
-			long header_size = _write_entry_header(_pak, _pak->current_file_, &_entry);
+	_write_padding(_pak, _gpak_ftell64(_pak->stream_), _pak->header_.alignment_);
 
-			FILE* _infile = fopen(next_file->path_, "rb");
-			FILE* _outfile = NULL;
-			if (!_infile)
-				return _gpak_make_error(_pak, GPAK_ERROR_OPEN_FILE);
+	pak_block_t block;
+	block.offset_ = _gpak_ftell64(_pak->stream_);
+	block.compressed_size_ = _compressed_size;
+	block.uncompressed_size_ = _size;
+	block.crc32_ = _crc32;
+	block.dictionary_id_ = _dictionary_id;
 
-			long cursor = ftell(_pak->stream_);
-
-			uint32_t _crc32 = 0u;
-			if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
-				_crc32 = _gpak_compressor_deflate(_pak, _infile, _pak->stream_);
-			else if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
-				_crc32 = _gpak_compressor_zstd(_pak, _infile, _pak->stream_);
-			else
-				_crc32 = _gpak_compressor_none(_pak, _infile, _pak->stream_);
-
-			long position = ftell(_pak->stream_);
-			size_t uncompressed_size = ftell(_infile);
-			size_t compressed_size = position - cursor;
-
-			fflush(_pak->stream_);
-
-			_update_entry_header(_pak, compressed_size, uncompressed_size, header_size, _crc32);
+	if (_fwriteb(_compressed, 1ull, _compressed_size, _pak->stream_) != _compressed_size)
+		return _gpak_make_error(_pak, GPAK_ERROR_WRITE);
 
-			free(_pak->current_file_);
-			fclose(_infile);
-		}
-	} while ((next_directory = filesystem_iterator_next_directory(iterator)));
-	
-	filesystem_iterator_free(iterator);
+	_pak->blocks_ = (pak_block_t*)realloc(_pak->blocks_, sizeof(pak_block_t) * (_pak->block_count_ + 1u));
+	_pak->blocks_[_pak->block_count_++] = block;
 
-	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+	return GPAK_ERROR_OK;
 }
 
-int _gpak_parse_dictionary(gpak_t* _pak)
+int _gpak_write_block(gpak_t* _pak, const char* _data, uint32_t _size, uint32_t _dictionary_id)
 {
-	if(_pak->header_.dictionary_size_ == 0u)
-		return _gpak_make_error(_pak, GPAK_ERROR_OK);
+	char* compressed = (char*)malloc(_gpak_compress_bound(_pak, _size) + 1ull);
+	uint32_t compressed_size = (uint32_t)_gpak_compress_block(_pak, _data, _size, compressed, _dictionary_id);
+	uint32_t _crc32 = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)_data, _size);
 
-	_pak->dictionary_ = (char*)malloc(_pak->header_.dictionary_size_ + 1);
-	_pak->dictionary_[_pak->header_.dictionary_size_] = '\0';
+	int result = _gpak_append_block(_pak, compressed, compressed_size, _size, _crc32, _dictionary_id);
+	free(compressed);
 
-	size_t readed = _freadb(_pak->dictionary_, 1ull, _pak->header_.dictionary_size_, _pak->stream_);
+	return result;
+}
 
-	if(readed != _pak->header_.dictionary_size_)
-		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DICTIONARY);
+// Chunks already stored, chained by block index and bucketed by size and checksum
+struct gpak_chunk_index
+{
+	uint32_t* heads_;
+	uint32_t mask_;
+	uint32_t* next_;
+	uint32_t capacity_;
+};
 
-	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+uint32_t _gpak_chunk_index_slot(const struct gpak_chunk_index* _index, uint32_t _size, uint32_t _crc32)
+{
+	return (uint32_t)((((uint64_t)_size << 32 | _crc32) * 0x9E3779B97F4A7C15ull) >> 32) & _index->mask_;
 }
 
-int _gpak_parse_file_tree(gpak_t* _pak)
+void _gpak_chunk_index_insert(gpak_t* _pak, struct gpak_chunk_index* _index, uint32_t _block)
 {
-	while (1)
+	if (_block >= _index->capacity_)
+	{
+		_index->capacity_ = _index->capacity_ ? _index->capacity_ * 2u : 256u;
+		while (_index->capacity_ <= _block)
+			_index->capacity_ *= 2u;
+
+		_index->next_ = (uint32_t*)realloc(_index->next_, sizeof(uint32_t) * _index->capacity_);
+	}
+
+	// Kept at most half full, rebuilt from the block table when it grows
+	if (_block >= (_index->mask_ + 1u) / 2u)
 	{
-		char _filename[256];
-		pak_entry_t _entry;
-		size_t readed = _read_entry_header(_pak, _filename, &_entry);
-		if (readed == 0)
-			break;	// EOF
+		uint32_t bucket_count = _index->mask_ ? (_index->mask_ + 1u) * 2u : 512u;
+		while (bucket_count / 2u <= _block)
+			bucket_count *= 2u;
 
-		filesystem_tree_add_file(_pak->root_, _filename, NULL, _entry);
+		_index->heads_ = (uint32_t*)realloc(_index->heads_, sizeof(uint32_t) * bucket_count);
+		memset(_index->heads_, 0xff, sizeof(uint32_t) * bucket_count);
+		_index->mask_ = bucket_count - 1u;
 
-		fseek(_pak->stream_, _entry.compressed_size_, SEEK_CUR);
+		for (uint32_t idx = 0u; idx < _block; ++idx)
+		{
+			uint32_t slot = _gpak_chunk_index_slot(_index, _pak->blocks_[idx].uncompressed_size_, _pak->blocks_[idx].crc32_);
+			_index->next_[idx] = _index->heads_[slot];
+			_index->heads_[slot] = idx;
+		}
 	}
 
-	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+	uint32_t slot = _gpak_chunk_index_slot(_index, _pak->blocks_[_block].uncompressed_size_, _pak->blocks_[_block].crc32_);
+	_index->next_[_block] = _index->heads_[slot];
+	_index->heads_[slot] = _block;
 }
 
-//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
-//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
-//-----------------------------IMPLEMENTATION-----------------------------
-//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
-//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
-gpak_t* gpak_open(const char* _path, int _mode)
+bool _gpak_block_matches(gpak_t* _pak, uint32_t _block, const char* _data, uint32_t _size)
 {
-	gpak_t* pak;
-	pak = (gpak_t*)calloc(1, sizeof(gpak_t));
-	pak->mode_ = _mode;
-	pak->current_file_ = NULL;
-	pak->error_handler_ = NULL;
-	pak->progress_handler_ = NULL;
-	pak->user_data_ = NULL;
-	pak->dictionary_ = NULL;
+	const pak_block_t* block = &_pak->blocks_[_block];
+	int64_t position = _gpak_ftell64(_pak->stream_);
 
-	const char* open_mode_;
-	if (_mode & GPAK_MODE_CREATE)
-		open_mode_ = "wb+";
-	else if (_mode & GPAK_MODE_READ_ONLY)
-		open_mode_ = "rb+";
-	else if (_mode & GPAK_MODE_UPDATE)
-		open_mode_ = "ab+";
-	else
-	{
-		gpak_close(pak);
-		return NULL;
-	}
-	
-	// Trying to open pak file
-	pak->stream_ = fopen(_path, open_mode_);
+	char* compressed = (char*)malloc(block->compressed_size_ + 1ull);
+	char* data = (char*)malloc(block->uncompressed_size_ + 1ull);
 
-	if (pak->stream_ == NULL)
-	{
-		gpak_close(pak);
-		return NULL;
-	}
+	_gpak_fseek64(_pak->stream_, (int64_t)block->offset_, SEEK_SET);
+	bool matches = _freadb(compressed, 1ull, block->compressed_size_, _pak->stream_) == block->compressed_size_ &&
+		_gpak_decompress_chunk(_pak, compressed, block->compressed_size_, data, block->uncompressed_size_, block->dictionary_id_) == _size &&
+		memcmp(data, _data, _size) == 0;
 
-	pak->root_ = filesystem_tree_create();
+	_gpak_fseek64(_pak->stream_, position, SEEK_SET);
 
-	if (_mode & GPAK_MODE_CREATE)
+	free(compressed);
+	free(data);
+	return matches;
+}
+
+uint32_t _gpak_store_chunk(gpak_t* _pak, struct gpak_chunk_index* _index, const char* _data, uint32_t _size, uint32_t _dictionary_id)
+{
+	uint32_t _crc32 = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)_data, _size);
+
+	// A matching checksum is confirmed against the stored chunk before it is reused
+	if (_index->heads_)
 	{
-		pak->header_ = _pak_make_header();
-		size_t res = _fwriteb(&pak->header_, sizeof(pak_header_t), 1ull, pak->stream_);
-		if (res != sizeof(pak_header_t))
+		for (uint32_t idx = _index->heads_[_gpak_chunk_index_slot(_index, _size, _crc32)]; idx != UINT32_MAX; idx = _index->next_[idx])
 		{
-			gpak_close(pak);
-			return NULL;
+			if (_pak->blocks_[idx].uncompressed_size_ == _size && _pak->blocks_[idx].crc32_ == _crc32 && _gpak_block_matches(_pak, idx, _data, _size))
+				return idx;
 		}
 	}
-	else if (_mode & GPAK_MODE_UPDATE)
-	{
-		fseek(pak->stream_, 0, SEEK_SET);
 
-		size_t res = _freadb(&pak->header_, sizeof(pak_header_t), 1ull, pak->stream_);
-		if (_pak_validate_header(pak) != GPAK_ERROR_OK || res != sizeof(pak_header_t))
-		{
-			gpak_close(pak);
-			return NULL;
-		}
+	if (_gpak_write_block(_pak, _data, _size, _dictionary_id) != GPAK_ERROR_OK)
+		return UINT32_MAX;
 
-		_gpak_parse_dictionary(pak);
-		_gpak_parse_file_tree(pak);
+	_gpak_chunk_index_insert(_pak, _index, _pak->block_count_ - 1u);
+	return _pak->block_count_ - 1u;
+}
 
-		fseek(pak->stream_, 0, SEEK_END);
-	}
-	else if (_mode & GPAK_MODE_READ_ONLY)
+uint32_t _gpak_compressor_content_chunked(gpak_t* _pak, struct gpak_chunk_index* _index, FILE* _infile, uint64_t _file_size, uint32_t _dictionary_id, uint32_t* _chunk_list_capacity)
+{
+	static uint64_t gear[256];
+	if (!gear[255])
 	{
-		size_t res = _freadb(&pak->header_, sizeof(pak_header_t), 1ull, pak->stream_);
-		if (_pak_validate_header(pak) != GPAK_ERROR_OK || res != sizeof(pak_header_t))
+		// Fixed pseudo-random table, the boundaries must not change between runs
+		uint64_t state = 0x6770616b63646321ull;
+		for (uint32_t idx = 0u; idx < 256u; ++idx)
 		{
-			gpak_close(pak);
-			return NULL;
+			uint64_t value = (state += 0x9E3779B97F4A7C15ull);
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+			gear[idx] = value ^ (value >> 31);
 		}
-
-		_gpak_parse_dictionary(pak);
-		_gpak_parse_file_tree(pak);
 	}
 
-	return pak;
-}
+	uint32_t min_size = _pak->content_chunk_size_ / 4u;
+	uint32_t max_size = _pak->content_chunk_size_ * 4u;
 
-int gpak_close(gpak_t* _pak)
-{
-	if (_pak != NULL)
+	// One boundary every content_chunk_size_ bytes on average, tested on the best mixed top bits
+	uint32_t mask_bits = 0u;
+	while (mask_bits < 48u && (1ull << mask_bits) < _pak->content_chunk_size_)
+		++mask_bits;
+	uint64_t mask = mask_bits ? ((1ull << mask_bits) - 1ull) << (64u - mask_bits) : 0ull;
+
+	char* buffer = (char*)malloc(max_size);
+	uint32_t filled = 0u;
+	uint64_t total_readed = 0ull;
+	uint32_t _crc32 = crc32(0L, Z_NULL, 0);
+
+	for (;;)
 	{
-		if (_pak->stream_ != NULL)
-		{
-			// Recalculate header
+		size_t readed = _freadb(buffer + filled, 1ull, max_size - filled, _infile);
+		filled += (uint32_t)readed;
+		if (filled == 0u)
+			break;
 
-			if ((_pak->mode_ & GPAK_MODE_CREATE) || (_pak->mode_ & GPAK_MODE_UPDATE))
+		// Gear rolling hash, a chunk ends where the top bits of the hash are zero
+		uint32_t cut = filled;
+		uint64_t hash = 0ull;
+		for (uint32_t idx = 0u; idx < filled; ++idx)
+		{
+			hash = (hash << 1u) + gear[(unsigned char)buffer[idx]];
+			if (idx + 1u >= min_size && (hash & mask) == 0ull)
 			{
-				if (_pak->mode_ & GPAK_MODE_CREATE)
-				{
-					if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
-						_gpak_compressor_generate_dictionary(_pak);
-				}
-
-				_gpak_archivate_file_tree(_pak);
+				cut = idx + 1u;
+				break;
 			}
+		}
 
-			filesystem_tree_delete(_pak->root_);
+		_crc32 = crc32(_crc32, (const Bytef*)buffer, cut);
 
-			_update_pak_header(_pak);
-			fclose(_pak->stream_);
+		uint32_t block = _gpak_store_chunk(_pak, _index, buffer, cut, _dictionary_id);
+		if (block == UINT32_MAX)
+			break;
+
+		if (_pak->chunk_list_count_ >= *_chunk_list_capacity)
+		{
+			*_chunk_list_capacity = *_chunk_list_capacity ? *_chunk_list_capacity * 2u : 256u;
+			_pak->chunk_list_ = (uint32_t*)realloc(_pak->chunk_list_, sizeof(uint32_t) * *_chunk_list_capacity);
 		}
-		
-		free(_pak->dictionary_);
-		free(_pak);
-		return _gpak_make_error(_pak, GPAK_ERROR_OK);
+		_pak->chunk_list_[_pak->chunk_list_count_++] = block;
+
+		memmove(buffer, buffer + cut, filled - cut);
+		filled -= cut;
+
+		total_readed += cut;
+		_gpak_pass_progress(_pak, (size_t)total_readed, (size_t)_file_size, GPAK_STAGE_COMPRESSION);
 	}
-	
-	return -1;
+
+	free(buffer);
+	return _crc32;
 }
 
-GPAK_API void gpak_set_user_data(gpak_t* _pak, void* _user_data)
+struct gpak_dedup_record
 {
-	_pak->user_data_ = _user_data;
-}
+	uint64_t size_;
+	filesystem_tree_file_t* file_;
+	uint32_t next_;
+};
 
-GPAK_API void gpak_set_error_handler(gpak_t* _pak, gpak_error_handler_t _error_handler)
+struct gpak_dedup_table
 {
-	_pak->error_handler_ = _error_handler;
-}
+	uint32_t* heads_;
+	uint32_t mask_;
+	struct gpak_dedup_record* records_;
+	uint32_t count_;
+};
 
-GPAK_API void gpak_set_process_handler(gpak_t* _pak, gpak_progress_handler_t _progress_handler)
+uint32_t _gpak_dedup_slot(const struct gpak_dedup_table* _table, uint64_t _size)
 {
-	_pak->progress_handler_ = _progress_handler;
+	return (uint32_t)((_size * 0x9E3779B97F4A7C15ull) >> 32) & _table->mask_;
 }
 
-void gpak_set_compression_algorithm(gpak_t* _pak, int _algorithm)
+void _gpak_dedup_insert(struct gpak_dedup_table* _table, filesystem_tree_file_t* _file)
 {
-	_pak->header_.compression_ = _algorithm;
+	uint32_t slot = _gpak_dedup_slot(_table, _file->entry_.uncompressed_size_);
+
+	struct gpak_dedup_record* record = &_table->records_[_table->count_];
+	record->size_ = _file->entry_.uncompressed_size_;
+	record->file_ = _file;
+	record->next_ = _table->heads_[slot];
+	_table->heads_[slot] = _table->count_++;
 }
 
-void gpak_set_compression_level(gpak_t* _pak, int _level)
+uint32_t _gpak_stream_crc32(FILE* _file)
 {
-	_pak->header_.compression_level_ = _level;
+	char buffer[16384];
+	uint32_t _crc32 = crc32(0L, Z_NULL, 0);
+
+	size_t readed;
+	while ((readed = _freadb(buffer, 1ull, sizeof(buffer), _file)) > 0ull)
+		_crc32 = crc32(_crc32, (const Bytef*)buffer, (uInt)readed);
+
+	return _crc32;
 }
 
-int gpak_add_directory(gpak_t* _pak, const char* _internal_path)
+bool _gpak_same_content(FILE* _file, const char* _path)
 {
-	filesystem_tree_add_directory(_pak->root_, _internal_path);
-	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+	FILE* other = fopen(_path, "rb");
+	if (!other)
+		return false;
+
+	char buffer[16384];
+	char other_buffer[16384];
+	bool same = true;
+
+	_gpak_fseek64(_file, 0ll, SEEK_SET);
+	while (same)
+	{
+		size_t readed = _freadb(buffer, 1ull, sizeof(buffer), _file);
+		size_t other_readed = _freadb(other_buffer, 1ull, sizeof(other_buffer), other);
+
+		same = readed == other_readed && memcmp(buffer, other_buffer, readed) == 0;
+		if (readed == 0ull)
+			break;
+	}
+
+	fclose(other);
+	return same;
 }
 
-int gpak_add_file(gpak_t* _pak, const char* _external_path, const char* _internal_path)
+filesystem_tree_file_t* _gpak_dedup_find(const struct gpak_dedup_table* _table, FILE* _file, uint64_t _size)
 {
-	pak_entry_t _entry;
-	_entry.compressed_size_ = 0u;
-	_entry.uncompressed_size_ = 0u;
-	_entry.offset_ = 0u;
-	_entry.crc32_ = 0;
+	filesystem_tree_file_t* original = NULL;
+	bool hashed = false;
+	uint32_t _crc32 = 0u;
 
-	++_pak->header_.entry_count_;
+	// Only files of the same size are hashed, and a matching checksum is confirmed byte by byte
+	for (uint32_t idx = _table->heads_[_gpak_dedup_slot(_table, _size)]; idx != UINT32_MAX && !original; idx = _table->records_[idx].next_)
+	{
+		const struct gpak_dedup_record* record = &_table->records_[idx];
+		if (record->size_ != _size)
+			continue;
 
-	filesystem_tree_add_file(_pak->root_, _internal_path, _external_path, _entry);
-	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+		if (!hashed)
+		{
+			_crc32 = _gpak_stream_crc32(_file);
+			hashed = true;
+		}
+
+		if (record->file_->entry_.crc32_ == _crc32 && _gpak_same_content(_file, record->file_->path_))
+			original = record->file_;
+	}
+
+	_gpak_fseek64(_file, 0ll, SEEK_SET);
+	return original;
 }
 
-struct filesystem_tree_node* gpak_get_root(gpak_t* _pak)
+// Small files waiting to be compressed together, one block is filled per dictionary
+struct gpak_solid_buffer
 {
-	return _pak->root_;
-}
+	char* data_;
+	uint32_t used_;
+	filesystem_tree_file_t** files_;
+	uint32_t count_;
+	uint32_t capacity_;
+};
 
-filesystem_tree_node_t* gpak_find_directory(gpak_t* _pak, const char* _path)
+// How the payload of a file is produced when packing
+#define _GPAK_PACK_PLAIN 0
+#define _GPAK_PACK_CHUNKED 1
+#define _GPAK_PACK_SOLID 2
+#define _GPAK_PACK_SERIAL 3
+
+struct gpak_pack_file
 {
-	if (_pak == NULL)
-		return NULL;
+	filesystem_tree_file_t* file_;
+	char* path_;
+	uint64_t size_;
+	uint32_t order_;
+	uint32_t dictionary_id_;
+	int kind_;
+	int error_;
+	size_t first_job_;
+	uint32_t job_count_;
+};
 
-	return filesystem_tree_find_directory(_pak->root_, _path);
-}
+// A read and compression run by a worker, a region of a file or a filled solid block
+struct gpak_pack_job
+{
+	struct gpak_pack* pack_;
+	const struct gpak_pack_file* file_;
+	uint64_t offset_;
+	size_t size_;
+	uint32_t dictionary_id_;
+	char* data_;
+	char* output_;
+	size_t output_size_;
+	uint32_t crc32_;
+	int error_;
+	int done_;
+};
 
-filesystem_tree_file_t* gpak_find_file(gpak_t* _pak, const char* _path)
+struct gpak_pack_block
 {
-	if (_pak == NULL)
-		return NULL;
+	struct gpak_pack_job job_;
+	filesystem_tree_file_t** files_;
+	uint32_t count_;
+	struct gpak_pack_block* next_;
+};
 
-	return filesystem_tree_find_file(_pak->root_, _path);
-}
+struct gpak_pack
+{
+	gpak_t* pak_;
+	gpak_thread_pool_t* pool_;
+	gpak_mutex_t mutex_;
+	gpak_cond_t cond_;
+	struct gpak_pack_file* files_;
+	uint32_t file_count_;
+	struct gpak_pack_job* jobs_;
+	size_t job_count_;
+	size_t submitted_;
+	size_t released_;
+	uint64_t buffered_;
+	struct gpak_pack_block* blocks_;
+	struct gpak_pack_block* last_block_;
+	uint32_t block_count_;
+	struct gpak_solid_buffer solid_buffers_[GPAK_MAX_DICTIONARIES + 1u];
+	struct gpak_dedup_table dedup_;
+	filesystem_tree_file_t** duplicates_;
+	uint32_t duplicate_count_;
+	struct gpak_chunk_index chunk_index_;
+	uint32_t chunk_list_capacity_;
+};
 
-gpak_file_t* gpak_fopen(gpak_t* _pak, const char* _path)
+// Looks for a file already packed with the same content, only files with the same checksum are compared byte by byte
+filesystem_tree_file_t* _gpak_dedup_match(const struct gpak_dedup_table* _table, const char* _path, uint64_t _size, uint32_t _crc32)
 {
-	filesystem_tree_file_t* _file_info = filesystem_tree_find_file(_pak->root_, _path);
-	if (!_file_info)
+	for (uint32_t idx = _table->heads_[_gpak_dedup_slot(_table, _size)]; idx != UINT32_MAX; idx = _table->records_[idx].next_)
 	{
-		_gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
-		return NULL;
-	}
+		const struct gpak_dedup_record* record = &_table->records_[idx];
+		if (record->size_ != _size || record->file_->entry_.crc32_ != _crc32)
+			continue;
 
-	_pak->current_file_ = filesystem_tree_file_path(_pak->root_, _file_info);
+		FILE* file = fopen(_path, "rb");
+		if (!file)
+			return NULL;
 
-	uint32_t uncompressed_size = _file_info->entry_.uncompressed_size_;
-	uint32_t compressed_size = _file_info->entry_.compressed_size_;
+		bool same = _gpak_same_content(file, record->file_->path_);
+		fclose(file);
 
-	gpak_file_t* mfile = (gpak_file_t*)malloc(sizeof(gpak_file_t));
-	mfile->data_ = (char*)malloc(uncompressed_size + 1);
-	mfile->data_[uncompressed_size] = '\0';
+		if (same)
+			return record->file_;
+	}
 
-	mfile->stream_ = fmemopen(mfile->data_, uncompressed_size, "wb+");
+	return NULL;
+}
 
-	// Setting position to file start
-	fseek(_pak->stream_, _file_info->entry_.offset_, SEEK_SET);
+bool _gpak_dedup_has_size(const struct gpak_dedup_table* _table, uint64_t _size)
+{
+	for (uint32_t idx = _table->heads_[_gpak_dedup_slot(_table, _size)]; idx != UINT32_MAX; idx = _table->records_[idx].next_)
+	{
+		if (_table->records_[idx].size_ == _size)
+			return true;
+	}
 
-	if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
-		mfile->crc32_ = _gpak_decompressor_inflate(_pak, _pak->stream_, mfile->stream_, compressed_size);
-	else if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
-		mfile->crc32_ = _gpak_decompressor_zstd(_pak, _pak->stream_, mfile->stream_, compressed_size);
-	else
-		mfile->crc32_ = _gpak_decompressor_none(_pak, _pak->stream_, mfile->stream_, compressed_size);
+	return false;
+}
 
-	fseek(mfile->stream_, 0, SEEK_SET);
+void _gpak_pack_scan_job(void* _arg, size_t _index)
+{
+	struct gpak_pack_file* file = &((struct gpak_pack*)_arg)->files_[_index];
 
-	// Check crc32
-	if (mfile->crc32_ != _file_info->entry_.crc32_)
+	FILE* infile = fopen(file->file_->path_, "rb");
+	if (!infile)
 	{
-		_gpak_make_error(_pak, GPAK_ERROR_FILE_CRC_NOT_MATCH);
-		free(_pak->current_file_);
-		gpak_fclose(mfile);
-		return NULL;
+		file->error_ = GPAK_ERROR_OPEN_FILE;
+		return;
 	}
 
-	free(_pak->current_file_);
-
-	return mfile;
+	_gpak_fseek64(infile, 0ll, SEEK_END);
+	file->size_ = _gpak_ftell64(infile);
+	fclose(infile);
 }
 
-int gpak_fgetc(gpak_file_t* _file)
+// Large files are scheduled first so that no worker is left with one at the end, small files keep the tree order they share solid blocks in
+int _gpak_compare_pack_files(const void* _left, const void* _right)
 {
-	return fgetc(_file->stream_);
+	const struct gpak_pack_file* left = (const struct gpak_pack_file*)_left;
+	const struct gpak_pack_file* right = (const struct gpak_pack_file*)_right;
+
+	int left_solid = left->kind_ == _GPAK_PACK_SOLID;
+	int right_solid = right->kind_ == _GPAK_PACK_SOLID;
+	if (left_solid != right_solid)
+		return left_solid - right_solid;
+	if (!left_solid && left->size_ != right->size_)
+		return left->size_ > right->size_ ? -1 : 1;
+	if (left->order_ != right->order_)
+		return left->order_ < right->order_ ? -1 : 1;
+	return 0;
+}
+
+// Reads a region of a file and compresses it, or compresses a filled solid block
+void _gpak_pack_job_run(void* _arg)
+{
+	struct gpak_pack_job* job = (struct gpak_pack_job*)_arg;
+	struct gpak_pack* pack = job->pack_;
+	gpak_t* pak = pack->pak_;
+	const struct gpak_pack_file* file = job->file_;
+
+	if (file)
+	{
+		job->data_ = (char*)malloc(job->size_ + 1ull);
+
+		FILE* infile = fopen(file->file_->path_, "rb");
+		if (!infile)
+			job->error_ = GPAK_ERROR_OPEN_FILE;
+		else
+		{
+			if (_gpak_pread(infile, job->offset_, job->data_, job->size_) != job->size_)
+				job->error_ = GPAK_ERROR_READ;
+			fclose(infile);
+		}
+	}
+
+	if (job->error_ == GPAK_ERROR_OK)
+		job->crc32_ = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)job->data_, (uInt)job->size_);
+
+	// Small files are only read here, they are compressed with the solid block they end up in
+	if (job->error_ == GPAK_ERROR_OK && (!file || file->kind_ != _GPAK_PACK_SOLID))
+	{
+		job->output_ = (char*)malloc(_gpak_compress_bound(pak, job->size_) + 1ull);
+		if (file && file->kind_ == _GPAK_PACK_PLAIN)
+		{
+			job->output_size_ = _gpak_compress_buffer(pak, job->data_, job->size_, job->output_, job->dictionary_id_);
+			if (job->output_size_ == 0ull && (pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)))
+				job->error_ = (pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE) ? GPAK_ERROR_DEFLATE_FAILED : GPAK_ERROR_WRITE;
+		}
+		else
+			job->output_size_ = _gpak_compress_block(pak, job->data_, job->size_, job->output_, job->dictionary_id_);
+
+		free(job->data_);
+		job->data_ = NULL;
+	}
+
+	_gpak_mutex_lock(&pack->mutex_);
+	job->done_ = 1;
+	_gpak_cond_broadcast(&pack->cond_);
+	_gpak_mutex_unlock(&pack->mutex_);
+}
+
+void _gpak_pack_submit(struct gpak_pack* _pack, struct gpak_pack_job* _job)
+{
+	if (_pack->pool_)
+		_gpak_thread_pool_submit(_pack->pool_, &_gpak_pack_job_run, _job);
+	else
+		_gpak_pack_job_run(_job);
+}
+
+// Keeps the workers fed ahead of the writer, the first _required jobs are always handed out
+void _gpak_pack_feed(struct gpak_pack* _pack, size_t _required)
+{
+	while (_pack->submitted_ < _pack->job_count_)
+	{
+		struct gpak_pack_job* job = &_pack->jobs_[_pack->submitted_];
+		if (_pack->submitted_ >= _required && (_pack->buffered_ + job->size_ > GPAK_PACK_BUFFER_SIZE || _pack->submitted_ - _pack->released_ >= GPAK_PACK_QUEUE_LENGTH))
+			break;
+
+		_pack->buffered_ += job->size_;
+		++_pack->submitted_;
+		_gpak_pack_submit(_pack, job);
+	}
+}
+
+struct gpak_pack_job* _gpak_pack_wait(struct gpak_pack* _pack, size_t _index)
+{
+	_gpak_pack_feed(_pack, _index + 1ull);
+
+	struct gpak_pack_job* job = &_pack->jobs_[_index];
+	_gpak_mutex_lock(&_pack->mutex_);
+	while (!job->done_)
+		_gpak_cond_wait(&_pack->cond_, &_pack->mutex_);
+	_gpak_mutex_unlock(&_pack->mutex_);
+
+	return job;
+}
+
+// Jobs are released in the order they were handed out, which frees their share of the buffer budget
+void _gpak_pack_release(struct gpak_pack* _pack, struct gpak_pack_job* _job)
+{
+	free(_job->data_);
+	free(_job->output_);
+	_job->data_ = NULL;
+	_job->output_ = NULL;
+
+	_pack->buffered_ -= _job->size_;
+	++_pack->released_;
+}
+
+void _gpak_pack_write_block(struct gpak_pack* _pack)
+{
+	struct gpak_pack_block* block = _pack->blocks_;
+	_pack->blocks_ = block->next_;
+	if (!_pack->blocks_)
+		_pack->last_block_ = NULL;
+	--_pack->block_count_;
+
+	_gpak_mutex_lock(&_pack->mutex_);
+	while (!block->job_.done_)
+		_gpak_cond_wait(&_pack->cond_, &_pack->mutex_);
+	_gpak_mutex_unlock(&_pack->mutex_);
+
+	if (_gpak_append_block(_pack->pak_, block->job_.output_, (uint32_t)block->job_.output_size_, (uint32_t)block->job_.size_, block->job_.crc32_, block->job_.dictionary_id_) == GPAK_ERROR_OK)
+	{
+		for (uint32_t idx = 0u; idx < block->count_; ++idx)
+			block->files_[idx]->entry_.block_index_ = _pack->pak_->block_count_ - 1u;
+	}
+
+	free(block->job_.output_);
+	free(block->files_);
+	free(block);
+}
+
+// Hands a filled solid block over to the workers, the buffer starts over with new storage
+void _gpak_flush_solid_buffer(struct gpak_pack* _pack, uint32_t _dictionary_id)
+{
+	struct gpak_solid_buffer* buffer = &_pack->solid_buffers_[_dictionary_id];
+	if (buffer->count_ == 0u)
+		return;
+
+	struct gpak_pack_block* block = (struct gpak_pack_block*)calloc(1, sizeof(struct gpak_pack_block));
+	block->job_.pack_ = _pack;
+	block->job_.data_ = buffer->data_;
+	block->job_.size_ = buffer->used_;
+	block->job_.dictionary_id_ = _dictionary_id;
+	block->files_ = buffer->files_;
+	block->count_ = buffer->count_;
+
+	memset(buffer, 0, sizeof(struct gpak_solid_buffer));
+
+	if (_pack->last_block_)
+		_pack->last_block_->next_ = block;
+	else
+		_pack->blocks_ = block;
+	_pack->last_block_ = block;
+	++_pack->block_count_;
+
+	_gpak_pack_submit(_pack, &block->job_);
+
+	// Blocks are written in the order they were filled, so the layout does not depend on which worker finishes first
+	while (_pack->block_count_ > GPAK_PACK_PENDING_BLOCKS)
+		_gpak_pack_write_block(_pack);
+}
+
+void _gpak_pack_duplicate(struct gpak_pack* _pack, filesystem_tree_file_t* _file, filesystem_tree_file_t* _original)
+{
+	_original->entry_.flags_ |= GPAK_ENTRY_FLAG_SHARED;
+	_pack->duplicates_[_pack->duplicate_count_ * 2u] = _file;
+	_pack->duplicates_[_pack->duplicate_count_ * 2u + 1u] = _original;
+	++_pack->duplicate_count_;
+}
+
+void _gpak_pack_solid(struct gpak_pack* _pack, struct gpak_pack_file* _file)
+{
+	gpak_t* pak = _pack->pak_;
+	filesystem_tree_file_t* next_file = _file->file_;
+	uint64_t file_size = _file->size_;
+
+	struct gpak_pack_job* job = _gpak_pack_wait(_pack, _file->first_job_);
+	if (job->error_ != GPAK_ERROR_OK)
+	{
+		_gpak_make_error(pak, job->error_);
+		_gpak_pack_release(_pack, job);
+		return;
+	}
+
+	filesystem_tree_file_t* original = _gpak_dedup_match(&_pack->dedup_, next_file->path_, file_size, job->crc32_);
+	if (original)
+		_gpak_pack_duplicate(_pack, next_file, original);
+	else
+	{
+		struct gpak_solid_buffer* solid_buffer = &_pack->solid_buffers_[_file->dictionary_id_];
+		if (solid_buffer->count_ > 0u && solid_buffer->used_ + file_size > pak->solid_block_size_)
+			_gpak_flush_solid_buffer(_pack, _file->dictionary_id_);
+
+		if (!solid_buffer->data_)
+			solid_buffer->data_ = (char*)malloc(pak->solid_block_size_);
+
+		if (solid_buffer->count_ >= solid_buffer->capacity_)
+		{
+			solid_buffer->capacity_ = solid_buffer->capacity_ ? solid_buffer->capacity_ * 2u : 64u;
+			solid_buffer->files_ = (filesystem_tree_file_t**)realloc(solid_buffer->files_, sizeof(filesystem_tree_file_t*) * solid_buffer->capacity_);
+		}
+
+		memcpy(solid_buffer->data_ + solid_buffer->used_, job->data_, (size_t)file_size);
+
+		// The block index is assigned when the block is written
+		next_file->entry_.flags_ |= GPAK_ENTRY_FLAG_SOLID;
+		next_file->entry_.compressed_size_ = 0ull;
+		next_file->entry_.uncompressed_size_ = file_size;
+		next_file->entry_.offset_ = solid_buffer->used_;
+		next_file->entry_.crc32_ = job->crc32_;
+
+		solid_buffer->used_ += (uint32_t)file_size;
+		solid_buffer->files_[solid_buffer->count_++] = next_file;
+		_gpak_dedup_insert(&_pack->dedup_, next_file);
+	}
+
+	_gpak_pack_release(_pack, job);
+	_gpak_pass_progress(pak, (size_t)file_size, (size_t)file_size, GPAK_STAGE_COMPRESSION);
+}
+
+void _gpak_pack_plain(struct gpak_pack* _pack, struct gpak_pack_file* _file)
+{
+	gpak_t* pak = _pack->pak_;
+	filesystem_tree_file_t* next_file = _file->file_;
+	uint64_t file_size = _file->size_;
+
+	struct gpak_pack_job* job = _gpak_pack_wait(_pack, _file->first_job_);
+	if (job->error_ != GPAK_ERROR_OK)
+	{
+		_gpak_make_error(pak, job->error_);
+		_gpak_pack_release(_pack, job);
+		return;
+	}
+
+	filesystem_tree_file_t* original = _gpak_dedup_match(&_pack->dedup_, next_file->path_, file_size, job->crc32_);
+	if (original)
+		_gpak_pack_duplicate(_pack, next_file, original);
+	else
+	{
+		// Payloads start at a multiple of the alignment so they can be mapped or read with direct I/O
+		_write_padding(pak, _gpak_ftell64(pak->stream_), pak->header_.alignment_);
+		uint64_t cursor = _gpak_ftell64(pak->stream_);
+
+		if (_fwriteb(job->output_, 1ull, job->output_size_, pak->stream_) != job->output_size_)
+			_gpak_make_error(pak, GPAK_ERROR_WRITE);
+
+		next_file->entry_.compressed_size_ = job->output_size_;
+		next_file->entry_.uncompressed_size_ = file_size;
+		next_file->entry_.offset_ = cursor;
+		next_file->entry_.crc32_ = job->crc32_;
+		_gpak_dedup_insert(&_pack->dedup_, next_file);
+	}
+
+	_gpak_pack_release(_pack, job);
+	_gpak_pass_progress(pak, (size_t)file_size, (size_t)file_size, GPAK_STAGE_COMPRESSION);
+}
+
+void _gpak_pack_chunked(struct gpak_pack* _pack, struct gpak_pack_file* _file)
+{
+	gpak_t* pak = _pack->pak_;
+	filesystem_tree_file_t* next_file = _file->file_;
+	uint64_t file_size = _file->size_;
+
+	// Copies are found before the first chunk is written, the file is only hashed if one of the same size was packed
+	filesystem_tree_file_t* original = NULL;
+	if (_gpak_dedup_has_size(&_pack->dedup_, file_size))
+	{
+		FILE* infile = fopen(next_file->path_, "rb");
+		if (infile)
+		{
+			original = _gpak_dedup_find(&_pack->dedup_, infile, file_size);
+			fclose(infile);
+		}
+	}
+
+	if (original)
+	{
+		for (uint32_t idx = 0u; idx < _file->job_count_; ++idx)
+			_gpak_pack_release(_pack, _gpak_pack_wait(_pack, _file->first_job_ + idx));
+
+		_gpak_pack_duplicate(_pack, next_file, original);
+		_gpak_pass_progress(pak, (size_t)file_size, (size_t)file_size, GPAK_STAGE_COMPRESSION);
+		return;
+	}
+
+	pak_chunk_table_t table;
+	table.chunk_size_ = pak->chunk_size_;
+	table.chunk_count_ = _file->job_count_;
+
+	pak_chunk_t* chunks = (pak_chunk_t*)calloc(table.chunk_count_ + 1u, sizeof(pak_chunk_t));
+
+	// The seek table is written up front and patched once the chunk sizes are known
+	_write_padding(pak, _gpak_ftell64(pak->stream_), pak->header_.alignment_);
+	uint64_t cursor = _gpak_ftell64(pak->stream_);
+
+	uint64_t payload_size = 0ull;
+	payload_size += _fwriteb(&table, sizeof(pak_chunk_table_t), 1ull, pak->stream_);
+	payload_size += _fwriteb(chunks, sizeof(pak_chunk_t), table.chunk_count_, pak->stream_);
+
+	uint32_t _crc32 = crc32(0L, Z_NULL, 0);
+	int result = GPAK_ERROR_OK;
+	uint64_t total_readed = 0ull;
+	for (uint32_t idx = 0u; idx < _file->job_count_; ++idx)
+	{
+		struct gpak_pack_job* job = _gpak_pack_wait(_pack, _file->first_job_ + idx);
+		if (result == GPAK_ERROR_OK && job->error_ != GPAK_ERROR_OK)
+			result = _gpak_make_error(pak, job->error_);
+
+		if (result == GPAK_ERROR_OK)
+		{
+			chunks[idx].offset_ = payload_size;
+			chunks[idx].compressed_size_ = (uint32_t)job->output_size_;
+			chunks[idx].crc32_ = job->crc32_;
+			payload_size += _fwriteb(job->output_, 1ull, job->output_size_, pak->stream_);
+
+			_crc32 = crc32_combine(_crc32, job->crc32_, (z_off_t)job->size_);
+			total_readed += job->size_;
+			_gpak_pass_progress(pak, (size_t)total_readed, (size_t)file_size, GPAK_STAGE_COMPRESSION);
+		}
+
+		_gpak_pack_release(_pack, job);
+	}
+
+	int64_t end_position = _gpak_ftell64(pak->stream_);
+	_gpak_fseek64(pak->stream_, (int64_t)cursor + (int64_t)sizeof(pak_chunk_table_t), SEEK_SET);
+	_fwriteb(chunks, sizeof(pak_chunk_t), table.chunk_count_, pak->stream_);
+	_gpak_fseek64(pak->stream_, end_position, SEEK_SET);
+	free(chunks);
+
+	next_file->entry_.flags_ |= GPAK_ENTRY_FLAG_CHUNKED;
+	next_file->entry_.compressed_size_ = (uint64_t)end_position - cursor;
+	next_file->entry_.uncompressed_size_ = file_size;
+	next_file->entry_.offset_ = cursor;
+	next_file->entry_.crc32_ = _crc32;
+	_gpak_dedup_insert(&_pack->dedup_, next_file);
+}
+
+// Files split by content and large files that are not chunked are packed by the writer itself
+void _gpak_pack_serial(struct gpak_pack* _pack, struct gpak_pack_file* _file)
+{
+	gpak_t* pak = _pack->pak_;
+	filesystem_tree_file_t* next_file = _file->file_;
+
+	FILE* _infile = fopen(next_file->path_, "rb");
+	if (!_infile)
+	{
+		_gpak_make_error(pak, GPAK_ERROR_OPEN_FILE);
+		return;
+	}
+
+	uint64_t file_size = _file->size_;
+	filesystem_tree_file_t* original = _gpak_dedup_find(&_pack->dedup_, _infile, file_size);
+	if (original)
+	{
+		_gpak_pack_duplicate(_pack, next_file, original);
+		_gpak_pass_progress(pak, (size_t)file_size, (size_t)file_size, GPAK_STAGE_COMPRESSION);
+		fclose(_infile);
+		return;
+	}
+
+	if (pak->content_chunk_size_ > 0u && file_size > pak->content_chunk_size_)
+	{
+		uint32_t first_chunk = pak->chunk_list_count_;
+
+		next_file->entry_.flags_ |= GPAK_ENTRY_FLAG_CHUNK_LIST;
+		next_file->entry_.crc32_ = _gpak_compressor_content_chunked(pak, &_pack->chunk_index_, _infile, file_size, _file->dictionary_id_, &_pack->chunk_list_capacity_);
+		next_file->entry_.compressed_size_ = 0ull;
+		next_file->entry_.uncompressed_size_ = file_size;
+		next_file->entry_.offset_ = 0ull;
+		next_file->entry_.block_index_ = first_chunk;
+		next_file->entry_.block_count_ = pak->chunk_list_count_ - first_chunk;
+		_gpak_dedup_insert(&_pack->dedup_, next_file);
+
+		fclose(_infile);
+		return;
+	}
+
+	_write_padding(pak, _gpak_ftell64(pak->stream_), pak->header_.alignment_);
+	uint64_t cursor = _gpak_ftell64(pak->stream_);
+
+	uint32_t _crc32 = 0u;
+	if (pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
+		_crc32 = _gpak_compressor_deflate(pak, _infile, pak->stream_);
+	else if (pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
+		_crc32 = _gpak_compressor_zstd(pak, _infile, pak->stream_, _file->dictionary_id_);
+	else
+		_crc32 = _gpak_compressor_none(pak, _infile, pak->stream_);
+
+	uint64_t position = _gpak_ftell64(pak->stream_);
+
+	next_file->entry_.compressed_size_ = position - cursor;
+	next_file->entry_.uncompressed_size_ = file_size;
+	next_file->entry_.offset_ = cursor;
+	next_file->entry_.crc32_ = _crc32;
+	_gpak_dedup_insert(&_pack->dedup_, next_file);
+
+	fclose(_infile);
+}
+
+int _gpak_archivate_file_tree(gpak_t* _pak)
+{
+	struct gpak_pack pack;
+	memset(&pack, 0, sizeof(pack));
+	pack.pak_ = _pak;
+	_gpak_mutex_init(&pack.mutex_);
+	_gpak_cond_init(&pack.cond_);
+
+	// Files already packed, by size, so that byte-identical copies can point at the first one
+	uint32_t dedup_buckets = 1u;
+	while (dedup_buckets < _pak->header_.entry_count_ * 2u)
+		dedup_buckets *= 2u;
+
+	pack.dedup_.heads_ = (uint32_t*)malloc(sizeof(uint32_t) * dedup_buckets);
+	memset(pack.dedup_.heads_, 0xff, sizeof(uint32_t) * dedup_buckets);
+	pack.dedup_.mask_ = dedup_buckets - 1u;
+	pack.dedup_.records_ = (struct gpak_dedup_record*)malloc(sizeof(struct gpak_dedup_record) * (_pak->header_.entry_count_ + 1u));
+	pack.dedup_.count_ = 0u;
+
+	// Copies are resolved at the end, the solid block of the original may not be written yet
+	pack.duplicates_ = (filesystem_tree_file_t**)malloc(sizeof(filesystem_tree_file_t*) * 2u * (_pak->header_.entry_count_ + 1u));
+
+	// Chunks of large files are shared with every block already in the archive
+	pack.chunk_list_capacity_ = _pak->chunk_list_count_;
+	if (_pak->content_chunk_size_ > 0u)
+	{
+		for (uint32_t idx = 0u; idx < _pak->block_count_; ++idx)
+			_gpak_chunk_index_insert(_pak, &pack.chunk_index_, idx);
+	}
+
+	// Entries loaded from the directory of an updated archive are already stored
+	uint32_t file_capacity = 0u;
+	filesystem_tree_iterator_t* iterator = filesystem_iterator_create(_pak->root_);
+	filesystem_tree_node_t* next_directory = _pak->root_;
+	do
+	{
+		filesystem_tree_file_t* next_file = NULL;
+		while ((next_file = filesystem_iterator_next_file(iterator)))
+		{
+			if (!next_file->path_)
+				continue;
+
+			if (pack.file_count_ == file_capacity)
+			{
+				file_capacity = file_capacity ? file_capacity * 2u : 256u;
+				pack.files_ = (struct gpak_pack_file*)realloc(pack.files_, sizeof(struct gpak_pack_file) * file_capacity);
+			}
+
+			struct gpak_pack_file* file = &pack.files_[pack.file_count_];
+			memset(file, 0, sizeof(struct gpak_pack_file));
+			file->file_ = next_file;
+			file->path_ = filesystem_tree_file_path(next_directory, next_file);
+			file->order_ = pack.file_count_++;
+
+			// Files are compressed with the dictionary trained on their class
+			if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
+				file->dictionary_id_ = _gpak_dictionary_find(_pak, file->path_);
+		}
+	} while ((next_directory = filesystem_iterator_next_directory(iterator)));
+
+	filesystem_iterator_free(iterator);
+
+	// Every worker reads and compresses its own files, the calling thread is the only one writing to the archive
+	pack.pool_ = _gpak_get_thread_pool(_pak);
+	_gpak_thread_pool_parallel_for(pack.pool_, pack.file_count_, &_gpak_pack_scan_job, &pack);
+
+	for (uint32_t idx = 0u; idx < pack.file_count_; ++idx)
+	{
+		struct gpak_pack_file* file = &pack.files_[idx];
+		if (file->error_ != GPAK_ERROR_OK)
+			file->kind_ = _GPAK_PACK_SERIAL;
+		else if (_pak->content_chunk_size_ > 0u && file->size_ > _pak->content_chunk_size_)
+			file->kind_ = _GPAK_PACK_SERIAL;
+		// Files that span more than one chunk get a seek table and independent chunks
+		else if (_pak->chunk_size_ > 0u && file->size_ > _pak->chunk_size_)
+		{
+			file->kind_ = _GPAK_PACK_CHUNKED;
+			file->job_count_ = (uint32_t)((file->size_ + _pak->chunk_size_ - 1ull) / _pak->chunk_size_);
+		}
+		else if (_pak->solid_block_size_ > 0u && file->size_ < _pak->solid_block_size_)
+			file->kind_ = _GPAK_PACK_SOLID;
+		else if (file->size_ <= GPAK_PACK_JOB_SIZE)
+			file->kind_ = _GPAK_PACK_PLAIN;
+		else
+			file->kind_ = _GPAK_PACK_SERIAL;
+
+		if (file->kind_ == _GPAK_PACK_SOLID || file->kind_ == _GPAK_PACK_PLAIN)
+			file->job_count_ = 1u;
+		pack.job_count_ += file->job_count_;
+	}
+
+	qsort(pack.files_, pack.file_count_, sizeof(struct gpak_pack_file), _gpak_compare_pack_files);
+
+	pack.jobs_ = (struct gpak_pack_job*)calloc(pack.job_count_ + 1ull, sizeof(struct gpak_pack_job));
+	size_t job_index = 0ull;
+	for (uint32_t idx = 0u; idx < pack.file_count_; ++idx)
+	{
+		struct gpak_pack_file* file = &pack.files_[idx];
+		file->first_job_ = job_index;
+
+		for (uint32_t part = 0u; part < file->job_count_; ++part)
+		{
+			struct gpak_pack_job* job = &pack.jobs_[job_index++];
+			job->pack_ = &pack;
+			job->file_ = file;
+			job->dictionary_id_ = file->dictionary_id_;
+			job->offset_ = file->kind_ == _GPAK_PACK_CHUNKED ? (uint64_t)part * _pak->chunk_size_ : 0ull;
+			job->size_ = (size_t)(file->kind_ == _GPAK_PACK_CHUNKED && file->size_ - job->offset_ > _pak->chunk_size_ ? _pak->chunk_size_ : file->size_ - job->offset_);
+		}
+	}
+
+	// The writer commits files in order, dedup and solid blocks see them in the same order whatever the timing of the workers
+	for (uint32_t idx = 0u; idx < pack.file_count_; ++idx)
+	{
+		struct gpak_pack_file* file = &pack.files_[idx];
+		filesystem_tree_file_t* next_file = file->file_;
+		_pak->current_file_ = file->path_;
+
+		_gpak_pack_feed(&pack, 0ull);
+
+		if (file->error_ != GPAK_ERROR_OK)
+		{
+			_gpak_make_error(_pak, file->error_);
+			_pak->current_file_ = NULL;
+			continue;
+		}
+
+		next_file->entry_.flags_ = GPAK_ENTRY_FLAG_NONE;
+		next_file->entry_.block_index_ = 0u;
+		next_file->entry_.block_count_ = 0u;
+		next_file->entry_.dictionary_id_ = file->dictionary_id_;
+		next_file->entry_.reserved_ = 0u;
+
+		if (file->kind_ == _GPAK_PACK_SOLID)
+			_gpak_pack_solid(&pack, file);
+		else if (file->kind_ == _GPAK_PACK_PLAIN)
+			_gpak_pack_plain(&pack, file);
+		else if (file->kind_ == _GPAK_PACK_CHUNKED)
+			_gpak_pack_chunked(&pack, file);
+		else
+			_gpak_pack_serial(&pack, file);
+
+		_pak->current_file_ = NULL;
+	}
+
+	for (uint32_t idx = 0u; idx <= GPAK_MAX_DICTIONARIES; ++idx)
+		_gpak_flush_solid_buffer(&pack, idx);
+	while (pack.blocks_)
+		_gpak_pack_write_block(&pack);
+
+	for (uint32_t idx = 0u; idx <= GPAK_MAX_DICTIONARIES; ++idx)
+	{
+		free(pack.solid_buffers_[idx].data_);
+		free(pack.solid_buffers_[idx].files_);
+	}
+
+	for (uint32_t idx = 0u; idx < pack.duplicate_count_; ++idx)
+		pack.duplicates_[idx * 2u]->entry_ = pack.duplicates_[idx * 2u + 1u]->entry_;
+
+	for (uint32_t idx = 0u; idx < pack.file_count_; ++idx)
+		free(pack.files_[idx].path_);
+
+	free(pack.files_);
+	free(pack.jobs_);
+	free(pack.duplicates_);
+	free(pack.dedup_.heads_);
+	free(pack.dedup_.records_);
+	free(pack.chunk_index_.heads_);
+	free(pack.chunk_index_.next_);
+	_gpak_cond_destroy(&pack.cond_);
+	_gpak_mutex_destroy(&pack.mutex_);
+
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+int _gpak_write_directory(gpak_t* _pak)
+{
+	// The directory follows the last payload, aligned so that mapped archives use its records in place
+	_write_padding(_pak, _gpak_ftell64(_pak->stream_), 8u);
+
+	pak_footer_t _footer;
+	memset(&_footer, 0, sizeof(pak_footer_t));
+	strcpy(_footer.magic_, "gpakdir");
+	_footer.directory_offset_ = _gpak_ftell64(_pak->stream_);
+
+	uint32_t entry_count = 0u;
+	uint32_t entries_capacity = 0u;
+	pak_entry_t* entries = NULL;
+	char** paths = NULL;
+
+	filesystem_tree_iterator_t* iterator = filesystem_iterator_create(_pak->root_);
+	filesystem_tree_node_t* next_directory = _pak->root_;
+	do
+	{
+		filesystem_tree_file_t* next_file = NULL;
+		while ((next_file = filesystem_iterator_next_file(iterator)))
+		{
+			if (entry_count >= entries_capacity)
+			{
+				entries_capacity = entries_capacity ? entries_capacity * 2u : 64u;
+				entries = (pak_entry_t*)realloc(entries, sizeof(pak_entry_t) * entries_capacity);
+				paths = (char**)realloc(paths, sizeof(char*) * entries_capacity);
+			}
+
+			entries[entry_count] = next_file->entry_;
+			paths[entry_count] = filesystem_tree_file_path(next_directory, next_file);
+			++entry_count;
+		}
+	} while ((next_directory = filesystem_iterator_next_directory(iterator)));
+
+	filesystem_iterator_free(iterator);
+
+	_pak->header_.entry_count_ = entry_count;
+
+	// The dictionary leads the directory so both are fetched with a single read
+	if (_pak->dictionary_ && _pak->header_.dictionary_size_ > 0)
+		_footer.directory_size_ += _fwriteb(_pak->dictionary_, 1ull, _pak->header_.dictionary_size_, _pak->stream_);
+
+	// Fixed size records, aligned so that readers can use them in place
+	_footer.directory_size_ += _write_padding(_pak, _footer.directory_size_, 8u);
+	_footer.entries_offset_ = _footer.directory_size_;
+	_footer.directory_size_ += _fwriteb(entries, sizeof(pak_entry_t), entry_count, _pak->stream_);
+
+	// Name offsets into the null-terminated names that follow, one extra for the end of the last name
+	uint32_t name_offset = 0u;
+	for (uint32_t idx = 0u; idx < entry_count; ++idx)
+	{
+		_footer.directory_size_ += _fwriteb(&name_offset, sizeof(uint32_t), 1ull, _pak->stream_);
+		name_offset += (uint32_t)strlen(paths[idx]) + 1u;
+	}
+	_footer.directory_size_ += _fwriteb(&name_offset, sizeof(uint32_t), 1ull, _pak->stream_);
+
+	_footer.names_offset_ = _footer.directory_size_;
+	for (uint32_t idx = 0u; idx < entry_count; ++idx)
+		_footer.directory_size_ += _fwriteb(paths[idx], 1ull, strlen(paths[idx]) + 1ull, _pak->stream_);
+
+	// Path index, aligned so that readers can use the buckets in place
+	_footer.directory_size_ += _write_padding(_pak, _footer.directory_size_, 8u);
+	_footer.index_offset_ = _footer.directory_size_;
+
+	uint32_t bucket_count = 1u;
+	while (bucket_count < entry_count * 2u)
+		bucket_count *= 2u;
+
+	pak_index_bucket_t* buckets = (pak_index_bucket_t*)malloc(sizeof(pak_index_bucket_t) * bucket_count);
+	for (uint32_t idx = 0u; idx < bucket_count; ++idx)
+	{
+		buckets[idx].hash_ = 0ull;
+		buckets[idx].entry_ = UINT32_MAX;
+		buckets[idx].reserved_ = 0u;
+	}
+
+	for (uint32_t idx = 0u; idx < entry_count; ++idx)
+	{
+		uint64_t hash = _gpak_hash_path(paths[idx]);
+		uint32_t slot = (uint32_t)hash & (bucket_count - 1u);
+		while (buckets[slot].entry_ != UINT32_MAX)
+			slot = (slot + 1u) & (bucket_count - 1u);
+
+		buckets[slot].hash_ = hash;
+		buckets[slot].entry_ = idx;
+	}
+
+	uint32_t index_header[2] = { bucket_count, 0u };
+	_footer.directory_size_ += _fwriteb(index_header, sizeof(uint32_t), 2ull, _pak->stream_);
+	_footer.directory_size_ += _fwriteb(buckets, sizeof(pak_index_bucket_t), bucket_count, _pak->stream_);
+
+	// Solid block table, the index keeps it aligned
+	_footer.blocks_offset_ = _footer.directory_size_;
+
+	uint32_t blocks_header[2] = { _pak->block_count_, 0u };
+	_footer.directory_size_ += _fwriteb(blocks_header, sizeof(uint32_t), 2ull, _pak->stream_);
+	_footer.directory_size_ += _fwriteb(_pak->blocks_, sizeof(pak_block_t), _pak->block_count_, _pak->stream_);
+
+	// Chunk lists of content-chunked entries
+	_footer.chunk_list_offset_ = _footer.directory_size_;
+
+	uint32_t chunk_list_header[2] = { _pak->chunk_list_count_, 0u };
+	_footer.directory_size_ += _fwriteb(chunk_list_header, sizeof(uint32_t), 2ull, _pak->stream_);
+	_footer.directory_size_ += _fwriteb(_pak->chunk_list_, sizeof(uint32_t), _pak->chunk_list_count_, _pak->stream_);
+
+	// Dictionary table, each record points into the dictionary bytes at the start of the directory
+	_footer.directory_size_ += _write_padding(_pak, _footer.directory_size_, 8u);
+	_footer.dictionaries_offset_ = _footer.directory_size_;
+
+	pak_dictionary_table_t dictionary_table;
+	dictionary_table.dictionary_count_ = _pak->dictionary_count_;
+	dictionary_table.flags_ = GPAK_DICTIONARY_TABLE_FLAG_NONE;
+	dictionary_table.shared_id_ = 0ull;
+
+	// Shared dictionaries are only referenced, their records live in the dictionary file
+	if (_pak->shared_dictionary_)
+	{
+		dictionary_table.flags_ |= GPAK_DICTIONARY_TABLE_FLAG_SHARED;
+		dictionary_table.shared_id_ = _pak->shared_dictionary_->content_id_;
+	}
+
+	_footer.directory_size_ += _fwriteb(&dictionary_table, sizeof(pak_dictionary_table_t), 1ull, _pak->stream_);
+	if (!_pak->shared_dictionary_)
+		_footer.directory_size_ += _fwriteb(_pak->dictionaries_, sizeof(pak_dictionary_t), _pak->dictionary_count_, _pak->stream_);
+
+	for (uint32_t idx = 0u; idx < entry_count; ++idx)
+		free(paths[idx]);
+
+	free(buckets);
+	free(paths);
+	free(entries);
+	_pak->footer_ = _footer;
+
+	if (_fwriteb(&_footer, sizeof(pak_footer_t), 1ull, _pak->stream_) != sizeof(pak_footer_t))
+		return _gpak_make_error(_pak, GPAK_ERROR_WRITE);
+
+	fflush(_pak->stream_);
+
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+int _gpak_parse_directory(gpak_t* _pak)
+{
+	pak_footer_t* _footer = &_pak->footer_;
+
+	uint64_t archive_size = _gpak_archive_size(_pak);
+	if (archive_size < sizeof(pak_header_t) + sizeof(pak_footer_t))
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	size_t readed = _gpak_read_at(_pak, archive_size - sizeof(pak_footer_t), _footer, sizeof(pak_footer_t));
+	if (readed != sizeof(pak_footer_t) || strncmp(_footer->magic_, "gpakdir", sizeof(_footer->magic_)) != 0 ||
+		_footer->directory_offset_ > archive_size - sizeof(pak_footer_t) || _footer->directory_size_ > archive_size - sizeof(pak_footer_t) - _footer->directory_offset_)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	uint64_t entry_count = _pak->header_.entry_count_;
+	uint64_t directory_size = _footer->directory_size_;
+
+	// Every section has to fit the directory, records and buckets have to be aligned
+	if (_footer->entries_offset_ < _pak->header_.dictionary_size_ || _footer->entries_offset_ % 8u != 0u ||
+		_footer->entries_offset_ > directory_size ||
+		(directory_size - _footer->entries_offset_) / (sizeof(pak_entry_t) + sizeof(uint32_t)) < entry_count ||
+		_footer->names_offset_ != _footer->entries_offset_ + entry_count * (sizeof(pak_entry_t) + sizeof(uint32_t)) + sizeof(uint32_t) ||
+		_footer->names_offset_ > directory_size ||
+		_footer->index_offset_ < _footer->names_offset_ || _footer->index_offset_ % 8u != 0u ||
+		_footer->blocks_offset_ < _footer->index_offset_ + 2u * sizeof(uint32_t) || _footer->blocks_offset_ % 8u != 0u ||
+		_footer->chunk_list_offset_ < _footer->blocks_offset_ + 2u * sizeof(uint32_t) || _footer->chunk_list_offset_ % 8u != 0u ||
+		_footer->dictionaries_offset_ < _footer->chunk_list_offset_ + 2u * sizeof(uint32_t) || _footer->dictionaries_offset_ % 8u != 0u ||
+		_footer->dictionaries_offset_ > directory_size || directory_size - _footer->dictionaries_offset_ < sizeof(pak_dictionary_table_t))
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	// Dictionary and entry table are read at once and used from memory
+	const char* directory = _gpak_read_view(_pak, _footer->directory_offset_, (size_t)directory_size, &_pak->directory_buffer_);
+	if (!directory)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	// Records are used in place, an image placed at an odd address gets an aligned copy
+	if (!_pak->directory_buffer_ && (uintptr_t)directory % 8u != 0u)
+	{
+		_pak->directory_buffer_ = (char*)malloc(directory_size + 1ull);
+		memcpy(_pak->directory_buffer_, directory, directory_size);
+		directory = _pak->directory_buffer_;
+	}
+
+	_pak->directory_ = directory;
+
+	if (_pak->header_.dictionary_size_ > 0u)
+	{
+		_pak->dictionary_ = (char*)malloc(_pak->header_.dictionary_size_ + 1);
+		_pak->dictionary_[_pak->header_.dictionary_size_] = '\0';
+		memcpy(_pak->dictionary_, directory, _pak->header_.dictionary_size_);
+	}
+
+	// The block table is copied out, packing in update mode appends to it
+	uint32_t blocks_header[2];
+	memcpy(blocks_header, directory + _footer->blocks_offset_, sizeof(blocks_header));
+
+	uint32_t block_count = blocks_header[0];
+	if ((_footer->chunk_list_offset_ - _footer->blocks_offset_ - sizeof(blocks_header)) / sizeof(pak_block_t) < block_count)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	if (block_count > 0u)
+	{
+		_pak->blocks_ = (pak_block_t*)malloc(sizeof(pak_block_t) * block_count);
+		memcpy(_pak->blocks_, directory + _footer->blocks_offset_ + sizeof(blocks_header), sizeof(pak_block_t) * block_count);
+	}
+	_pak->block_count_ = block_count;
+
+	for (uint32_t idx = 0u; idx < block_count; ++idx)
+	{
+		if (_pak->blocks_[idx].offset_ + _pak->blocks_[idx].compressed_size_ > _footer->directory_offset_)
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+	}
+
+	uint32_t chunk_list_header[2];
+	memcpy(chunk_list_header, directory + _footer->chunk_list_offset_, sizeof(chunk_list_header));
+
+	uint32_t chunk_list_count = chunk_list_header[0];
+	if ((_footer->dictionaries_offset_ - _footer->chunk_list_offset_ - sizeof(chunk_list_header)) / sizeof(uint32_t) < chunk_list_count)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	if (chunk_list_count > 0u)
+	{
+		_pak->chunk_list_ = (uint32_t*)malloc(sizeof(uint32_t) * chunk_list_count);
+		memcpy(_pak->chunk_list_, directory + _footer->chunk_list_offset_ + sizeof(chunk_list_header), sizeof(uint32_t) * chunk_list_count);
+	}
+	_pak->chunk_list_count_ = chunk_list_count;
+
+	for (uint32_t idx = 0u; idx < chunk_list_count; ++idx)
+	{
+		if (_pak->chunk_list_[idx] >= block_count)
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+	}
+
+	pak_dictionary_table_t dictionary_table;
+	memcpy(&dictionary_table, directory + _footer->dictionaries_offset_, sizeof(pak_dictionary_table_t));
+
+	uint32_t dictionary_count = dictionary_table.dictionary_count_;
+	if (dictionary_table.flags_ & GPAK_DICTIONARY_TABLE_FLAG_SHARED)
+	{
+		// The dictionary file has to be registered before archives packed with it are opened
+		_pak->shared_dictionary_ = _gpak_shared_dictionary_acquire(dictionary_table.shared_id_);
+		if (!_pak->shared_dictionary_)
+			return _gpak_make_error(_pak, GPAK_ERROR_DICTIONARY_NOT_REGISTERED);
+
+		if (_pak->shared_dictionary_->dictionary_count_ != dictionary_count || _pak->header_.dictionary_size_ != 0u)
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		_pak->dictionary_ = _pak->shared_dictionary_->dictionary_;
+		_pak->dictionaries_ = _pak->shared_dictionary_->dictionaries_;
+		_pak->ddicts_ = _pak->shared_dictionary_->ddicts_;
+		_pak->dictionary_count_ = dictionary_count;
+	}
+	else
+	{
+		if (dictionary_count > GPAK_MAX_DICTIONARIES ||
+			(directory_size - _footer->dictionaries_offset_ - sizeof(pak_dictionary_table_t)) / sizeof(pak_dictionary_t) < dictionary_count)
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		_pak->dictionaries_ = (pak_dictionary_t*)calloc(dictionary_count + 1u, sizeof(pak_dictionary_t));
+		memcpy(_pak->dictionaries_, directory + _footer->dictionaries_offset_ + sizeof(pak_dictionary_table_t), sizeof(pak_dictionary_t) * dictionary_count);
+		_pak->dictionary_count_ = dictionary_count;
+
+		for (uint32_t idx = 0u; idx < dictionary_count; ++idx)
+		{
+			const pak_dictionary_t* dictionary = &_pak->dictionaries_[idx];
+			if (dictionary->size_ == 0u || dictionary->offset_ > _pak->header_.dictionary_size_ ||
+				dictionary->size_ > _pak->header_.dictionary_size_ - dictionary->offset_ ||
+				dictionary->class_[GPAK_DICTIONARY_CLASS_SIZE - 1u] != '\0')
+				return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+		}
+	}
+
+	for (uint32_t idx = 0u; idx < block_count; ++idx)
+	{
+		if (_pak->blocks_[idx].dictionary_id_ > dictionary_count)
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+	}
+
+	_pak->entries_ = (const pak_entry_t*)(directory + _footer->entries_offset_);
+
+	const uint32_t* name_offsets = (const uint32_t*)(_pak->entries_ + entry_count);
+	const char* names = directory + _footer->names_offset_;
+	uint64_t names_size = _footer->index_offset_ - _footer->names_offset_;
+
+	_pak->entry_paths_ = (const char**)malloc(sizeof(const char*) * (entry_count + 1u));
+	_pak->entry_files_ = (filesystem_tree_file_t**)calloc(entry_count + 1u, sizeof(filesystem_tree_file_t*));
+
+	for (uint32_t idx = 0u; idx < entry_count; ++idx)
+	{
+		if (name_offsets[idx] >= name_offsets[idx + 1u] || name_offsets[idx + 1u] > names_size || names[name_offsets[idx + 1u] - 1u] != '\0')
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		const pak_entry_t* entry = &_pak->entries_[idx];
+		if ((entry->flags_ & GPAK_ENTRY_FLAG_SOLID) && (entry->block_index_ >= block_count ||
+			entry->offset_ + entry->uncompressed_size_ > _pak->blocks_[entry->block_index_].uncompressed_size_))
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		if (entry->dictionary_id_ > dictionary_count)
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		if ((entry->flags_ & GPAK_ENTRY_FLAG_CHUNK_LIST) && (entry->block_index_ > chunk_list_count ||
+			entry->block_count_ > chunk_list_count - entry->block_index_))
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		// Plain and chunked payloads are read straight from the archive, they have to end before the directory
+		if (!(entry->flags_ & (GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_CHUNK_LIST)) && (entry->offset_ > _footer->directory_offset_ ||
+			entry->compressed_size_ > _footer->directory_offset_ - entry->offset_))
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+		_pak->entry_paths_[idx] = names + name_offsets[idx];
+		_pak->entry_files_[idx] = filesystem_tree_add_file(_pak->root_, _pak->entry_paths_[idx], NULL, _pak->entries_[idx]);
+	}
+
+	uint32_t index_header[2];
+	memcpy(index_header, directory + _footer->index_offset_, sizeof(index_header));
+
+	// The writer keeps at least half of the buckets free, so that lookups of missing paths stop early
+	uint32_t bucket_count = index_header[0];
+	if (bucket_count == 0u || (bucket_count & (bucket_count - 1u)) != 0u || bucket_count <= entry_count ||
+		(_footer->blocks_offset_ - _footer->index_offset_ - sizeof(index_header)) / sizeof(pak_index_bucket_t) < bucket_count)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+
+	const pak_index_bucket_t* buckets = (const pak_index_bucket_t*)(directory + _footer->index_offset_ + sizeof(index_header));
+	for (uint32_t idx = 0u; idx < bucket_count; ++idx)
+	{
+		if (buckets[idx].entry_ != UINT32_MAX && (buckets[idx].entry_ >= entry_count || !_pak->entry_files_[buckets[idx].entry_]))
+			return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DIRECTORY);
+	}
+
+	_pak->index_ = buckets;
+	_pak->index_mask_ = bucket_count - 1u;
+
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+filesystem_tree_file_t* _gpak_find_entry(gpak_t* _pak, const char* _path)
+{
+	if (!_pak->index_ || !_path)
+		return filesystem_tree_find_file(_pak->root_, _path);
+
+	uint64_t hash = _gpak_hash_path(_path);
+	uint32_t slot = (uint32_t)hash & _pak->index_mask_;
+	for (uint32_t probe = 0u; probe <= _pak->index_mask_; ++probe, slot = (slot + 1u) & _pak->index_mask_)
+	{
+		const pak_index_bucket_t* bucket = &_pak->index_[slot];
+		if (bucket->entry_ == UINT32_MAX)
+			break;
+
+		if (bucket->hash_ == hash && strcmp(_pak->entry_paths_[bucket->entry_], _path) == 0)
+			return _pak->entry_files_[bucket->entry_];
+	}
+
+	// The index only knows canonical paths read from disk, the tree also holds files added since and accepts redundant separators
+	if ((_pak->mode_ & (GPAK_MODE_CREATE | GPAK_MODE_UPDATE)) || _path[0] == '/' || strstr(_path, "//"))
+		return filesystem_tree_find_file(_pak->root_, _path);
+
+	return NULL;
+}
+
+//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+//-----------------------------IMPLEMENTATION-----------------------------
+//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+//-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_
+gpak_t* _gpak_open_image(gpak_t* _pak)
+{
+	_pak->mode_ |= GPAK_MODE_READ_ONLY;
+	_pak->root_ = filesystem_tree_create();
+
+	if (_gpak_read_at(_pak, 0ull, &_pak->header_, sizeof(pak_header_t)) != sizeof(pak_header_t) || _pak_validate_header(_pak) != GPAK_ERROR_OK ||
+		_gpak_parse_directory(_pak) != GPAK_ERROR_OK || _gpak_dictionaries_prepare(_pak, 0) != GPAK_ERROR_OK)
+	{
+		gpak_close(_pak);
+		return NULL;
+	}
+
+	return _pak;
+}
+
+gpak_t* gpak_open(const char* _path, int _mode)
+{
+	gpak_t* pak;
+	pak = (gpak_t*)calloc(1, sizeof(gpak_t));
+	pak->mode_ = _mode;
+	pak->current_file_ = NULL;
+	pak->error_handler_ = NULL;
+	pak->progress_handler_ = NULL;
+	pak->user_data_ = NULL;
+	pak->dictionary_ = NULL;
+	pak->block_cache_ = _gpak_block_cache_create();
+	pak->decoder_pool_ = _gpak_decoder_pool_create();
+	pak->entry_cache_ = _gpak_entry_cache_create(0ull);
+
+	// Mapped archives are read straight from the mapping, no stream is opened
+	if (_mode & GPAK_MODE_MEMORY_MAP)
+	{
+		pak->memory_ = _gpak_map_file(_path, &pak->memory_size_, &pak->memory_handle_);
+		pak->memory_mapped_ = pak->memory_ != NULL;
+		if (!pak->memory_)
+		{
+			gpak_close(pak);
+			return NULL;
+		}
+
+		return _gpak_open_image(pak);
+	}
+
+	const char* open_mode_;
+	if (_mode & GPAK_MODE_CREATE)
+		open_mode_ = "wb+";
+	else if (_mode & GPAK_MODE_READ_ONLY)
+		open_mode_ = "rb+";
+	else if (_mode & GPAK_MODE_UPDATE)
+		open_mode_ = "rb+";
+	else
+	{
+		gpak_close(pak);
+		return NULL;
+	}
+	
+	// Trying to open pak file
+	pak->stream_ = fopen(_path, open_mode_);
+
+	if (pak->stream_ == NULL)
+	{
+		gpak_close(pak);
+		return NULL;
+	}
+
+	pak->root_ = filesystem_tree_create();
+
+	if (_mode & GPAK_MODE_CREATE)
+	{
+		pak->header_ = _pak_make_header();
+		size_t res = _fwriteb(&pak->header_, sizeof(pak_header_t), 1ull, pak->stream_);
+		if (res != sizeof(pak_header_t))
+		{
+			gpak_close(pak);
+			return NULL;
+		}
+	}
+	else if (_mode & GPAK_MODE_UPDATE)
+	{
+		fseek(pak->stream_, 0, SEEK_SET);
+
+		size_t res = _freadb(&pak->header_, sizeof(pak_header_t), 1ull, pak->stream_);
+		if (_pak_validate_header(pak) != GPAK_ERROR_OK || res != sizeof(pak_header_t) || _gpak_parse_directory(pak) != GPAK_ERROR_OK ||
+			_gpak_dictionaries_prepare(pak, 1) != GPAK_ERROR_OK)
+		{
+			// Do not write anything back into an archive we failed to read
+			pak->mode_ = GPAK_MODE_NONE;
+			gpak_close(pak);
+			return NULL;
+		}
+
+		// New payloads overwrite the old directory, a new one is written on close
+		_gpak_fseek64(pak->stream_, (int64_t)pak->footer_.directory_offset_, SEEK_SET);
+	}
+	else if (_mode & GPAK_MODE_READ_ONLY)
+	{
+		size_t res = _freadb(&pak->header_, sizeof(pak_header_t), 1ull, pak->stream_);
+		if (_pak_validate_header(pak) != GPAK_ERROR_OK || res != sizeof(pak_header_t) || _gpak_parse_directory(pak) != GPAK_ERROR_OK ||
+			_gpak_dictionaries_prepare(pak, 0) != GPAK_ERROR_OK)
+		{
+			gpak_close(pak);
+			return NULL;
+		}
+	}
+
+	return pak;
+}
+
+gpak_t* gpak_open_memory(const void* _data, size_t _size)
+{
+	if (!_data)
+		return NULL;
+
+	gpak_t* pak = (gpak_t*)calloc(1, sizeof(gpak_t));
+	pak->block_cache_ = _gpak_block_cache_create();
+	pak->decoder_pool_ = _gpak_decoder_pool_create();
+	pak->entry_cache_ = _gpak_entry_cache_create(0ull);
+	pak->memory_ = (const char*)_data;
+	pak->memory_size_ = _size;
+
+	return _gpak_open_image(pak);
+}
+
+int gpak_close(gpak_t* _pak)
+{
+	if (_pak != NULL)
+	{
+		if (_pak->stream_ != NULL)
+		{
+			// Recalculate header
+
+			if ((_pak->mode_ & GPAK_MODE_CREATE) || (_pak->mode_ & GPAK_MODE_UPDATE))
+			{
+				if (_pak->mode_ & GPAK_MODE_CREATE)
+				{
+					// Archives packed with shared dictionaries do not train their own
+					if ((_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST) && !_pak->shared_dictionary_)
+						_gpak_compressor_generate_dictionary(_pak);
+
+					_gpak_dictionaries_prepare(_pak, 1);
+				}
+
+				_gpak_archivate_file_tree(_pak);
+				_gpak_write_directory(_pak);
+				int64_t archive_size = _gpak_ftell64(_pak->stream_);
+				_update_pak_header(_pak);
+
+				// An updated archive may have been longer than the new one
+				if ((_pak->mode_ & GPAK_MODE_UPDATE) && !_gpak_truncate(_pak->stream_, (uint64_t)archive_size))
+					_gpak_make_error(_pak, GPAK_ERROR_WRITE);
+			}
+
+			fclose(_pak->stream_);
+		}
+
+		filesystem_tree_delete(_pak->root_);
+
+		if (_pak->memory_mapped_)
+			_gpak_unmap_file(_pak->memory_, _pak->memory_size_, _pak->memory_handle_);
+		
+		_gpak_dictionaries_free(_pak);
+		free(_pak->dictionary_);
+		free(_pak->directory_buffer_);
+		free(_pak->entry_paths_);
+		free(_pak->entry_files_);
+		free(_pak->blocks_);
+		free(_pak->chunk_list_);
+		_gpak_block_cache_free(_pak->block_cache_);
+		_gpak_entry_cache_free(_pak->entry_cache_);
+		_gpak_thread_pool_free(_pak->thread_pool_);
+		_gpak_decoder_pool_free(_pak->decoder_pool_);
+		free(_pak);
+		return GPAK_ERROR_OK;
+	}
+	
+	return -1;
+}
+
+GPAK_API void gpak_set_user_data(gpak_t* _pak, void* _user_data)
+{
+	_pak->user_data_ = _user_data;
+}
+
+GPAK_API void gpak_set_error_handler(gpak_t* _pak, gpak_error_handler_t _error_handler)
+{
+	_pak->error_handler_ = _error_handler;
+}
+
+int gpak_get_last_error()
+{
+	return _gpak_last_error();
+}
+
+GPAK_API void gpak_set_process_handler(gpak_t* _pak, gpak_progress_handler_t _progress_handler)
+{
+	_pak->progress_handler_ = _progress_handler;
+}
+
+void gpak_set_compression_algorithm(gpak_t* _pak, int _algorithm)
+{
+	_pak->header_.compression_ = _algorithm;
+}
+
+void gpak_set_compression_level(gpak_t* _pak, int _level)
+{
+	_pak->header_.compression_level_ = _level;
+}
+
+void gpak_set_chunk_size(gpak_t* _pak, uint32_t _chunk_size)
+{
+	_pak->chunk_size_ = _chunk_size;
+}
+
+void gpak_set_solid_block_size(gpak_t* _pak, uint32_t _block_size)
+{
+	_pak->solid_block_size_ = _block_size;
+}
+
+void gpak_set_content_chunking(gpak_t* _pak, uint32_t _average_chunk_size)
+{
+	_pak->content_chunk_size_ = _average_chunk_size;
+}
+
+void gpak_set_stream_threshold(gpak_t* _pak, uint64_t _threshold)
+{
+	_pak->stream_threshold_ = _threshold;
+}
+
+void gpak_set_in_place_decoding(gpak_t* _pak, int _enabled)
+{
+	_pak->in_place_decoding_ = _enabled;
+}
+
+uint64_t gpak_get_in_place_size(gpak_t* _pak, const char* _path)
+{
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info)
+		return 0ull;
+
+	size_t capacity = _gpak_in_place_capacity(_pak, &_file_info->entry_);
+	return capacity > _file_info->entry_.uncompressed_size_ ? (uint64_t)capacity : _file_info->entry_.uncompressed_size_;
+}
+
+void gpak_set_entry_cache_budget(gpak_t* _pak, uint64_t _budget)
+{
+	_gpak_entry_cache_set_budget(_pak->entry_cache_, _budget);
+}
+
+void gpak_get_cache_stats(gpak_t* _pak, gpak_cache_stats_t* _stats)
+{
+	_gpak_entry_cache_stats(_pak->entry_cache_, _stats);
+}
+
+void gpak_set_dictionary_classifier(gpak_t* _pak, gpak_dictionary_classifier_t _classifier)
+{
+	_pak->dictionary_classifier_ = _classifier;
+}
+
+int gpak_set_alignment(gpak_t* _pak, uint32_t _alignment)
+{
+	// Payloads already stored in an updated archive keep the alignment they were written with
+	if (!(_pak->mode_ & GPAK_MODE_CREATE) || (_alignment & (_alignment - 1u)) != 0u)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_ALIGNMENT);
+
+	_pak->header_.alignment_ = _alignment;
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+int gpak_set_shared_dictionary(gpak_t* _pak, uint64_t _content_id)
+{
+	// Entries already stored in an updated archive keep the dictionaries they were compressed with
+	if (!(_pak->mode_ & GPAK_MODE_CREATE))
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DICTIONARY);
+
+	gpak_shared_dictionary_t* shared = _gpak_shared_dictionary_acquire(_content_id);
+	if (!shared)
+		return _gpak_make_error(_pak, GPAK_ERROR_DICTIONARY_NOT_REGISTERED);
+
+	_gpak_dictionaries_free(_pak);
+
+	_pak->shared_dictionary_ = shared;
+	_pak->dictionary_ = shared->dictionary_;
+	_pak->dictionaries_ = shared->dictionaries_;
+	_pak->ddicts_ = shared->ddicts_;
+	_pak->dictionary_count_ = shared->dictionary_count_;
+
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+int gpak_save_dictionary(gpak_t* _pak, const char* _path)
+{
+	if (_pak->dictionary_count_ == 0u)
+		return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DICTIONARY);
+
+	uint32_t dictionary_size = _pak->shared_dictionary_ ? _pak->shared_dictionary_->dictionary_size_ : _pak->header_.dictionary_size_;
+
+	pak_dictionary_file_header_t header;
+	memset(&header, 0, sizeof(pak_dictionary_file_header_t));
+	strcpy(header.format_, "gpakdct");
+	header.version_ = GPAK_DICTIONARY_FORMAT_VERSION;
+	header.dictionary_count_ = _pak->dictionary_count_;
+	header.dictionary_size_ = dictionary_size;
+	header.content_id_ = _gpak_dictionary_content_id(_pak->dictionaries_, _pak->dictionary_count_, _pak->dictionary_, dictionary_size);
+
+	FILE* outfile = fopen(_path, "wb");
+	if (!outfile)
+		return _gpak_make_error(_pak, GPAK_ERROR_OPEN_FILE);
+
+	size_t expected = sizeof(pak_dictionary_file_header_t) + sizeof(pak_dictionary_t) * _pak->dictionary_count_ + dictionary_size;
+	size_t written = _fwriteb(&header, sizeof(pak_dictionary_file_header_t), 1ull, outfile);
+	written += _fwriteb(_pak->dictionaries_, sizeof(pak_dictionary_t), _pak->dictionary_count_, outfile);
+	written += _fwriteb(_pak->dictionary_, 1ull, dictionary_size, outfile);
+
+	fclose(outfile);
+
+	return _gpak_make_error(_pak, written == expected ? GPAK_ERROR_OK : GPAK_ERROR_WRITE);
+}
+
+int gpak_register_dictionary(const char* _path, uint64_t* _content_id)
+{
+	FILE* infile = fopen(_path, "rb");
+	if (!infile)
+		return GPAK_ERROR_OPEN_FILE;
+
+	pak_dictionary_file_header_t header;
+	if (_freadb(&header, sizeof(pak_dictionary_file_header_t), 1ull, infile) != sizeof(pak_dictionary_file_header_t) ||
+		strncmp(header.format_, "gpakdct", sizeof(header.format_)) != 0 || header.version_ != GPAK_DICTIONARY_FORMAT_VERSION ||
+		header.dictionary_count_ == 0u || header.dictionary_count_ > GPAK_MAX_DICTIONARIES)
+	{
+		fclose(infile);
+		return GPAK_ERROR_INVALID_DICTIONARY;
+	}
+
+	pak_dictionary_t* dictionaries = (pak_dictionary_t*)malloc(sizeof(pak_dictionary_t) * header.dictionary_count_);
+	char* dictionary = (char*)malloc(header.dictionary_size_ + 1ull);
+
+	size_t readed = _freadb(dictionaries, sizeof(pak_dictionary_t), header.dictionary_count_, infile);
+	readed += _freadb(dictionary, 1ull, header.dictionary_size_, infile);
+	fclose(infile);
+
+	int valid = readed == sizeof(pak_dictionary_t) * header.dictionary_count_ + header.dictionary_size_ &&
+		_gpak_dictionary_content_id(dictionaries, header.dictionary_count_, dictionary, header.dictionary_size_) == header.content_id_;
+
+	for (uint32_t idx = 0u; valid && idx < header.dictionary_count_; ++idx)
+	{
+		valid = dictionaries[idx].size_ > 0u && dictionaries[idx].offset_ <= header.dictionary_size_ &&
+			dictionaries[idx].size_ <= header.dictionary_size_ - dictionaries[idx].offset_ &&
+			dictionaries[idx].class_[GPAK_DICTIONARY_CLASS_SIZE - 1u] == '\0';
+	}
+
+	if (!valid)
+	{
+		free(dictionaries);
+		free(dictionary);
+		return GPAK_ERROR_INVALID_DICTIONARY;
+	}
+
+	if (!_gpak_shared_dictionary_register(dictionary, header.dictionary_size_, dictionaries, header.dictionary_count_, header.content_id_))
+		return GPAK_ERROR_INVALID_DICTIONARY;
+
+	if (_content_id)
+		*_content_id = header.content_id_;
+
+	return GPAK_ERROR_OK;
+}
+
+int gpak_unregister_dictionary(uint64_t _content_id)
+{
+	return _gpak_shared_dictionary_unregister(_content_id);
+}
+
+int gpak_add_directory(gpak_t* _pak, const char* _internal_path)
+{
+	filesystem_tree_add_directory(_pak->root_, _internal_path);
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+int gpak_add_file(gpak_t* _pak, const char* _external_path, const char* _internal_path)
+{
+	pak_entry_t _entry;
+	_entry.compressed_size_ = 0u;
+	_entry.uncompressed_size_ = 0u;
+	_entry.offset_ = 0u;
+	_entry.crc32_ = 0;
+	_entry.flags_ = 0u;
+	_entry.block_index_ = 0u;
+	_entry.block_count_ = 0u;
+	_entry.dictionary_id_ = 0u;
+	_entry.reserved_ = 0u;
+
+	++_pak->header_.entry_count_;
+
+	filesystem_tree_add_file(_pak->root_, _internal_path, _external_path, _entry);
+	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+struct filesystem_tree_node* gpak_get_root(gpak_t* _pak)
+{
+	return _pak->root_;
+}
+
+filesystem_tree_node_t* gpak_find_directory(gpak_t* _pak, const char* _path)
+{
+	if (_pak == NULL)
+		return NULL;
+
+	return filesystem_tree_find_directory(_pak->root_, _path);
+}
+
+filesystem_tree_file_t* gpak_find_file(gpak_t* _pak, const char* _path)
+{
+	if (_pak == NULL)
+		return NULL;
+
+	return _gpak_find_entry(_pak, _path);
+}
+
+gpak_file_t* _gpak_fopen_chunked(gpak_t* _pak, filesystem_tree_file_t* _file_info)
+{
+	gpak_file_t* mfile = (gpak_file_t*)calloc(1, sizeof(gpak_file_t));
+	mfile->pak_ = _pak;
+	mfile->entry_ = _file_info->entry_;
+	mfile->crc32_ = _file_info->entry_.crc32_;
+	mfile->chunk_index_ = UINT32_MAX;
+
+	// Decoding whole chunks straight into the caller buffer lets a large read use all workers
+	mfile->chunk_batch_ = 4u * (_gpak_hardware_concurrency() + 1u);
+
+	// Only the seek table is read here, chunks are decoded as they are reached
+	size_t readed = _gpak_read_at(_pak, mfile->entry_.offset_, &mfile->chunk_table_, sizeof(pak_chunk_table_t));
+	if (readed != sizeof(pak_chunk_table_t) || mfile->chunk_table_.chunk_size_ == 0u ||
+		(mfile->entry_.uncompressed_size_ + mfile->chunk_table_.chunk_size_ - 1ull) / mfile->chunk_table_.chunk_size_ != mfile->chunk_table_.chunk_count_)
+	{
+		_gpak_make_error(_pak, GPAK_ERROR_READ);
+		gpak_fclose(mfile);
+		return NULL;
+	}
+
+	mfile->chunks_ = (pak_chunk_t*)malloc(sizeof(pak_chunk_t) * (mfile->chunk_table_.chunk_count_ + 1u));
+	readed = _gpak_read_at(_pak, mfile->entry_.offset_ + sizeof(pak_chunk_table_t), mfile->chunks_, sizeof(pak_chunk_t) * mfile->chunk_table_.chunk_count_);
+	if (readed != sizeof(pak_chunk_t) * mfile->chunk_table_.chunk_count_)
+	{
+		_gpak_make_error(_pak, GPAK_ERROR_READ);
+		gpak_fclose(mfile);
+		return NULL;
+	}
+
+	for (uint32_t idx = 0u; idx < mfile->chunk_table_.chunk_count_; ++idx)
+	{
+		if (mfile->chunks_[idx].offset_ + mfile->chunks_[idx].compressed_size_ > mfile->entry_.compressed_size_)
+		{
+			_gpak_make_error(_pak, GPAK_ERROR_READ);
+			gpak_fclose(mfile);
+			return NULL;
+		}
+	}
+
+	mfile->data_ = (char*)malloc(mfile->chunk_table_.chunk_size_ + 1ull);
+
+	return mfile;
+}
+
+size_t _gpak_chunk_uncompressed_size(gpak_file_t* _file, uint32_t _chunk)
+{
+	uint64_t chunk_begin = (uint64_t)_chunk * _file->chunk_table_.chunk_size_;
+	uint64_t chunk_end = chunk_begin + _file->chunk_table_.chunk_size_;
+	if (chunk_end > _file->entry_.uncompressed_size_)
+		chunk_end = _file->entry_.uncompressed_size_;
+
+	return (size_t)(chunk_end - chunk_begin);
+}
+
+struct gpak_chunk_batch
+{
+	gpak_file_t* file_;
+	const char* compressed_;
+	char* destination_;
+	uint32_t first_chunk_;
+	gpak_mutex_t mutex_;
+	uint32_t failed_chunk_;
+};
+
+void _gpak_decode_chunk_job(void* _arg, size_t _index)
+{
+	struct gpak_chunk_batch* batch = (struct gpak_chunk_batch*)_arg;
+	gpak_file_t* file = batch->file_;
+
+	uint32_t chunk_index = batch->first_chunk_ + (uint32_t)_index;
+	const pak_chunk_t* chunk = &file->chunks_[chunk_index];
+	const char* source = batch->compressed_ + (chunk->offset_ - file->chunks_[batch->first_chunk_].offset_);
+	char* destination = batch->destination_ + _index * file->chunk_table_.chunk_size_;
+	size_t chunk_size = _gpak_chunk_uncompressed_size(file, chunk_index);
+
+	size_t decoded = _gpak_decompress_chunk(file->pak_, source, chunk->compressed_size_, destination, chunk_size, file->entry_.dictionary_id_);
+	if (decoded != chunk_size || crc32(crc32(0L, Z_NULL, 0), (const Bytef*)destination, (uInt)chunk_size) != chunk->crc32_)
+	{
+		// Several chunks may fail at once, the first one in the file is reported
+		_gpak_mutex_lock(&batch->mutex_);
+		if (chunk_index < batch->failed_chunk_)
+			batch->failed_chunk_ = chunk_index;
+		_gpak_mutex_unlock(&batch->mutex_);
+	}
+}
+
+int _gpak_decode_chunks(gpak_file_t* _file, uint32_t _first_chunk, uint32_t _chunk_count, char* _destination)
+{
+	gpak_t* pak = _file->pak_;
+	const pak_chunk_t* first = &_file->chunks_[_first_chunk];
+	const pak_chunk_t* last = &_file->chunks_[_first_chunk + _chunk_count - 1u];
+
+	// Chunks are stored back to back, so a run of them is fetched with a single read
+	size_t compressed_size = (size_t)(last->offset_ + last->compressed_size_ - first->offset_);
+
+	char* buffer = NULL;
+	const char* compressed = _gpak_read_view(pak, _file->entry_.offset_ + first->offset_, compressed_size, &buffer);
+	if (!compressed)
+		return _gpak_make_error(pak, GPAK_ERROR_READ);
+
+	struct gpak_chunk_batch batch;
+	batch.file_ = _file;
+	batch.compressed_ = compressed;
+	batch.destination_ = _destination;
+	batch.first_chunk_ = _first_chunk;
+	batch.failed_chunk_ = UINT32_MAX;
+	_gpak_mutex_init(&batch.mutex_);
+
+	_gpak_thread_pool_parallel_for(_chunk_count > 1u ? _gpak_get_thread_pool(pak) : NULL, _chunk_count, &_gpak_decode_chunk_job, &batch);
+
+	_gpak_mutex_destroy(&batch.mutex_);
+	free(buffer);
+
+	if (batch.failed_chunk_ != UINT32_MAX)
+	{
+		// The error is reported against the file path followed by the index of the damaged chunk
+		const char* thread_path = _gpak_get_thread_path();
+		const char* file_path = thread_path ? thread_path : pak->current_file_;
+		size_t length = (file_path ? strlen(file_path) : 0ull) + 24ull;
+		char* chunk_path = (char*)malloc(length);
+		snprintf(chunk_path, length, "%s#%u", file_path ? file_path : "", batch.failed_chunk_);
+
+		_gpak_set_thread_path(chunk_path);
+		_gpak_make_error(pak, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+		_gpak_set_thread_path(thread_path);
+		free(chunk_path);
+
+		return GPAK_ERROR_FILE_CRC_NOT_MATCH;
+	}
+
+	return GPAK_ERROR_OK;
+}
+
+int _gpak_file_load_chunk(gpak_file_t* _file, uint32_t _chunk)
+{
+	if (_file->chunk_index_ == _chunk)
+		return GPAK_ERROR_OK;
+
+	_file->chunk_index_ = UINT32_MAX;
+
+	int result = _gpak_decode_chunks(_file, _chunk, 1u, _file->data_);
+	if (result == GPAK_ERROR_OK)
+		_file->chunk_index_ = _chunk;
+
+	return result;
+}
+
+size_t _gpak_fread_chunked(void* _buffer, size_t _size, gpak_file_t* _file)
+{
+	char* destination = (char*)_buffer;
+	size_t total_readed = 0ull;
+	uint32_t chunk_size = _file->chunk_table_.chunk_size_;
+
+	uint64_t available = _file->position_ < _file->entry_.uncompressed_size_ ? _file->entry_.uncompressed_size_ - _file->position_ : 0ull;
+	if (_size > available)
+	{
+		_size = (size_t)available;
+		_file->eof_ = 1;
+	}
+
+	while (total_readed < _size)
+	{
+		uint32_t chunk = (uint32_t)(_file->position_ / chunk_size);
+		size_t chunk_offset = (size_t)(_file->position_ % chunk_size);
+		size_t remaining = _size - total_readed;
+
+		uint32_t whole_chunks = 0u;
+		if (chunk_offset == 0ull)
+		{
+			while (chunk + whole_chunks < _file->chunk_table_.chunk_count_ && whole_chunks < _file->chunk_batch_ &&
+				_gpak_chunk_uncompressed_size(_file, chunk + whole_chunks) <= remaining - (size_t)whole_chunks * chunk_size)
+				++whole_chunks;
+		}
+
+		if (whole_chunks > 1u)
+		{
+			if (_gpak_decode_chunks(_file, chunk, whole_chunks, destination + total_readed) != GPAK_ERROR_OK)
+				break;
+
+			size_t decoded = (size_t)whole_chunks * chunk_size;
+			if (decoded > remaining)
+				decoded = remaining;
+
+			total_readed += decoded;
+			_file->position_ += decoded;
+			continue;
+		}
+
+		if (_gpak_file_load_chunk(_file, chunk) != GPAK_ERROR_OK)
+			break;
+
+		size_t to_copy = _gpak_chunk_uncompressed_size(_file, chunk) - chunk_offset;
+		if (to_copy > remaining)
+			to_copy = remaining;
+
+		memcpy(destination + total_readed, _file->data_ + chunk_offset, to_copy);
+		total_readed += to_copy;
+		_file->position_ += to_copy;
+	}
+
+	return total_readed;
+}
+
+struct gpak_stream_reader
+{
+	gpak_t* pak_;
+	gpak_decoder_t* decoder_;
+	uint64_t payload_offset_;
+	uint64_t compressed_size_;
+	uint64_t uncompressed_size_;
+	uint32_t expected_crc32_;
+	uint64_t consumed_;
+	const char* input_;
+	char* input_buffer_;
+	size_t input_size_;
+	size_t input_pos_;
+	char* slots_[2];
+	size_t slot_sizes_[2];
+	int ready_[2];
+	uint32_t current_;
+	uint32_t filling_;
+	uint64_t window_begin_;
+	uint64_t produced_;
+	uint32_t crc32_;
+	int finished_;
+	int failed_;
+	int crc_failed_;
+	int reported_;
+	int pending_;
+	gpak_mutex_t mutex_;
+	gpak_cond_t cond_;
+};
+
+// Makes the next compressed bytes available, from the archive image or with a positional read
+int _gpak_stream_refill(struct gpak_stream_reader* _reader)
+{
+	size_t size = (size_t)(_reader->compressed_size_ - _reader->consumed_);
+	if (size > GPAK_STREAM_INPUT_SIZE)
+		size = GPAK_STREAM_INPUT_SIZE;
+
+	if (_reader->pak_->memory_)
+	{
+		uint64_t offset = _reader->payload_offset_ + _reader->consumed_;
+		if (offset > _reader->pak_->memory_size_ || size > _reader->pak_->memory_size_ - offset)
+			return GPAK_ERROR_READ;
+
+		_reader->input_ = _reader->pak_->memory_ + offset;
+	}
+	else if (_gpak_read_at(_reader->pak_, _reader->payload_offset_ + _reader->consumed_, _reader->input_buffer_, size) != size)
+		return GPAK_ERROR_READ;
+
+	_reader->consumed_ += size;
+	_reader->input_size_ = size;
+	_reader->input_pos_ = 0ull;
+	return GPAK_ERROR_OK;
+}
+
+void _gpak_stream_fill_job(void* _arg)
+{
+	struct gpak_stream_reader* reader = (struct gpak_stream_reader*)_arg;
+	char* slot = reader->slots_[reader->filling_];
+	size_t produced = 0ull;
+	int error = GPAK_ERROR_OK;
+
+	// The decoder context is only ever used by one job at a time, in payload order
+	while (produced < GPAK_STREAM_SLOT_SIZE && !reader->finished_)
+	{
+		if (reader->input_pos_ == reader->input_size_ && reader->consumed_ < reader->compressed_size_)
+		{
+			error = _gpak_stream_refill(reader);
+			if (error != GPAK_ERROR_OK)
+				break;
+		}
+
+		size_t input_used = 0ull, output_used = 0ull;
+		int status = _gpak_decoder_run(reader->decoder_, reader->input_ + reader->input_pos_, reader->input_size_ - reader->input_pos_, &input_used,
+			slot + produced, GPAK_STREAM_SLOT_SIZE - produced, &output_used);
+		if (status < 0)
+		{
+			error = status;
+			break;
+		}
+
+		reader->input_pos_ += input_used;
+		produced += output_used;
+
+		int input_exhausted = reader->input_pos_ == reader->input_size_ && reader->consumed_ == reader->compressed_size_;
+		if (input_exhausted && status == 1)
+			reader->finished_ = 1;
+		else if (input_exhausted && input_used == 0ull && output_used == 0ull)
+		{
+			// A payload ending right at a slot boundary has nothing left to drain
+			if (reader->produced_ + produced == reader->uncompressed_size_)
+				reader->finished_ = 1;
+			else
+				error = GPAK_ERROR_EOF_BEFORE_EOS;
+			break;
+		}
+	}
+
+	// The checksum is accumulated slot by slot and settled once the payload ends
+	reader->crc32_ = crc32(reader->crc32_, (const Bytef*)slot, (uInt)produced);
+	reader->produced_ += produced;
+	if (reader->finished_ && (reader->produced_ != reader->uncompressed_size_ || reader->crc32_ != reader->expected_crc32_))
+		reader->crc_failed_ = 1;
+
+	_gpak_mutex_lock(&reader->mutex_);
+	reader->slot_sizes_[reader->filling_] = produced;
+	reader->ready_[reader->filling_] = 1;
+	if (error != GPAK_ERROR_OK)
+		reader->failed_ = error;
+	reader->pending_ = 0;
+	_gpak_cond_broadcast(&reader->cond_);
+	_gpak_mutex_unlock(&reader->mutex_);
+}
+
+// Expects the reader mutex to be held and no job in flight
+void _gpak_stream_submit(struct gpak_stream_reader* _reader, uint32_t _slot)
+{
+	_reader->ready_[_slot] = 0;
+	_reader->filling_ = _slot;
+	_reader->pending_ = 1;
+	if (_reader->pak_->thread_pool_)
+		_gpak_thread_pool_submit(_reader->pak_->thread_pool_, &_gpak_stream_fill_job, _reader);
+	else
+	{
+		// Without a pool the slot is decoded right here, the job takes the reader mutex itself
+		_gpak_mutex_unlock(&_reader->mutex_);
+		_gpak_stream_fill_job(_reader);
+		_gpak_mutex_lock(&_reader->mutex_);
+	}
+}
+
+// Expects the reader mutex to be held
+void _gpak_stream_wait(struct gpak_stream_reader* _reader)
+{
+	while (_reader->pending_)
+		_gpak_cond_wait(&_reader->cond_, &_reader->mutex_);
+}
+
+// Expects the reader mutex to be held, starts decoding the payload from its beginning
+int _gpak_stream_restart(struct gpak_stream_reader* _reader)
+{
+	_gpak_stream_wait(_reader);
+
+	_reader->consumed_ = 0ull;
+	_reader->input_ = _reader->input_buffer_;
+	_reader->input_size_ = 0ull;
+	_reader->input_pos_ = 0ull;
+	_reader->ready_[0] = _reader->ready_[1] = 0;
+	_reader->slot_sizes_[0] = _reader->slot_sizes_[1] = 0ull;
+	_reader->current_ = 0u;
+	_reader->window_begin_ = 0ull;
+	_reader->produced_ = 0ull;
+	_reader->crc32_ = crc32(0L, Z_NULL, 0);
+	_reader->finished_ = 0;
+	_reader->failed_ = _gpak_decoder_reset(_reader->decoder_);
+	_reader->crc_failed_ = 0;
+
+	if (_reader->failed_ == GPAK_ERROR_OK)
+		_gpak_stream_submit(_reader, 0u);
+
+	return _reader->failed_;
+}
+
+gpak_file_t* _gpak_fopen_streamed(gpak_t* _pak, filesystem_tree_file_t* _file_info)
+{
+	_gpak_get_thread_pool(_pak);
+
+	struct gpak_stream_reader* reader = (struct gpak_stream_reader*)calloc(1, sizeof(struct gpak_stream_reader));
+	reader->pak_ = _pak;
+	reader->payload_offset_ = _file_info->entry_.offset_;
+	reader->compressed_size_ = _file_info->entry_.compressed_size_;
+	reader->uncompressed_size_ = _file_info->entry_.uncompressed_size_;
+	reader->expected_crc32_ = _file_info->entry_.crc32_;
+	reader->decoder_ = _gpak_decoder_create(_pak, _file_info->entry_.dictionary_id_);
+	reader->slots_[0] = (char*)malloc(GPAK_STREAM_SLOT_SIZE);
+	reader->slots_[1] = (char*)malloc(GPAK_STREAM_SLOT_SIZE);
+	_gpak_mutex_init(&reader->mutex_);
+	_gpak_cond_init(&reader->cond_);
+
+	if (!_pak->memory_)
+		reader->input_buffer_ = (char*)malloc(GPAK_STREAM_INPUT_SIZE);
+
+	gpak_file_t* mfile = (gpak_file_t*)calloc(1, sizeof(gpak_file_t));
+	mfile->pak_ = _pak;
+	mfile->entry_ = _file_info->entry_;
+	mfile->crc32_ = _file_info->entry_.crc32_;
+	mfile->reader_ = reader;
+
+	if (!reader->decoder_)
+	{
+		_gpak_make_error(_pak, GPAK_ERROR_READ);
+		gpak_fclose(mfile);
+		return NULL;
+	}
+
+	// The first slot is decoded while the caller gets ready to read
+	_gpak_mutex_lock(&reader->mutex_);
+	int result = _gpak_stream_restart(reader);
+	_gpak_mutex_unlock(&reader->mutex_);
+
+	if (result != GPAK_ERROR_OK)
+	{
+		_gpak_make_error(_pak, result);
+		gpak_fclose(mfile);
+		return NULL;
+	}
+
+	return mfile;
+}
+
+void _gpak_stream_free(struct gpak_stream_reader* _reader)
+{
+	_gpak_mutex_lock(&_reader->mutex_);
+	_gpak_stream_wait(_reader);
+	_gpak_mutex_unlock(&_reader->mutex_);
+
+	_gpak_mutex_destroy(&_reader->mutex_);
+	_gpak_cond_destroy(&_reader->cond_);
+
+	_gpak_decoder_free(_reader->decoder_);
+	free(_reader->input_buffer_);
+	free(_reader->slots_[0]);
+	free(_reader->slots_[1]);
+	free(_reader);
+}
+
+// Moves the window of decoded data over the read position of the file
+int _gpak_stream_acquire(gpak_file_t* _file)
+{
+	struct gpak_stream_reader* reader = _file->reader_;
+	int result = GPAK_ERROR_OK;
+
+	_gpak_mutex_lock(&reader->mutex_);
+
+	// Seeking backwards decodes the payload again from its start
+	if (_file->position_ < reader->window_begin_)
+		result = _gpak_stream_restart(reader);
+
+	while (result == GPAK_ERROR_OK)
+	{
+		uint32_t current = reader->current_;
+		uint32_t next = current ^ 1u;
+
+		while (reader->pending_ && reader->filling_ == current)
+			_gpak_cond_wait(&reader->cond_, &reader->mutex_);
+
+		if (!reader->ready_[current])
+		{
+			result = reader->failed_ != GPAK_ERROR_OK ? reader->failed_ : GPAK_ERROR_READ;
+			break;
+		}
+
+		uint64_t window_end = reader->window_begin_ + reader->slot_sizes_[current];
+		if (_file->position_ < window_end)
+		{
+			// The next slot is decoded while this one is read
+			if (!reader->pending_ && !reader->ready_[next] && !reader->finished_ && reader->failed_ == GPAK_ERROR_OK)
+				_gpak_stream_submit(reader, next);
+			break;
+		}
+
+		if (!reader->ready_[next] && !reader->pending_)
+		{
+			if (reader->finished_ || reader->failed_ != GPAK_ERROR_OK)
+			{
+				result = reader->failed_ != GPAK_ERROR_OK ? reader->failed_ : GPAK_ERROR_EOF_BEFORE_EOS;
+				break;
+			}
+
+			_gpak_stream_submit(reader, next);
+		}
+
+		reader->ready_[current] = 0;
+		reader->window_begin_ = window_end;
+		reader->current_ = next;
+	}
+
+	_gpak_mutex_unlock(&reader->mutex_);
+	return result;
+}
+
+size_t _gpak_fread_streamed(void* _buffer, size_t _size, gpak_file_t* _file)
+{
+	struct gpak_stream_reader* reader = _file->reader_;
+	char* destination = (char*)_buffer;
+	size_t total_readed = 0ull;
+
+	uint64_t available = _file->entry_.uncompressed_size_ - (_file->position_ < _file->entry_.uncompressed_size_ ? _file->position_ : _file->entry_.uncompressed_size_);
+	if (_size > available)
+	{
+		_size = (size_t)available;
+		_file->eof_ = 1;
+	}
+
+	while (total_readed < _size)
+	{
+		int result = _gpak_stream_acquire(_file);
+		if (result != GPAK_ERROR_OK)
+		{
+			_gpak_make_error(_file->pak_, result);
+			_file->eof_ = 1;
+			break;
+		}
+
+		// The current slot belongs to the reader until it moves past it
+		size_t window_offset = (size_t)(_file->position_ - reader->window_begin_);
+		size_t to_copy = reader->slot_sizes_[reader->current_] - window_offset;
+		if (to_copy > _size - total_readed)
+			to_copy = _size - total_readed;
+
+		memcpy(destination + total_readed, reader->slots_[reader->current_] + window_offset, to_copy);
+		total_readed += to_copy;
+		_file->position_ += to_copy;
+	}
+
+	// Damage is only known once the whole payload went through the checksum
+	if (_file->position_ == _file->entry_.uncompressed_size_ && !reader->reported_)
+	{
+		_gpak_mutex_lock(&reader->mutex_);
+		_gpak_stream_wait(reader);
+		int crc_failed = reader->finished_ && reader->crc_failed_;
+		_gpak_mutex_unlock(&reader->mutex_);
+
+		if (crc_failed)
+		{
+			reader->reported_ = 1;
+			_gpak_make_error(_file->pak_, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+		}
+	}
+
+	return total_readed;
+}
+
+// Copies from a cached block or payload under the cache lock, another reader could evict it right after
+int _gpak_cache_copy(gpak_t* _pak, uint64_t _offset, size_t _begin, void* _dst, size_t _size)
+{
+	struct gpak_block_cache* cache = _pak->block_cache_;
+	int found = 0;
+
+	_gpak_mutex_lock(&cache->mutex_);
+	++cache->clock_;
+	for (uint32_t idx = 0u; idx < GPAK_BLOCK_CACHE_SIZE; ++idx)
+	{
+		gpak_block_cache_entry_t* cached = &cache->entries_[idx];
+		if (cached->data_ && cached->offset_ == _offset)
+		{
+			cached->last_used_ = cache->clock_;
+			memcpy(_dst, cached->data_ + _begin, _size);
+			found = 1;
+			break;
+		}
+	}
+	_gpak_mutex_unlock(&cache->mutex_);
+
+	return found;
+}
+
+void _gpak_cache_insert(gpak_t* _pak, uint64_t _offset, char* _data)
+{
+	struct gpak_block_cache* cache = _pak->block_cache_;
+
+	_gpak_mutex_lock(&cache->mutex_);
+
+	// Reuse an empty slot, otherwise the least recently used one
+	gpak_block_cache_entry_t* slot = &cache->entries_[0];
+	for (uint32_t idx = 0u; idx < GPAK_BLOCK_CACHE_SIZE; ++idx)
+	{
+		gpak_block_cache_entry_t* cached = &cache->entries_[idx];
+
+		// Another reader decoded the same data in the meantime
+		if (cached->data_ && cached->offset_ == _offset)
+		{
+			slot = NULL;
+			break;
+		}
+
+		if (slot->data_ && (!cached->data_ || cached->last_used_ < slot->last_used_))
+			slot = cached;
+	}
+
+	if (slot)
+	{
+		free(slot->data_);
+		slot->offset_ = _offset;
+		slot->data_ = _data;
+		slot->last_used_ = cache->clock_;
+	}
+	else
+		free(_data);
+
+	_gpak_mutex_unlock(&cache->mutex_);
+}
+
+int _gpak_read_block(gpak_t* _pak, uint32_t _block_index, size_t _begin, void* _dst, size_t _size)
+{
+	const pak_block_t* block = &_pak->blocks_[_block_index];
+
+	if (_gpak_cache_copy(_pak, block->offset_, _begin, _dst, _size))
+		return GPAK_ERROR_OK;
+
+	// Blocks are decoded outside of the cache lock, so readers of different blocks do not wait for each other
+	char* data = (char*)malloc(block->uncompressed_size_ + 1ull);
+	int result = _gpak_decode_at(_pak, block->offset_, block->compressed_size_, data, block->uncompressed_size_, block->dictionary_id_, 1);
+	if (result == GPAK_ERROR_OK && crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data, block->uncompressed_size_) != block->crc32_)
+		result = GPAK_ERROR_FILE_CRC_NOT_MATCH;
+
+	if (result != GPAK_ERROR_OK)
+	{
+		free(data);
+		return _gpak_make_error(_pak, result);
+	}
+
+	memcpy(_dst, data + _begin, _size);
+	_gpak_cache_insert(_pak, block->offset_, data);
+
+	return GPAK_ERROR_OK;
+}
+
+gpak_file_t* gpak_fopen(gpak_t* _pak, const char* _path)
+{
+	// Errors are reported against the requested path, no need to rebuild it from the tree
+	_gpak_set_thread_path(_path);
+
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info)
+	{
+		_gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
+		_gpak_set_thread_path(NULL);
+		return NULL;
+	}
+
+	// Hot entries are shared with the handles already opened on them
+	gpak_cached_entry_t* cached_entry = _gpak_entry_cache_acquire(_pak->entry_cache_, _file_info);
+	if (cached_entry)
+	{
+		gpak_file_t* cached_file = (gpak_file_t*)calloc(1, sizeof(gpak_file_t));
+		cached_file->pak_ = _pak;
+		cached_file->entry_ = _file_info->entry_;
+		cached_file->crc32_ = _file_info->entry_.crc32_;
+		cached_file->cached_ = cached_entry;
+		cached_file->data_ = _gpak_cached_entry_data(cached_entry);
+		_gpak_set_thread_path(NULL);
+		return cached_file;
+	}
+
+	if (_file_info->entry_.flags_ & GPAK_ENTRY_FLAG_CHUNKED)
+	{
+		gpak_file_t* chunked_file = _gpak_fopen_chunked(_pak, _file_info);
+		_gpak_set_thread_path(NULL);
+		return chunked_file;
+	}
+
+	// Large plain entries are decoded through a bounded window instead of as a whole
+	if (_pak->stream_threshold_ > 0ull && _file_info->entry_.uncompressed_size_ >= _pak->stream_threshold_ &&
+		!(_file_info->entry_.flags_ & (GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_CHUNK_LIST)))
+	{
+		gpak_file_t* streamed_file = _gpak_fopen_streamed(_pak, _file_info);
+		_gpak_set_thread_path(NULL);
+		return streamed_file;
+	}
+
+	size_t uncompressed_size = (size_t)_file_info->entry_.uncompressed_size_;
+	size_t compressed_size = (size_t)_file_info->entry_.compressed_size_;
+
+	// Plain payloads decoded in place are read into the tail of the buffer
+	size_t capacity = _gpak_in_place_capacity(_pak, &_file_info->entry_);
+
+	gpak_file_t* mfile = (gpak_file_t*)calloc(1, sizeof(gpak_file_t));
+	mfile->pak_ = _pak;
+	mfile->entry_ = _file_info->entry_;
+	mfile->data_ = (char*)malloc((capacity > uncompressed_size ? capacity : uncompressed_size) + 1);
+	mfile->data_[uncompressed_size] = '\0';
+	int from_block_cache = 0;
+
+	// Files packed in a solid block are sliced out of the decoded block
+	if (_file_info->entry_.flags_ & GPAK_ENTRY_FLAG_SOLID)
+	{
+		if (_gpak_read_block(_pak, _file_info->entry_.block_index_, (size_t)_file_info->entry_.offset_, mfile->data_, uncompressed_size) != GPAK_ERROR_OK)
+		{
+			_gpak_set_thread_path(NULL);
+			gpak_fclose(mfile);
+			return NULL;
+		}
+
+		mfile->crc32_ = _gpak_crc32_bytes(mfile->data_, uncompressed_size);
+	}
+	else if (_file_info->entry_.flags_ & GPAK_ENTRY_FLAG_CHUNK_LIST)
+	{
+		// Chunks are decoded through the cache, entries sharing them do not decode them again
+		uint64_t assembled = 0ull;
+		for (uint32_t idx = 0u; idx < _file_info->entry_.block_count_; ++idx)
+		{
+			uint32_t block_index = _pak->chunk_list_[_file_info->entry_.block_index_ + idx];
+			uint32_t block_size = _pak->blocks_[block_index].uncompressed_size_;
+			if (assembled + block_size > uncompressed_size)
+				break;
+
+			// Decoding errors are reported by the block reader
+			if (_gpak_read_block(_pak, block_index, 0ull, mfile->data_ + assembled, block_size) != GPAK_ERROR_OK)
+			{
+				assembled = UINT64_MAX;
+				break;
+			}
+
+			assembled += block_size;
+		}
+
+		if (assembled != uncompressed_size)
+		{
+			if (assembled != UINT64_MAX)
+				_gpak_make_error(_pak, GPAK_ERROR_READ);
+
+			_gpak_set_thread_path(NULL);
+			gpak_fclose(mfile);
+			return NULL;
+		}
+
+		// Every chunk was checked when decoded
+		mfile->crc32_ = _file_info->entry_.crc32_;
+	}
+	else if ((_file_info->entry_.flags_ & GPAK_ENTRY_FLAG_SHARED) && _gpak_cache_copy(_pak, _file_info->entry_.offset_, 0ull, mfile->data_, uncompressed_size))
+	{
+		// Another entry with the same content was decoded recently
+		mfile->crc32_ = _file_info->entry_.crc32_;
+		from_block_cache = 1;
+	}
+	else
+	{
+		// The payload is fetched with a positional read, or used in place from an archive image
+		int result = capacity ? _gpak_decode_in_place(_pak, &_file_info->entry_, mfile->data_, capacity) :
+			_gpak_decode_at(_pak, _file_info->entry_.offset_, compressed_size, mfile->data_, uncompressed_size, _file_info->entry_.dictionary_id_, 0);
+		if (result != GPAK_ERROR_OK)
+		{
+			_gpak_make_error(_pak, result);
+			_gpak_set_thread_path(NULL);
+			gpak_fclose(mfile);
+			return NULL;
+		}
+
+		mfile->data_[uncompressed_size] = '\0';
+
+		mfile->crc32_ = _gpak_crc32_bytes(mfile->data_, uncompressed_size);
+	}
+
+	// Check crc32
+	if (mfile->crc32_ != _file_info->entry_.crc32_)
+	{
+		_gpak_make_error(_pak, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+		_gpak_set_thread_path(NULL);
+		gpak_fclose(mfile);
+		return NULL;
+	}
+
+	// Keep the decoded payload for the other entries sharing it
+	if ((_file_info->entry_.flags_ & (GPAK_ENTRY_FLAG_SHARED | GPAK_ENTRY_FLAG_SOLID)) == GPAK_ENTRY_FLAG_SHARED && !from_block_cache)
+	{
+		char* shared = (char*)malloc(uncompressed_size + 1);
+		memcpy(shared, mfile->data_, uncompressed_size);
+		_gpak_cache_insert(_pak, _file_info->entry_.offset_, shared);
+	}
+
+	// Entries within the budget are kept decoded for the next handles
+	mfile->cached_ = _gpak_entry_cache_insert(_pak->entry_cache_, _file_info, mfile->data_, uncompressed_size, 0);
+	if (mfile->cached_)
+		mfile->data_ = _gpak_cached_entry_data(mfile->cached_);
+
+	_gpak_set_thread_path(NULL);
+
+	return mfile;
+}
+
+// Decoded files are read straight from their buffer, without going through a stdio stream
+size_t _gpak_fread_memory(void* _buffer, size_t _size, gpak_file_t* _file)
+{
+	uint64_t size = _file->entry_.uncompressed_size_;
+	uint64_t available = _file->position_ < size ? size - _file->position_ : 0ull;
+	if (_size > available)
+	{
+		_size = (size_t)available;
+		_file->eof_ = 1;
+	}
+
+	memcpy(_buffer, _file->data_ + _file->position_, _size);
+	_file->position_ += _size;
+
+	return _size;
+}
+
+int gpak_fgetc(gpak_file_t* _file)
+{
+	if (_file->pushback_)
+	{
+		int pushed = _file->pushback_ - 1;
+		_file->pushback_ = 0;
+		return pushed;
+	}
+
+	unsigned char character;
+	if (_file->reader_)
+		return _gpak_fread_streamed(&character, 1ull, _file) == 1ull ? (int)character : EOF;
+
+	// Characters of the chunk already decoded are returned without going through the read path
+	if (_file->chunks_ && (_file->position_ >= _file->entry_.uncompressed_size_ || _file->chunk_index_ != _file->position_ / _file->chunk_table_.chunk_size_))
+		return _gpak_fread_chunked(&character, 1ull, _file) == 1ull ? (int)character : EOF;
+	else if (_file->chunks_)
+		return (unsigned char)_file->data_[_file->position_++ % _file->chunk_table_.chunk_size_];
+
+	if (_file->position_ >= _file->entry_.uncompressed_size_)
+	{
+		_file->eof_ = 1;
+		return EOF;
+	}
+
+	return (unsigned char)_file->data_[_file->position_++];
 }
 
 char* gpak_fgets(gpak_file_t* _file, char* _buffer, int _max)
 {
-	return fgets(_buffer, _max, _file->stream_);
+	if (_max <= 0)
+		return NULL;
+
+	// A pushed back character starts the line
+	int length = 0;
+	if (_file->pushback_ && _max > 1)
+	{
+		_buffer[length++] = (char)(_file->pushback_ - 1);
+		_file->pushback_ = 0;
+		if (_buffer[0] == '\n')
+		{
+			_buffer[length] = '\0';
+			return _buffer;
+		}
+	}
+
+	if (_file->chunks_)
+	{
+		uint32_t chunk_size = _file->chunk_table_.chunk_size_;
+		while (length < _max - 1)
+		{
+			uint64_t size = _file->entry_.uncompressed_size_;
+			if (_file->position_ >= size)
+			{
+				_file->eof_ = 1;
+				break;
+			}
+
+			uint32_t chunk = (uint32_t)(_file->position_ / chunk_size);
+			if (_gpak_file_load_chunk(_file, chunk) != GPAK_ERROR_OK)
+				break;
+
+			// The line end is searched in what is left of the decoded chunk
+			size_t chunk_offset = (size_t)(_file->position_ % chunk_size);
+			size_t limit = _gpak_chunk_uncompressed_size(_file, chunk) - chunk_offset;
+			if (limit > (size_t)(_max - 1 - length))
+				limit = (size_t)(_max - 1 - length);
+
+			const char* line = _file->data_ + chunk_offset;
+			const char* line_end = (const char*)memchr(line, '\n', limit);
+			size_t copied = line_end ? (size_t)(line_end - line) + 1ull : limit;
+
+			memcpy(_buffer + length, line, copied);
+			length += (int)copied;
+			_file->position_ += copied;
+			if (line_end)
+				break;
+		}
+	}
+	else if (_file->reader_)
+	{
+		while (length < _max - 1)
+		{
+			int character = gpak_fgetc(_file);
+			if (character == EOF)
+				break;
+
+			_buffer[length++] = (char)character;
+			if (character == '\n')
+				break;
+		}
+	}
+	else
+	{
+		uint64_t size = _file->entry_.uncompressed_size_;
+		uint64_t available = _file->position_ < size ? size - _file->position_ : 0ull;
+		size_t limit = available < (uint64_t)(_max - 1 - length) ? (size_t)available : (size_t)(_max - 1 - length);
+
+		// The line end is found with one scan of the buffer
+		const char* line = _file->data_ + _file->position_;
+		const char* line_end = (const char*)memchr(line, '\n', limit);
+		size_t copied = line_end ? (size_t)(line_end - line) + 1ull : limit;
+		if (!line_end && limit == available)
+			_file->eof_ = 1;
+
+		memcpy(_buffer + length, line, copied);
+		length += (int)copied;
+		_file->position_ += copied;
+	}
+
+	_buffer[length] = '\0';
+	return length > 0 ? _buffer : NULL;
+}
+
+int gpak_ungetc(gpak_file_t* _file, int _character)
+{
+	// Like ungetc, one character is kept aside and the payload position is left alone
+	if (_character == EOF || _file->pushback_)
+		return EOF;
+
+	_file->pushback_ = (unsigned char)_character + 1;
+	_file->eof_ = 0;
+	return (unsigned char)_character;
+}
+
+size_t gpak_fread(void* _buffer, size_t _elemSize, size_t _elemCount, gpak_file_t* _file)
+{
+	if (_elemSize == 0ull)
+		return 0ull;
+
+	size_t size = _elemSize * _elemCount;
+	size_t readed = 0ull;
+	if (_file->pushback_ && size > 0ull)
+	{
+		*(char*)_buffer = (char)(_file->pushback_ - 1);
+		_file->pushback_ = 0;
+		readed = 1ull;
+	}
+
+	char* destination = (char*)_buffer + readed;
+	if (_file->reader_)
+		readed += _gpak_fread_streamed(destination, size - readed, _file);
+	else if (_file->chunks_)
+		readed += _gpak_fread_chunked(destination, size - readed, _file);
+	else
+		readed += _gpak_fread_memory(destination, size - readed, _file);
+
+	// Like fread, a partially read element is consumed but not counted
+	return readed / _elemSize;
+}
+
+long gpak_ftell(gpak_file_t* _file)
+{
+	// A pushed back character steps the position back, it stays at zero at the start of the file
+	if (_file->pushback_ && _file->position_ > 0ull)
+		return (long)(_file->position_ - 1ull);
+
+	return (long)_file->position_;
+}
+
+long gpak_fseek(gpak_file_t* _file, long _offset, int _origin)
+{
+	int64_t base = 0ll;
+	if (_origin == SEEK_CUR)
+		base = (int64_t)gpak_ftell(_file);
+	else if (_origin == SEEK_END)
+		base = (int64_t)_file->entry_.uncompressed_size_;
+	else if (_origin != SEEK_SET)
+		return -1;
+
+	// Seeking is free, the covering chunk or window of chunked and streamed files is decoded by the next read
+	int64_t position = base + _offset;
+	if (position < 0ll)
+		return -1;
+
+	_file->position_ = (uint64_t)position;
+	_file->pushback_ = 0;
+	_file->eof_ = 0;
+	return 0;
+}
+
+long gpak_feof(gpak_file_t* _file)
+{
+	return _file->eof_;
+}
+
+int gpak_fmap(gpak_t* _pak, const char* _path, gpak_view_t* _view, int _check_crc)
+{
+	memset(_view, 0, sizeof(gpak_view_t));
+
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info)
+	{
+		_gpak_set_thread_path(_path);
+		_gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
+		_gpak_set_thread_path(NULL);
+		return GPAK_ERROR_FILE_NOT_FOUND;
+	}
+
+	const pak_entry_t* entry = &_file_info->entry_;
+	int compressed = (_pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)) != 0;
+
+	// Stored payloads and stored solid blocks are handed out in place
+	const char* data = NULL;
+	if (_pak->memory_ && !(entry->flags_ & (GPAK_ENTRY_FLAG_CHUNKED | GPAK_ENTRY_FLAG_CHUNK_LIST)))
+	{
+		char* buffer = NULL;
+		if (entry->flags_ & GPAK_ENTRY_FLAG_SOLID)
+		{
+			const pak_block_t* block = &_pak->blocks_[entry->block_index_];
+			if (block->compressed_size_ == block->uncompressed_size_)
+				data = _gpak_read_view(_pak, block->offset_ + entry->offset_, (size_t)entry->uncompressed_size_, &buffer);
+		}
+		else if (!compressed && entry->compressed_size_ == entry->uncompressed_size_)
+			data = _gpak_read_view(_pak, entry->offset_, (size_t)entry->uncompressed_size_, &buffer);
+	}
+
+	if (data)
+	{
+		_gpak_set_thread_path(_path);
+		if (_check_crc && _gpak_crc32_bytes(data, entry->uncompressed_size_) != entry->crc32_)
+		{
+			_gpak_make_error(_pak, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+			_gpak_set_thread_path(NULL);
+			return GPAK_ERROR_FILE_CRC_NOT_MATCH;
+		}
+		_gpak_set_thread_path(NULL);
+
+		_view->data_ = data;
+		_view->size_ = entry->uncompressed_size_;
+		return GPAK_ERROR_OK;
+	}
+
+	// Everything else is decoded, and checked, by gpak_fopen
+	gpak_file_t* file = gpak_fopen(_pak, _path);
+	if (!file)
+		return _gpak_last_error() != GPAK_ERROR_OK ? _gpak_last_error() : GPAK_ERROR_READ;
+
+	if (file->chunks_ || file->reader_)
+	{
+		_view->buffer_ = (char*)malloc(entry->uncompressed_size_ + 1ull);
+		if (gpak_fread(_view->buffer_, 1ull, (size_t)entry->uncompressed_size_, file) != entry->uncompressed_size_)
+		{
+			gpak_fclose(file);
+			gpak_funmap(_view);
+			return _gpak_make_error(_pak, GPAK_ERROR_READ);
+		}
+	}
+	else if (file->cached_)
+	{
+		// The reference to the cached entry is taken over
+		_view->cached_ = file->cached_;
+		file->cached_ = NULL;
+		file->data_ = NULL;
+	}
+	else
+	{
+		// The decoded buffer is taken over
+		_view->buffer_ = file->data_;
+		file->data_ = NULL;
+	}
+
+	gpak_fclose(file);
+
+	_view->data_ = _view->cached_ ? _gpak_cached_entry_data(_view->cached_) : _view->buffer_;
+	_view->size_ = entry->uncompressed_size_;
+	return GPAK_ERROR_OK;
+}
+
+void gpak_funmap(gpak_view_t* _view)
+{
+	if (_view->cached_)
+		_gpak_entry_cache_release(_view->cached_);
+
+	free(_view->buffer_);
+	memset(_view, 0, sizeof(gpak_view_t));
+}
+
+int gpak_stat_raw(gpak_t* _pak, const char* _path, gpak_raw_entry_t* _raw)
+{
+	memset(_raw, 0, sizeof(gpak_raw_entry_t));
+	_gpak_set_thread_path(_path);
+
+	int result = GPAK_ERROR_OK;
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info)
+		result = _gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
+	else if (_file_info->entry_.flags_ & (GPAK_ENTRY_FLAG_CHUNKED | GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_CHUNK_LIST))
+		result = _gpak_make_error(_pak, GPAK_ERROR_NOT_PLAIN_ENTRY);
+	else
+	{
+		const pak_entry_t* entry = &_file_info->entry_;
+		_raw->offset_ = entry->offset_;
+		_raw->compressed_size_ = entry->compressed_size_;
+		_raw->uncompressed_size_ = entry->uncompressed_size_;
+		_raw->crc32_ = entry->crc32_;
+		_raw->compression_ = _pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST);
+		_raw->dictionary_id_ = entry->dictionary_id_;
+
+		// The client needs the dictionary the payload was compressed with
+		if (entry->dictionary_id_ > 0u && entry->dictionary_id_ <= _pak->dictionary_count_ && _pak->dictionary_)
+		{
+			const pak_dictionary_t* dictionary = &_pak->dictionaries_[entry->dictionary_id_ - 1u];
+			_raw->dictionary_ = _pak->dictionary_ + dictionary->offset_;
+			_raw->dictionary_size_ = dictionary->size_;
+		}
+	}
+
+	_gpak_set_thread_path(NULL);
+
+	return result;
+}
+
+int gpak_fmap_raw(gpak_t* _pak, const char* _path, gpak_raw_entry_t* _raw)
+{
+	int result = gpak_stat_raw(_pak, _path, _raw);
+	if (result != GPAK_ERROR_OK)
+		return result;
+
+	// Payloads of archive images are handed out in place
+	_raw->data_ = _gpak_read_view(_pak, _raw->offset_, (size_t)_raw->compressed_size_, &_raw->buffer_);
+	if (!_raw->data_)
+	{
+		_gpak_set_thread_path(_path);
+		result = _gpak_make_error(_pak, GPAK_ERROR_READ);
+		_gpak_set_thread_path(NULL);
+	}
+
+	return result;
+}
+
+void gpak_funmap_raw(gpak_raw_entry_t* _raw)
+{
+	free(_raw->buffer_);
+	memset(_raw, 0, sizeof(gpak_raw_entry_t));
+}
+
+int gpak_read_raw(gpak_t* _pak, const char* _path, void* _dst, size_t _dst_size)
+{
+	gpak_raw_entry_t raw;
+	int result = gpak_stat_raw(_pak, _path, &raw);
+	if (result != GPAK_ERROR_OK)
+		return result;
+
+	_gpak_set_thread_path(_path);
+	if (raw.compressed_size_ > _dst_size)
+		result = _gpak_make_error(_pak, GPAK_ERROR_BUFFER_TOO_SMALL);
+	else if (_gpak_read_at(_pak, raw.offset_, _dst, (size_t)raw.compressed_size_) != raw.compressed_size_)
+		result = _gpak_make_error(_pak, GPAK_ERROR_READ);
+	_gpak_set_thread_path(NULL);
+
+	return result;
+}
+
+int _gpak_read_entry_into(gpak_t* _pak, filesystem_tree_file_t* _file_info, char* _dst, size_t _dst_capacity)
+{
+	const pak_entry_t* entry = &_file_info->entry_;
+	size_t uncompressed_size = (size_t)entry->uncompressed_size_;
+
+	if (entry->flags_ & GPAK_ENTRY_FLAG_CHUNKED)
+	{
+		// Runs of whole chunks are decoded in parallel straight into the destination
+		gpak_file_t* file = _gpak_fopen_chunked(_pak, _file_info);
+		if (!file)
+			return _gpak_last_error();
+
+		size_t readed = _gpak_fread_chunked(_dst, uncompressed_size, file);
+		gpak_fclose(file);
+
+		return readed == uncompressed_size ? GPAK_ERROR_OK : _gpak_last_error();
+	}
+	else if (entry->flags_ & GPAK_ENTRY_FLAG_SOLID)
+	{
+		return _gpak_read_block(_pak, entry->block_index_, (size_t)entry->offset_, _dst, uncompressed_size);
+	}
+	else if (entry->flags_ & GPAK_ENTRY_FLAG_CHUNK_LIST)
+	{
+		uint64_t assembled = 0ull;
+		for (uint32_t idx = 0u; idx < entry->block_count_; ++idx)
+		{
+			uint32_t block_index = _pak->chunk_list_[entry->block_index_ + idx];
+			uint32_t block_size = _pak->blocks_[block_index].uncompressed_size_;
+			if (assembled + block_size > uncompressed_size)
+				break;
+
+			int result = _gpak_read_block(_pak, block_index, 0ull, _dst + assembled, block_size);
+			if (result != GPAK_ERROR_OK)
+				return result;
+
+			assembled += block_size;
+		}
+
+		return assembled == uncompressed_size ? GPAK_ERROR_OK : _gpak_make_error(_pak, GPAK_ERROR_READ);
+	}
+	else if ((entry->flags_ & GPAK_ENTRY_FLAG_SHARED) && _gpak_cache_copy(_pak, entry->offset_, 0ull, _dst, uncompressed_size))
+		return GPAK_ERROR_OK;
+
+	size_t compressed_size = (size_t)entry->compressed_size_;
+	int compressed = (_pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)) != 0;
+
+	// Stored payloads are read in place, others are decoded in one shot from the compressed bytes
+	size_t capacity = _gpak_in_place_capacity(_pak, entry);
+	if (capacity && capacity <= _dst_capacity)
+	{
+		int result = _gpak_decode_in_place(_pak, entry, _dst, capacity);
+		if (result != GPAK_ERROR_OK)
+			return _gpak_make_error(_pak, result);
+	}
+	else if (!compressed && compressed_size == uncompressed_size)
+	{
+		if (_gpak_read_at(_pak, entry->offset_, _dst, uncompressed_size) != uncompressed_size)
+			return _gpak_make_error(_pak, GPAK_ERROR_READ);
+	}
+	else
+	{
+		int result = _gpak_decode_at(_pak, entry->offset_, compressed_size, _dst, uncompressed_size, entry->dictionary_id_, 0);
+		if (result != GPAK_ERROR_OK)
+			return _gpak_make_error(_pak, result);
+	}
+
+	if (_gpak_crc32_bytes(_dst, uncompressed_size) != entry->crc32_)
+		return _gpak_make_error(_pak, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+
+	return GPAK_ERROR_OK;
+}
+
+int gpak_read_entry_into(gpak_t* _pak, const char* _path, void* _dst, size_t _dst_size)
+{
+	_gpak_set_thread_path(_path);
+
+	int result = GPAK_ERROR_OK;
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info)
+		result = _gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
+	else if (_file_info->entry_.uncompressed_size_ > _dst_size)
+		result = _gpak_make_error(_pak, GPAK_ERROR_BUFFER_TOO_SMALL);
+	else
+	{
+		gpak_cached_entry_t* cached_entry = _gpak_entry_cache_acquire(_pak->entry_cache_, _file_info);
+		if (cached_entry)
+		{
+			memcpy(_dst, _gpak_cached_entry_data(cached_entry), (size_t)_file_info->entry_.uncompressed_size_);
+			_gpak_entry_cache_release(cached_entry);
+		}
+		else
+			result = _gpak_read_entry_into(_pak, _file_info, (char*)_dst, _dst_size);
+	}
+
+	_gpak_set_thread_path(NULL);
+
+	return result;
+}
+
+struct gpak_batch_piece
+{
+	uint64_t offset_;
+	uint64_t compressed_size_;
+	uint64_t uncompressed_size_;
+	uint32_t dictionary_id_;
+	uint32_t crc32_;
+	int stored_;
+	size_t read_;
+	uint64_t begin_;
+	uint64_t size_;
+	uint64_t dst_offset_;
+	int32_t error_;
+};
+
+struct gpak_batch_run
+{
+	size_t first_piece_;
+	size_t piece_count_;
+	uint64_t offset_;
+	uint64_t size_;
+};
+
+struct gpak_batch
+{
+	gpak_t* pak_;
+	gpak_batch_read_t* reads_;
+	filesystem_tree_file_t** files_;
+	char** destinations_;
+	struct gpak_batch_piece* pieces_;
+	struct gpak_batch_run* runs_;
+};
+
+int _gpak_compare_batch_pieces(const void* _left, const void* _right)
+{
+	const struct gpak_batch_piece* left = (const struct gpak_batch_piece*)_left;
+	const struct gpak_batch_piece* right = (const struct gpak_batch_piece*)_right;
+
+	if (left->offset_ != right->offset_)
+		return left->offset_ < right->offset_ ? -1 : 1;
+	if (left->read_ != right->read_)
+		return left->read_ < right->read_ ? -1 : 1;
+	if (left->dst_offset_ != right->dst_offset_)
+		return left->dst_offset_ < right->dst_offset_ ? -1 : 1;
+	return 0;
+}
+
+int _gpak_batch_decode(gpak_t* _pak, const struct gpak_batch_piece* _piece, const char* _src, char* _dst)
+{
+	if (_piece->stored_ && _piece->compressed_size_ == _piece->uncompressed_size_)
+	{
+		memcpy(_dst, _src, (size_t)_piece->uncompressed_size_);
+		return GPAK_ERROR_OK;
+	}
+
+	gpak_decoder_t* decoder = _gpak_decoder_acquire(_pak);
+	if (!decoder)
+		return GPAK_ERROR_READ;
+
+	size_t decoded = _gpak_decoder_decompress(decoder, _src, (size_t)_piece->compressed_size_, _dst, (size_t)_piece->uncompressed_size_, _piece->dictionary_id_);
+	_gpak_decoder_release(_pak, decoder);
+
+	return decoded == _piece->uncompressed_size_ ? GPAK_ERROR_OK : GPAK_ERROR_FILE_CRC_NOT_MATCH;
+}
+
+// Reads one merged run of payloads sequentially and decodes every payload in it
+void _gpak_batch_run_job(void* _arg, size_t _index)
+{
+	struct gpak_batch* batch = (struct gpak_batch*)_arg;
+	const struct gpak_batch_run* run = &batch->runs_[_index];
+	struct gpak_batch_piece* pieces = batch->pieces_ + run->first_piece_;
+
+	char* buffer = NULL;
+	const char* data = _gpak_read_view(batch->pak_, run->offset_, (size_t)run->size_, &buffer);
+
+	size_t idx = 0ull;
+	while (idx < run->piece_count_)
+	{
+		// Pieces of the same solid block or shared payload follow each other
+		size_t count = 1ull;
+		while (idx + count < run->piece_count_ && pieces[idx + count].offset_ == pieces[idx].offset_)
+			++count;
+
+		struct gpak_batch_piece* piece = &pieces[idx];
+		int result = data ? GPAK_ERROR_OK : GPAK_ERROR_READ;
+		if (result == GPAK_ERROR_OK)
+		{
+			const char* source = data + (piece->offset_ - run->offset_);
+			if (count == 1ull && piece->begin_ == 0ull && piece->size_ == piece->uncompressed_size_)
+				result = _gpak_batch_decode(batch->pak_, piece, source, batch->destinations_[piece->read_] + piece->dst_offset_);
+			else
+			{
+				char* decoded = (char*)malloc(piece->uncompressed_size_ + 1ull);
+				result = _gpak_batch_decode(batch->pak_, piece, source, decoded);
+
+				// The whole payload is checked before it is cached, readers of cached blocks trust their content
+				if (result == GPAK_ERROR_OK && _gpak_crc32_bytes(decoded, piece->uncompressed_size_) != piece->crc32_)
+					result = GPAK_ERROR_FILE_CRC_NOT_MATCH;
+
+				for (size_t part = 0ull; result == GPAK_ERROR_OK && part < count; ++part)
+					memcpy(batch->destinations_[piece[part].read_] + piece[part].dst_offset_, decoded + piece[part].begin_, (size_t)piece[part].size_);
+
+				// Kept for the files of the same block read later on
+				if (result == GPAK_ERROR_OK)
+					_gpak_cache_insert(batch->pak_, piece->offset_, decoded);
+				else
+					free(decoded);
+			}
+		}
+
+		for (size_t part = 0ull; part < count; ++part)
+			piece[part].error_ = result;
+
+		idx += count;
+	}
+
+	free(buffer);
+}
+
+// Checks a decoded file and hands its content over to its view
+void _gpak_batch_finish_job(void* _arg, size_t _index)
+{
+	struct gpak_batch* batch = (struct gpak_batch*)_arg;
+	gpak_batch_read_t* read = &batch->reads_[_index];
+	filesystem_tree_file_t* file_info = batch->files_[_index];
+	if (!file_info)
+		return;
+
+	const pak_entry_t* entry = &file_info->entry_;
+	char* destination = batch->destinations_[_index];
+
+	// Chunked files were read and checked on their own
+	if (read->error_ == GPAK_ERROR_OK && !(entry->flags_ & GPAK_ENTRY_FLAG_CHUNKED) && _gpak_crc32_bytes(destination, entry->uncompressed_size_) != entry->crc32_)
+		read->error_ = GPAK_ERROR_FILE_CRC_NOT_MATCH;
+
+	if (read->error_ != GPAK_ERROR_OK)
+	{
+		if (!(entry->flags_ & GPAK_ENTRY_FLAG_CHUNKED))
+		{
+			_gpak_set_thread_path(read->path_);
+			_gpak_make_error(batch->pak_, read->error_);
+			_gpak_set_thread_path(NULL);
+		}
+
+		gpak_funmap(&read->view_);
+		return;
+	}
+
+	if (read->dst_)
+		return;
+
+	// Entries within the budget are kept decoded for the next handles
+	read->view_.cached_ = _gpak_entry_cache_insert(batch->pak_->entry_cache_, file_info, destination, entry->uncompressed_size_, 0);
+	if (read->view_.cached_)
+		read->view_.buffer_ = NULL;
+
+	read->view_.data_ = read->view_.cached_ ? _gpak_cached_entry_data(read->view_.cached_) : destination;
+	read->view_.size_ = entry->uncompressed_size_;
+}
+
+int gpak_read_batch(gpak_t* _pak, gpak_batch_read_t* _reads, size_t _count)
+{
+	struct gpak_batch batch;
+	memset(&batch, 0, sizeof(batch));
+	batch.pak_ = _pak;
+	batch.reads_ = _reads;
+	batch.files_ = (filesystem_tree_file_t**)calloc(_count + 1ull, sizeof(filesystem_tree_file_t*));
+	batch.destinations_ = (char**)calloc(_count + 1ull, sizeof(char*));
+
+	int compressed = (_pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)) != 0;
+
+	size_t piece_count = 0ull;
+	size_t piece_capacity = _count + 1ull;
+	batch.pieces_ = (struct gpak_batch_piece*)malloc(sizeof(struct gpak_batch_piece) * piece_capacity);
+
+	// Every path is resolved first, files are then split into the payloads they are decoded from
+	for (size_t idx = 0ull; idx < _count; ++idx)
+	{
+		gpak_batch_read_t* read = &_reads[idx];
+		memset(&read->view_, 0, sizeof(gpak_view_t));
+		read->error_ = GPAK_ERROR_OK;
+
+		filesystem_tree_file_t* file_info = _gpak_find_entry(_pak, read->path_);
+		if (!file_info)
+			read->error_ = GPAK_ERROR_FILE_NOT_FOUND;
+		else if (read->dst_ && file_info->entry_.uncompressed_size_ > read->dst_size_)
+			read->error_ = GPAK_ERROR_BUFFER_TOO_SMALL;
+
+		if (read->error_ != GPAK_ERROR_OK)
+		{
+			_gpak_set_thread_path(read->path_);
+			_gpak_make_error(_pak, read->error_);
+			_gpak_set_thread_path(NULL);
+			continue;
+		}
+
+		const pak_entry_t* entry = &file_info->entry_;
+		size_t uncompressed_size = (size_t)entry->uncompressed_size_;
+
+		gpak_cached_entry_t* cached_entry = _gpak_entry_cache_acquire(_pak->entry_cache_, file_info);
+		if (cached_entry)
+		{
+			if (read->dst_)
+			{
+				memcpy(read->dst_, _gpak_cached_entry_data(cached_entry), uncompressed_size);
+				_gpak_entry_cache_release(cached_entry);
+			}
+			else
+			{
+				read->view_.cached_ = cached_entry;
+				read->view_.data_ = _gpak_cached_entry_data(cached_entry);
+				read->view_.size_ = entry->uncompressed_size_;
+			}
+			continue;
+		}
+
+		batch.files_[idx] = file_info;
+		if (read->dst_)
+			batch.destinations_[idx] = (char*)read->dst_;
+		else
+		{
+			read->view_.buffer_ = (char*)malloc(uncompressed_size + 1ull);
+			read->view_.buffer_[uncompressed_size] = '\0';
+			batch.destinations_[idx] = read->view_.buffer_;
+		}
+
+		if (entry->flags_ & GPAK_ENTRY_FLAG_CHUNKED)
+			continue;
+
+		uint32_t block_count = (entry->flags_ & GPAK_ENTRY_FLAG_CHUNK_LIST) ? entry->block_count_ : 1u;
+		if (piece_count + block_count > piece_capacity)
+		{
+			while (piece_count + block_count > piece_capacity)
+				piece_capacity *= 2ull;
+			batch.pieces_ = (struct gpak_batch_piece*)realloc(batch.pieces_, sizeof(struct gpak_batch_piece) * piece_capacity);
+		}
+
+		if (entry->flags_ & (GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_CHUNK_LIST))
+		{
+			uint64_t assembled = 0ull;
+			for (uint32_t block = 0u; block < block_count; ++block)
+			{
+				uint32_t block_index = (entry->flags_ & GPAK_ENTRY_FLAG_SOLID) ? entry->block_index_ : _pak->chunk_list_[entry->block_index_ + block];
+				const pak_block_t* block_info = &_pak->blocks_[block_index];
+
+				struct gpak_batch_piece* piece = &batch.pieces_[piece_count++];
+				piece->offset_ = block_info->offset_;
+				piece->compressed_size_ = block_info->compressed_size_;
+				piece->uncompressed_size_ = block_info->uncompressed_size_;
+				piece->dictionary_id_ = block_info->dictionary_id_;
+				piece->crc32_ = block_info->crc32_;
+				piece->stored_ = 1;
+				piece->read_ = idx;
+				piece->begin_ = (entry->flags_ & GPAK_ENTRY_FLAG_SOLID) ? entry->offset_ : 0ull;
+				piece->size_ = (entry->flags_ & GPAK_ENTRY_FLAG_SOLID) ? entry->uncompressed_size_ : block_info->uncompressed_size_;
+				piece->dst_offset_ = assembled;
+				piece->error_ = GPAK_ERROR_OK;
+
+				assembled += piece->size_;
+				if (assembled > entry->uncompressed_size_ || piece->begin_ + piece->size_ > block_info->uncompressed_size_)
+				{
+					--piece_count;
+					read->error_ = GPAK_ERROR_READ;
+					break;
+				}
+			}
+
+			if (read->error_ == GPAK_ERROR_OK && assembled != entry->uncompressed_size_)
+				read->error_ = GPAK_ERROR_READ;
+		}
+		else
+		{
+			struct gpak_batch_piece* piece = &batch.pieces_[piece_count++];
+			piece->offset_ = entry->offset_;
+			piece->compressed_size_ = entry->compressed_size_;
+			piece->uncompressed_size_ = entry->uncompressed_size_;
+			piece->dictionary_id_ = entry->dictionary_id_;
+			piece->crc32_ = entry->crc32_;
+			piece->stored_ = !compressed;
+			piece->read_ = idx;
+			piece->begin_ = 0ull;
+			piece->size_ = entry->uncompressed_size_;
+			piece->dst_offset_ = 0ull;
+			piece->error_ = GPAK_ERROR_OK;
+		}
+	}
+
+	// Payloads are read in archive order, close neighbours are merged into one sequential read
+	qsort(batch.pieces_, piece_count, sizeof(struct gpak_batch_piece), _gpak_compare_batch_pieces);
+
+	size_t run_count = 0ull;
+	batch.runs_ = (struct gpak_batch_run*)malloc(sizeof(struct gpak_batch_run) * (piece_count + 1ull));
+	for (size_t idx = 0ull; idx < piece_count; ++idx)
+	{
+		const struct gpak_batch_piece* piece = &batch.pieces_[idx];
+		uint64_t piece_end = piece->offset_ + piece->compressed_size_;
+
+		struct gpak_batch_run* run = run_count > 0ull ? &batch.runs_[run_count - 1ull] : NULL;
+		int same_payload = run && batch.pieces_[idx - 1ull].offset_ == piece->offset_;
+		int mergeable = run && piece->offset_ <= run->offset_ + run->size_ + GPAK_BATCH_GAP_SIZE && piece_end - run->offset_ <= GPAK_BATCH_READ_SIZE;
+		if (same_payload || mergeable)
+		{
+			if (piece_end > run->offset_ + run->size_)
+				run->size_ = piece_end - run->offset_;
+			++run->piece_count_;
+			continue;
+		}
+
+		run = &batch.runs_[run_count++];
+		run->first_piece_ = idx;
+		run->piece_count_ = 1ull;
+		run->offset_ = piece->offset_;
+		run->size_ = piece->compressed_size_;
+	}
+
+	gpak_thread_pool_t* pool = _gpak_get_thread_pool(_pak);
+	_gpak_thread_pool_parallel_for(pool, run_count, _gpak_batch_run_job, &batch);
+
+	for (size_t idx = 0ull; idx < piece_count; ++idx)
+	{
+		const struct gpak_batch_piece* piece = &batch.pieces_[idx];
+		if (piece->error_ != GPAK_ERROR_OK && _reads[piece->read_].error_ == GPAK_ERROR_OK)
+			_reads[piece->read_].error_ = piece->error_;
+	}
+
+	// Chunked files already decode their chunks in parallel
+	for (size_t idx = 0ull; idx < _count; ++idx)
+	{
+		if (batch.files_[idx] && (batch.files_[idx]->entry_.flags_ & GPAK_ENTRY_FLAG_CHUNKED))
+		{
+			_gpak_set_thread_path(_reads[idx].path_);
+			_reads[idx].error_ = _gpak_read_entry_into(_pak, batch.files_[idx], batch.destinations_[idx], (size_t)batch.files_[idx]->entry_.uncompressed_size_);
+			_gpak_set_thread_path(NULL);
+		}
+	}
+
+	_gpak_thread_pool_parallel_for(pool, _count, _gpak_batch_finish_job, &batch);
+
+	int result = GPAK_ERROR_OK;
+	for (size_t idx = 0ull; idx < _count && result == GPAK_ERROR_OK; ++idx)
+		result = _reads[idx].error_;
+
+	free(batch.runs_);
+	free(batch.pieces_);
+	free(batch.destinations_);
+	free(batch.files_);
+
+	return result;
+}
+
+struct gpak_extract_file
+{
+	filesystem_tree_file_t* file_;
+	char* path_;
+	const char* relative_path_;
+	uint64_t position_;
+};
+
+struct gpak_extract_window
+{
+	struct gpak_extract* extract_;
+	char* buffer_;
+	uint64_t size_;
+	struct gpak_extract_write* writes_;
+	size_t pending_;
+};
+
+struct gpak_extract_write
+{
+	struct gpak_extract_window* window_;
+	const struct gpak_extract_file* file_;
+	const char* data_;
+	int32_t error_;
+};
+
+struct gpak_extract
+{
+	gpak_t* pak_;
+	const char* destination_;
+	gpak_thread_pool_t* writers_;
+	gpak_mutex_t mutex_;
+	gpak_cond_t cond_;
+	uint64_t buffered_;
+	size_t windows_;
+	int result_;
+	struct gpak_extract_file* files_;
+	size_t file_count_;
+	size_t file_capacity_;
+	char** directories_;
+	size_t directory_count_;
+	size_t directory_capacity_;
+};
+
+int _gpak_extract_safe_name(const char* _name)
+{
+	if (!*_name || strcmp(_name, ".") == 0 || strcmp(_name, "..") == 0)
+		return 0;
+
+	return strchr(_name, '\\') == NULL && strchr(_name, ':') == NULL;
+}
+
+void _gpak_extract_fail(struct gpak_extract* _extract, const char* _path, int _error)
+{
+	_gpak_set_thread_path(_path);
+	_gpak_make_error(_extract->pak_, _error);
+	_gpak_set_thread_path(NULL);
+
+	_gpak_mutex_lock(&_extract->mutex_);
+	if (_extract->result_ == GPAK_ERROR_OK)
+		_extract->result_ = _error;
+	_gpak_mutex_unlock(&_extract->mutex_);
+}
+
+char* _gpak_extract_output_path(const struct gpak_extract* _extract, const char* _relative_path)
+{
+	size_t length = strlen(_extract->destination_) + strlen(_relative_path) + 2ull;
+	char* path = (char*)malloc(length);
+	snprintf(path, length, "%s/%s", _extract->destination_, _relative_path);
+	return path;
+}
+
+// Gathers the files and the leaf directories of a subtree, leaf directories are enough to create all of them
+void _gpak_extract_collect(struct gpak_extract* _extract, filesystem_tree_node_t* _node, size_t _prefix_length)
+{
+	gpak_t* pak = _extract->pak_;
+	char* directory_path = filesystem_tree_directory_path(_node);
+
+	if (_node->num_children_ == 0ull)
+	{
+		if (_extract->directory_count_ == _extract->directory_capacity_)
+		{
+			_extract->directory_capacity_ = _extract->directory_capacity_ ? _extract->directory_capacity_ * 2ull : 16ull;
+			_extract->directories_ = (char**)realloc(_extract->directories_, sizeof(char*) * _extract->directory_capacity_);
+		}
+		_extract->directories_[_extract->directory_count_++] = _gpak_extract_output_path(_extract, directory_path + _prefix_length);
+	}
+
+	for (size_t idx = 0ull; idx < _node->num_files_; ++idx)
+	{
+		filesystem_tree_file_t* file = _node->files_[idx];
+		char* path = filesystem_tree_file_path(_node, file);
+		if (!_gpak_extract_safe_name(file->name_))
+		{
+			_gpak_extract_fail(_extract, path, GPAK_ERROR_UNSAFE_PATH);
+			free(path);
+			continue;
+		}
+
+		if (_extract->file_count_ == _extract->file_capacity_)
+		{
+			_extract->file_capacity_ = _extract->file_capacity_ ? _extract->file_capacity_ * 2ull : 64ull;
+			_extract->files_ = (struct gpak_extract_file*)realloc(_extract->files_, sizeof(struct gpak_extract_file) * _extract->file_capacity_);
+		}
+
+		// Files are read in the order their payloads are stored, solid and chunk list entries by their first block
+		const pak_entry_t* entry = &file->entry_;
+		struct gpak_extract_file* extract_file = &_extract->files_[_extract->file_count_++];
+		extract_file->file_ = file;
+		extract_file->path_ = path;
+		extract_file->relative_path_ = path + _prefix_length;
+		extract_file->position_ = entry->offset_;
+		if (entry->flags_ & GPAK_ENTRY_FLAG_SOLID)
+			extract_file->position_ = pak->blocks_[entry->block_index_].offset_;
+		else if ((entry->flags_ & GPAK_ENTRY_FLAG_CHUNK_LIST) && entry->block_count_ > 0u)
+			extract_file->position_ = pak->blocks_[pak->chunk_list_[entry->block_index_]].offset_;
+	}
+
+	for (size_t idx = 0ull; idx < _node->num_children_; ++idx)
+	{
+		filesystem_tree_node_t* child = _node->children_[idx];
+		if (!_gpak_extract_safe_name(child->name_))
+		{
+			char* child_path = filesystem_tree_directory_path(child);
+			_gpak_extract_fail(_extract, child_path, GPAK_ERROR_UNSAFE_PATH);
+			free(child_path);
+			continue;
+		}
+
+		_gpak_extract_collect(_extract, child, _prefix_length);
+	}
+
+	free(directory_path);
+}
+
+int _gpak_compare_extract_files(const void* _left, const void* _right)
+{
+	const struct gpak_extract_file* left = (const struct gpak_extract_file*)_left;
+	const struct gpak_extract_file* right = (const struct gpak_extract_file*)_right;
+
+	if (left->position_ != right->position_)
+		return left->position_ < right->position_ ? -1 : 1;
+	if (left->file_->entry_.offset_ != right->file_->entry_.offset_)
+		return left->file_->entry_.offset_ < right->file_->entry_.offset_ ? -1 : 1;
+	return 0;
+}
+
+void _gpak_extract_directory_job(void* _arg, size_t _index)
+{
+	struct gpak_extract* extract = (struct gpak_extract*)_arg;
+	if (!_gpak_make_directories(extract->directories_[_index]))
+		_gpak_extract_fail(extract, extract->directories_[_index], GPAK_ERROR_WRITE);
+}
+
+// Writes one decoded file of a window, the last write of a window releases it
+void _gpak_extract_write_job(void* _arg)
+{
+	struct gpak_extract_write* write = (struct gpak_extract_write*)_arg;
+	struct gpak_extract_window* window = write->window_;
+	struct gpak_extract* extract = window->extract_;
+
+	if (write->error_ == GPAK_ERROR_OK)
+	{
+		uint64_t size = write->file_->file_->entry_.uncompressed_size_;
+		char* output_path = _gpak_extract_output_path(extract, write->file_->relative_path_);
+
+		int result = GPAK_ERROR_OK;
+		FILE* outfile = _gpak_create_output(output_path, size);
+		if (!outfile)
+			result = GPAK_ERROR_OPEN_FILE;
+		else
+		{
+			if (_fwriteb(write->data_, 1ull, (size_t)size, outfile) != size)
+				result = GPAK_ERROR_WRITE;
+			if (fclose(outfile) != 0)
+				result = GPAK_ERROR_WRITE;
+		}
+
+		if (result != GPAK_ERROR_OK)
+			_gpak_extract_fail(extract, write->file_->path_, result);
+
+		free(output_path);
+	}
+
+	_gpak_mutex_lock(&extract->mutex_);
+	int finished = --window->pending_ == 0ull;
+	if (finished)
+	{
+		extract->buffered_ -= window->size_;
+		--extract->windows_;
+		_gpak_cond_broadcast(&extract->cond_);
+	}
+	_gpak_mutex_unlock(&extract->mutex_);
+
+	if (finished)
+	{
+		free(window->buffer_);
+		free(window->writes_);
+		free(window);
+	}
+}
+
+// Reads a run of files in one batch and hands them over to the writers
+void _gpak_extract_window(struct gpak_extract* _extract, const struct gpak_extract_file* _files, size_t _count, uint64_t _size)
+{
+	gpak_t* pak = _extract->pak_;
+
+	// Reading stops while the writers are behind, so memory stays bounded whatever the archive size
+	_gpak_mutex_lock(&_extract->mutex_);
+	while (_extract->buffered_ > 0ull && _extract->buffered_ + _size > GPAK_EXTRACT_BUFFER_SIZE)
+		_gpak_cond_wait(&_extract->cond_, &_extract->mutex_);
+	_extract->buffered_ += _size;
+	++_extract->windows_;
+	_gpak_mutex_unlock(&_extract->mutex_);
+
+	struct gpak_extract_window* window = (struct gpak_extract_window*)calloc(1, sizeof(struct gpak_extract_window));
+	window->extract_ = _extract;
+	window->buffer_ = (char*)malloc((size_t)_size + 1ull);
+	window->size_ = _size;
+	window->writes_ = (struct gpak_extract_write*)malloc(sizeof(struct gpak_extract_write) * _count);
+	window->pending_ = _count;
+
+	gpak_batch_read_t* reads = (gpak_batch_read_t*)calloc(_count, sizeof(gpak_batch_read_t));
+	uint64_t offset = 0ull;
+	for (size_t idx = 0ull; idx < _count; ++idx)
+	{
+		reads[idx].path_ = _files[idx].path_;
+		reads[idx].dst_ = window->buffer_ + offset;
+		reads[idx].dst_size_ = (size_t)_files[idx].file_->entry_.uncompressed_size_;
+		offset += _files[idx].file_->entry_.uncompressed_size_;
+	}
+
+	int result = gpak_read_batch(pak, reads, _count);
+	if (result != GPAK_ERROR_OK)
+	{
+		_gpak_mutex_lock(&_extract->mutex_);
+		if (_extract->result_ == GPAK_ERROR_OK)
+			_extract->result_ = result;
+		_gpak_mutex_unlock(&_extract->mutex_);
+	}
+
+	// The window may be released by the writers as soon as its last write is submitted
+	struct gpak_extract_write* writes = window->writes_;
+	for (size_t idx = 0ull; idx < _count; ++idx)
+	{
+		writes[idx].window_ = window;
+		writes[idx].file_ = &_files[idx];
+		writes[idx].data_ = (const char*)reads[idx].dst_;
+		writes[idx].error_ = reads[idx].error_;
+	}
+
+	for (size_t idx = 0ull; idx < _count; ++idx)
+	{
+		pak->current_file_ = _files[idx].path_;
+		_gpak_pass_progress(pak, (size_t)_files[idx].file_->entry_.uncompressed_size_, (size_t)_files[idx].file_->entry_.uncompressed_size_, GPAK_STAGE_DECOMPRESSION);
+		pak->current_file_ = NULL;
+
+		_gpak_thread_pool_submit(_extract->writers_, &_gpak_extract_write_job, &writes[idx]);
+	}
+
+	free(reads);
+}
+
+// Files larger than a window are decoded and written piece by piece
+void _gpak_extract_stream(struct gpak_extract* _extract, const struct gpak_extract_file* _file)
+{
+	gpak_t* pak = _extract->pak_;
+	uint64_t size = _file->file_->entry_.uncompressed_size_;
+
+	gpak_file_t* infile = gpak_fopen(pak, _file->path_);
+	if (!infile)
+	{
+		_gpak_mutex_lock(&_extract->mutex_);
+		if (_extract->result_ == GPAK_ERROR_OK)
+			_extract->result_ = gpak_get_last_error();
+		_gpak_mutex_unlock(&_extract->mutex_);
+		return;
+	}
+
+	char* output_path = _gpak_extract_output_path(_extract, _file->relative_path_);
+	FILE* outfile = _gpak_create_output(output_path, size);
+	free(output_path);
+
+	if (!outfile)
+	{
+		gpak_fclose(infile);
+		_gpak_extract_fail(_extract, _file->path_, GPAK_ERROR_OPEN_FILE);
+		return;
+	}
+
+	char* buffer = (char*)malloc(GPAK_EXTRACT_WRITE_SIZE);
+	uint64_t written = 0ull;
+	int result = GPAK_ERROR_OK;
+
+	pak->current_file_ = _file->path_;
+	while (written < size)
+	{
+		size_t readed = gpak_fread(buffer, 1ull, GPAK_EXTRACT_WRITE_SIZE, infile);
+		if (readed == 0ull)
+		{
+			result = GPAK_ERROR_READ;
+			break;
+		}
+
+		if (_fwriteb(buffer, 1ull, readed, outfile) != readed)
+		{
+			result = GPAK_ERROR_WRITE;
+			break;
+		}
+
+		written += readed;
+		_gpak_pass_progress(pak, (size_t)written, (size_t)size, GPAK_STAGE_DECOMPRESSION);
+	}
+	pak->current_file_ = NULL;
+
+	if (fclose(outfile) != 0 && result == GPAK_ERROR_OK)
+		result = GPAK_ERROR_WRITE;
+	gpak_fclose(infile);
+	free(buffer);
+
+	if (result != GPAK_ERROR_OK)
+		_gpak_extract_fail(_extract, _file->path_, result);
+}
+
+int gpak_extract_directory(gpak_t* _pak, const char* _path, const char* _destination)
+{
+	if (_pak->mode_ & GPAK_MODE_CREATE)
+		return _gpak_make_error(_pak, GPAK_ERROR_INCORRECT_MODE);
+
+	filesystem_tree_node_t* root = (_path && *_path) ? filesystem_tree_find_directory(_pak->root_, _path) : _pak->root_;
+	if (!root)
+	{
+		_gpak_set_thread_path(_path);
+		_gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
+		_gpak_set_thread_path(NULL);
+		return GPAK_ERROR_FILE_NOT_FOUND;
+	}
+
+	struct gpak_extract extract;
+	memset(&extract, 0, sizeof(extract));
+	extract.pak_ = _pak;
+	extract.destination_ = _destination;
+	_gpak_mutex_init(&extract.mutex_);
+	_gpak_cond_init(&extract.cond_);
+
+	// Paths are extracted relative to the requested directory
+	char* prefix = filesystem_tree_directory_path(root);
+	_gpak_extract_collect(&extract, root, strlen(prefix));
+	free(prefix);
+
+	qsort(extract.files_, extract.file_count_, sizeof(struct gpak_extract_file), _gpak_compare_extract_files);
+
+	// Writers have their own threads, the archive pool stays free for the batch reads feeding them
+	extract.writers_ = _gpak_thread_pool_create(0u);
+	_gpak_thread_pool_parallel_for(extract.writers_, extract.directory_count_, &_gpak_extract_directory_job, &extract);
+
+	size_t idx = 0ull;
+	while (idx < extract.file_count_)
+	{
+		uint64_t size = extract.files_[idx].file_->entry_.uncompressed_size_;
+		if (size > GPAK_EXTRACT_WINDOW_SIZE || !extract.writers_)
+		{
+			_gpak_extract_stream(&extract, &extract.files_[idx]);
+			++idx;
+			continue;
+		}
+
+		size_t count = 0ull;
+		uint64_t window_size = 0ull;
+		while (idx + count < extract.file_count_)
+		{
+			uint64_t file_size = extract.files_[idx + count].file_->entry_.uncompressed_size_;
+			if (file_size > GPAK_EXTRACT_WINDOW_SIZE || (count > 0ull && window_size + file_size > GPAK_EXTRACT_WINDOW_SIZE))
+				break;
+
+			window_size += file_size;
+			++count;
+		}
+
+		_gpak_extract_window(&extract, &extract.files_[idx], count, window_size);
+		idx += count;
+	}
+
+	_gpak_mutex_lock(&extract.mutex_);
+	while (extract.windows_ > 0ull)
+		_gpak_cond_wait(&extract.cond_, &extract.mutex_);
+	_gpak_mutex_unlock(&extract.mutex_);
+
+	_gpak_thread_pool_free(extract.writers_);
+	_gpak_cond_destroy(&extract.cond_);
+	_gpak_mutex_destroy(&extract.mutex_);
+
+	for (size_t file = 0ull; file < extract.file_count_; ++file)
+		free(extract.files_[file].path_);
+	for (size_t directory = 0ull; directory < extract.directory_count_; ++directory)
+		free(extract.directories_[directory]);
+	free(extract.files_);
+	free(extract.directories_);
+
+	return extract.result_;
+}
+
+int gpak_extract_all(gpak_t* _pak, const char* _destination)
+{
+	return gpak_extract_directory(_pak, NULL, _destination);
+}
+
+int gpak_pin_entry(gpak_t* _pak, const char* _path)
+{
+	_gpak_set_thread_path(_path);
+
+	int result = GPAK_ERROR_OK;
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info)
+		result = _gpak_make_error(_pak, GPAK_ERROR_FILE_NOT_FOUND);
+	else if (!_gpak_entry_cache_pin(_pak->entry_cache_, _file_info, 1))
+	{
+		// Pinned entries are decoded right away so that the first open does not pay for it
+		size_t uncompressed_size = (size_t)_file_info->entry_.uncompressed_size_;
+		char* data = (char*)malloc(uncompressed_size + 1ull);
+		data[uncompressed_size] = '\0';
+
+		result = _gpak_read_entry_into(_pak, _file_info, data, uncompressed_size);
+		if (result == GPAK_ERROR_OK)
+			_gpak_entry_cache_release(_gpak_entry_cache_insert(_pak->entry_cache_, _file_info, data, uncompressed_size, 1));
+		else
+			free(data);
+	}
+
+	_gpak_set_thread_path(NULL);
+
+	return result;
+}
+
+int gpak_unpin_entry(gpak_t* _pak, const char* _path)
+{
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_pak, _path);
+	if (!_file_info || !_gpak_entry_cache_pin(_pak->entry_cache_, _file_info, 0))
+		return GPAK_ERROR_FILE_NOT_FOUND;
+
+	return GPAK_ERROR_OK;
+}
+
+void gpak_fclose(gpak_file_t* _file)
+{
+	if (_file->reader_)
+		_gpak_stream_free(_file->reader_);
+
+	// Cached content belongs to the cache
+	if (_file->cached_)
+		_gpak_entry_cache_release(_file->cached_);
+	else
+		free(_file->data_);
+
+	free(_file->chunks_);
+	free(_file);
+}
+
+struct gpak_async_request
+{
+	struct gpak_async* async_;
+	filesystem_tree_file_t* file_info_;
+	char* path_;
+	gpak_read_handler_t handler_;
+	void* user_data_;
+	char* payload_;
+	uint64_t readed_;
+	int stored_;
+	int32_t error_;
+	gpak_view_t view_;
+	struct gpak_async_request* next_;
+};
+
+struct gpak_async
+{
+	gpak_t* pak_;
+	gpak_uring_t* ring_;
+	int descriptor_;
+	gpak_thread_pool_t* pool_;
+	gpak_mutex_t mutex_;
+	gpak_cond_t cond_;
+	struct gpak_async_request* waiting_head_;
+	struct gpak_async_request* waiting_tail_;
+	struct gpak_async_request* done_head_;
+	struct gpak_async_request* done_tail_;
+	uint32_t jobs_;
+	uint32_t pending_;
+};
+
+void _gpak_async_finish(struct gpak_async_request* _request, int _from_job)
+{
+	struct gpak_async* async = _request->async_;
+
+	_gpak_mutex_lock(&async->mutex_);
+	if (async->done_tail_)
+		async->done_tail_->next_ = _request;
+	else
+		async->done_head_ = _request;
+	async->done_tail_ = _request;
+
+	if (_from_job)
+		--async->jobs_;
+
+	_gpak_cond_signal(&async->cond_);
+	_gpak_mutex_unlock(&async->mutex_);
+}
+
+void _gpak_async_map_job(void* _arg)
+{
+	struct gpak_async_request* request = (struct gpak_async_request*)_arg;
+	request->error_ = gpak_fmap(request->async_->pak_, request->path_, &request->view_, 1);
+	_gpak_async_finish(request, 1);
+}
+
+// Decodes a payload read through the ring, runs on a worker thread while the next payloads are still being read
+void _gpak_async_decode_job(void* _arg)
+{
+	struct gpak_async_request* request = (struct gpak_async_request*)_arg;
+	gpak_t* pak = request->async_->pak_;
+	const pak_entry_t* entry = &request->file_info_->entry_;
+	size_t uncompressed_size = (size_t)entry->uncompressed_size_;
+
+	char* buffer = request->payload_;
+	request->payload_ = NULL;
+
+	if (!request->stored_)
+	{
+		char* source = buffer;
+		buffer = (char*)malloc(uncompressed_size + 1ull);
+		buffer[uncompressed_size] = '\0';
+
+		size_t decoded = 0ull;
+		gpak_decoder_t* decoder = _gpak_decoder_acquire(pak);
+		if (decoder)
+		{
+			decoded = _gpak_decoder_decompress(decoder, source, (size_t)entry->compressed_size_, buffer, uncompressed_size, entry->dictionary_id_);
+			_gpak_decoder_release(pak, decoder);
+		}
+		free(source);
+
+		if (decoded != uncompressed_size)
+			request->error_ = GPAK_ERROR_FILE_CRC_NOT_MATCH;
+	}
+
+	if (request->error_ == GPAK_ERROR_OK && _gpak_crc32_bytes(buffer, uncompressed_size) != entry->crc32_)
+		request->error_ = GPAK_ERROR_FILE_CRC_NOT_MATCH;
+
+	if (request->error_ != GPAK_ERROR_OK)
+	{
+		_gpak_set_thread_path(request->path_);
+		_gpak_make_error(pak, request->error_);
+		_gpak_set_thread_path(NULL);
+		free(buffer);
+	}
+	else
+	{
+		// Entries within the budget are kept decoded for the next handles
+		request->view_.cached_ = _gpak_entry_cache_insert(pak->entry_cache_, request->file_info_, buffer, uncompressed_size, 0);
+		if (!request->view_.cached_)
+			request->view_.buffer_ = buffer;
+
+		request->view_.data_ = request->view_.cached_ ? _gpak_cached_entry_data(request->view_.cached_) : buffer;
+		request->view_.size_ = entry->uncompressed_size_;
+	}
+
+	_gpak_async_finish(request, 1);
+}
+
+void _gpak_async_run(struct gpak_async* _async, struct gpak_async_request* _request, gpak_task_func_t _func)
+{
+	_gpak_mutex_lock(&_async->mutex_);
+	++_async->jobs_;
+	_gpak_mutex_unlock(&_async->mutex_);
+
+	if (_async->pool_)
+		_gpak_thread_pool_submit(_async->pool_, _func, _request);
+	else
+		_func(_request);
 }
 
-int gpak_ungetc(gpak_file_t* _file, int _character)
+// Hands the payloads waiting for a free slot to the ring, a single read is capped below the kernel limit
+void _gpak_async_queue_reads(struct gpak_async* _async)
 {
-	return ungetc(_character, _file->stream_);
+	while (_async->waiting_head_)
+	{
+		struct gpak_async_request* request = _async->waiting_head_;
+		uint64_t remaining = request->file_info_->entry_.compressed_size_ - request->readed_;
+		uint32_t size = remaining > 0x40000000ull ? 0x40000000u : (uint32_t)remaining;
+
+		if (!_gpak_uring_queue_read(_async->ring_, _async->descriptor_, request->file_info_->entry_.offset_ + request->readed_, request->payload_ + request->readed_, size, (uint64_t)(uintptr_t)request))
+			break;
+
+		_async->waiting_head_ = request->next_;
+		if (!_async->waiting_head_)
+			_async->waiting_tail_ = NULL;
+		request->next_ = NULL;
+	}
+
+	if (_gpak_uring_submit(_async->ring_))
+		return;
+
+	// Reads the kernel refused would never complete, they are served by gpak_fmap on a worker instead
+	uint64_t user_data = 0ull;
+	while (_gpak_uring_drop(_async->ring_, &user_data))
+	{
+		struct gpak_async_request* request = (struct gpak_async_request*)(uintptr_t)user_data;
+		free(request->payload_);
+		request->payload_ = NULL;
+		request->readed_ = 0ull;
+
+		_gpak_async_run(_async, request, _gpak_async_map_job);
+	}
 }
 
-size_t gpak_fread(void* _buffer, size_t _elemSize, size_t _elemCount, gpak_file_t* _file)
+void _gpak_async_reap(struct gpak_async* _async, int _wait)
 {
-	return fread(_buffer, _elemSize, _elemCount, _file->stream_);
+	uint64_t user_data = 0ull;
+	int32_t result = 0;
+	while (_gpak_uring_reap(_async->ring_, &user_data, &result, _wait))
+	{
+		_wait = 0;
+
+		struct gpak_async_request* request = (struct gpak_async_request*)(uintptr_t)user_data;
+		if (result <= 0)
+		{
+			free(request->payload_);
+			request->payload_ = NULL;
+			request->error_ = GPAK_ERROR_READ;
+
+			_gpak_set_thread_path(request->path_);
+			_gpak_make_error(_async->pak_, GPAK_ERROR_READ);
+			_gpak_set_thread_path(NULL);
+
+			_gpak_async_finish(request, 0);
+			continue;
+		}
+
+		request->readed_ += (uint64_t)result;
+		if (request->readed_ < request->file_info_->entry_.compressed_size_)
+		{
+			// Short reads are queued again for the rest of the payload
+			request->next_ = _async->waiting_head_;
+			_async->waiting_head_ = request;
+			if (!_async->waiting_tail_)
+				_async->waiting_tail_ = request;
+		}
+		else
+			_gpak_async_run(_async, request, _gpak_async_decode_job);
+	}
 }
 
-long gpak_ftell(gpak_file_t* _file)
+gpak_async_t* gpak_async_create(gpak_t* _pak, uint32_t _queue_depth)
 {
-	return ftell(_file->stream_);
+	gpak_async_t* async = (gpak_async_t*)calloc(1, sizeof(gpak_async_t));
+	async->pak_ = _pak;
+	async->descriptor_ = -1;
+	_gpak_mutex_init(&async->mutex_);
+	_gpak_cond_init(&async->cond_);
+
+	// Jobs may decode chunked entries on the archive pool, they get their own workers so that they never wait on themselves
+	async->pool_ = _gpak_thread_pool_create(0u);
+
+#ifndef _WIN32
+	if (!_pak->memory_ && _pak->stream_)
+	{
+		async->ring_ = _gpak_uring_create(_queue_depth ? _queue_depth : GPAK_ASYNC_QUEUE_DEPTH);
+		if (async->ring_)
+			async->descriptor_ = fileno(_pak->stream_);
+	}
+#else
+	(void)_queue_depth;
+#endif
+
+	return async;
 }
 
-long gpak_fseek(gpak_file_t* _file, long _offset, int _origin)
+int gpak_async_read(gpak_async_t* _async, const char* _path, gpak_read_handler_t _handler, void* _user_data)
 {
-	return fseek(_file->stream_, _offset, _origin);
+	gpak_t* pak = _async->pak_;
+
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(pak, _path);
+	if (!_file_info)
+	{
+		_gpak_set_thread_path(_path);
+		_gpak_make_error(pak, GPAK_ERROR_FILE_NOT_FOUND);
+		_gpak_set_thread_path(NULL);
+		return GPAK_ERROR_FILE_NOT_FOUND;
+	}
+
+	struct gpak_async_request* request = (struct gpak_async_request*)calloc(1, sizeof(struct gpak_async_request));
+	request->async_ = _async;
+	request->file_info_ = _file_info;
+	request->handler_ = _handler;
+	request->user_data_ = _user_data;
+
+	size_t path_length = strlen(_path);
+	request->path_ = (char*)malloc(path_length + 1ull);
+	memcpy(request->path_, _path, path_length + 1ull);
+
+	++_async->pending_;
+
+	// Entries already decoded complete at once
+	request->view_.cached_ = _gpak_entry_cache_acquire(pak->entry_cache_, _file_info);
+	if (request->view_.cached_)
+	{
+		request->view_.data_ = _gpak_cached_entry_data(request->view_.cached_);
+		request->view_.size_ = _file_info->entry_.uncompressed_size_;
+		_gpak_async_finish(request, 0);
+		return GPAK_ERROR_OK;
+	}
+
+	// Plain payloads go through the ring, blocks, chunks and shared payloads are decoded by gpak_fmap on a worker
+	const pak_entry_t* entry = &_file_info->entry_;
+	if (!_async->ring_ || (entry->flags_ & (GPAK_ENTRY_FLAG_CHUNKED | GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_SHARED | GPAK_ENTRY_FLAG_CHUNK_LIST)))
+	{
+		_gpak_async_run(_async, request, _gpak_async_map_job);
+		return GPAK_ERROR_OK;
+	}
+
+	int compressed = (pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)) != 0;
+	request->stored_ = !compressed && entry->compressed_size_ == entry->uncompressed_size_;
+	request->payload_ = (char*)malloc(entry->compressed_size_ + 1ull);
+	request->payload_[entry->compressed_size_] = '\0';
+
+	if (entry->compressed_size_ == 0ull)
+	{
+		_gpak_async_run(_async, request, _gpak_async_decode_job);
+		return GPAK_ERROR_OK;
+	}
+
+	if (_async->waiting_tail_)
+		_async->waiting_tail_->next_ = request;
+	else
+		_async->waiting_head_ = request;
+	_async->waiting_tail_ = request;
+
+	_gpak_async_queue_reads(_async);
+
+	return GPAK_ERROR_OK;
 }
 
-long gpak_feof(gpak_file_t* _file)
+uint32_t gpak_async_poll(gpak_async_t* _async, int _wait)
+{
+	uint32_t delivered = 0u;
+	for (;;)
+	{
+		if (_async->ring_)
+		{
+			_gpak_async_reap(_async, 0);
+			_gpak_async_queue_reads(_async);
+		}
+
+		_gpak_mutex_lock(&_async->mutex_);
+		struct gpak_async_request* request = _async->done_head_;
+		_async->done_head_ = _async->done_tail_ = NULL;
+		_gpak_mutex_unlock(&_async->mutex_);
+
+		while (request)
+		{
+			struct gpak_async_request* next = request->next_;
+
+			if (request->handler_)
+				request->handler_(request->path_, request->error_, &request->view_, request->user_data_);
+			else
+				gpak_funmap(&request->view_);
+
+			free(request->path_);
+			free(request);
+
+			--_async->pending_;
+			++delivered;
+			request = next;
+		}
+
+		if (delivered > 0u || !_wait || _async->pending_ == 0u)
+			return delivered;
+
+		// Block on the ring while only reads are in flight, on the workers otherwise
+		_gpak_mutex_lock(&_async->mutex_);
+		if (!_async->done_head_ && _async->jobs_ == 0u && _async->ring_ && _gpak_uring_in_flight(_async->ring_) > 0u)
+		{
+			_gpak_mutex_unlock(&_async->mutex_);
+			_gpak_async_reap(_async, 1);
+			continue;
+		}
+
+		while (!_async->done_head_ && _async->jobs_ > 0u)
+			_gpak_cond_wait(&_async->cond_, &_async->mutex_);
+		_gpak_mutex_unlock(&_async->mutex_);
+	}
+}
+
+uint32_t gpak_async_pending(gpak_async_t* _async)
 {
-	return feof(_file->stream_);
+	return _async->pending_;
 }
 
-void gpak_fclose(gpak_file_t* _file)
+void gpak_async_free(gpak_async_t* _async)
 {
-	free(_file->data_);
-	fclose(_file->stream_);
-	free(_file);
+	while (_async->pending_ > 0u)
+		gpak_async_poll(_async, 1);
+
+	_gpak_thread_pool_free(_async->pool_);
+	_gpak_uring_free(_async->ring_);
+	_gpak_cond_destroy(&_async->cond_);
+	_gpak_mutex_destroy(&_async->mutex_);
+	free(_async);
+}
+
+struct gpak_queue_request
+{
+	uint64_t id_;
+	char* path_;
+	filesystem_tree_file_t* file_info_;
+	int32_t priority_;
+	uint64_t deadline_;
+	gpak_read_handler_t handler_;
+	void* user_data_;
+	gpak_file_t* file_;
+	char* buffer_;
+	uint64_t decoded_;
+	size_t heap_index_;
+	int cancelled_;
+	int32_t error_;
+	gpak_view_t view_;
+	struct gpak_queue_request* next_;
+};
+
+struct gpak_queue_worker
+{
+	struct gpak_queue* queue_;
+	gpak_thread_t thread_;
+	struct gpak_queue_request* request_;
+};
+
+struct gpak_queue
+{
+	gpak_t* pak_;
+	gpak_mutex_t mutex_;
+	gpak_cond_t work_cond_;
+	gpak_cond_t done_cond_;
+	struct gpak_queue_worker* workers_;
+	uint32_t worker_count_;
+	struct gpak_queue_request** heap_;
+	size_t heap_count_;
+	size_t heap_capacity_;
+	struct gpak_queue_request* done_head_;
+	struct gpak_queue_request* done_tail_;
+	uint64_t next_id_;
+	uint32_t pending_;
+	int stop_;
+};
+
+// Higher priority first, then earliest deadline, then oldest request
+int _gpak_queue_before(const struct gpak_queue_request* _left, const struct gpak_queue_request* _right)
+{
+	if (_left->priority_ != _right->priority_)
+		return _left->priority_ > _right->priority_;
+	if (_left->deadline_ != _right->deadline_)
+		return _left->deadline_ != 0ull && (_right->deadline_ == 0ull || _left->deadline_ < _right->deadline_);
+	return _left->id_ < _right->id_;
+}
+
+void _gpak_queue_heap_set(struct gpak_queue* _queue, size_t _index, struct gpak_queue_request* _request)
+{
+	_queue->heap_[_index] = _request;
+	_request->heap_index_ = _index;
+}
+
+void _gpak_queue_heap_sift(struct gpak_queue* _queue, size_t _index)
+{
+	struct gpak_queue_request* request = _queue->heap_[_index];
+
+	while (_index > 0ull && _gpak_queue_before(request, _queue->heap_[(_index - 1ull) / 2ull]))
+	{
+		_gpak_queue_heap_set(_queue, _index, _queue->heap_[(_index - 1ull) / 2ull]);
+		_index = (_index - 1ull) / 2ull;
+	}
+
+	for (;;)
+	{
+		size_t child = _index * 2ull + 1ull;
+		if (child >= _queue->heap_count_)
+			break;
+		if (child + 1ull < _queue->heap_count_ && _gpak_queue_before(_queue->heap_[child + 1ull], _queue->heap_[child]))
+			++child;
+		if (!_gpak_queue_before(_queue->heap_[child], request))
+			break;
+
+		_gpak_queue_heap_set(_queue, _index, _queue->heap_[child]);
+		_index = child;
+	}
+
+	_gpak_queue_heap_set(_queue, _index, request);
+}
+
+void _gpak_queue_heap_push(struct gpak_queue* _queue, struct gpak_queue_request* _request)
+{
+	if (_queue->heap_count_ == _queue->heap_capacity_)
+	{
+		_queue->heap_capacity_ = _queue->heap_capacity_ ? _queue->heap_capacity_ * 2ull : 64ull;
+		_queue->heap_ = (struct gpak_queue_request**)realloc(_queue->heap_, sizeof(struct gpak_queue_request*) * _queue->heap_capacity_);
+	}
+
+	_gpak_queue_heap_set(_queue, _queue->heap_count_++, _request);
+	_gpak_queue_heap_sift(_queue, _request->heap_index_);
+}
+
+void _gpak_queue_heap_remove(struct gpak_queue* _queue, size_t _index)
+{
+	struct gpak_queue_request* last = _queue->heap_[--_queue->heap_count_];
+	if (_index == _queue->heap_count_)
+		return;
+
+	_gpak_queue_heap_set(_queue, _index, last);
+	_gpak_queue_heap_sift(_queue, _index);
+}
+
+// Hands a request over to gpak_queue_poll, the queue lock must be held
+void _gpak_queue_finish(struct gpak_queue* _queue, struct gpak_queue_request* _request)
+{
+	if (_request->error_ != GPAK_ERROR_OK)
+	{
+		gpak_funmap(&_request->view_);
+		free(_request->buffer_);
+		_request->buffer_ = NULL;
+	}
+
+	if (_request->file_)
+	{
+		gpak_fclose(_request->file_);
+		_request->file_ = NULL;
+	}
+
+	if (_queue->done_tail_)
+		_queue->done_tail_->next_ = _request;
+	else
+		_queue->done_head_ = _request;
+	_queue->done_tail_ = _request;
+	_request->next_ = NULL;
+
+	_gpak_cond_broadcast(&_queue->done_cond_);
+}
+
+// Checks whether a request was cancelled or missed its deadline, the queue lock must be held
+int _gpak_queue_interrupted(struct gpak_queue_request* _request)
+{
+	if (_request->cancelled_)
+		_request->error_ = GPAK_ERROR_CANCELLED;
+	else if (_request->deadline_ != 0ull && _gpak_time_ms() > _request->deadline_)
+		_request->error_ = GPAK_ERROR_DEADLINE_EXCEEDED;
+
+	return _request->error_ != GPAK_ERROR_OK;
+}
+
+// Reads and decodes a request, returns 1 if it gave way to a request of higher priority
+int _gpak_queue_process(struct gpak_queue* _queue, struct gpak_queue_request* _request)
+{
+	gpak_t* pak = _queue->pak_;
+	const pak_entry_t* entry = &_request->file_info_->entry_;
+
+	if (!_request->file_)
+	{
+		_request->view_.cached_ = _gpak_entry_cache_acquire(pak->entry_cache_, _request->file_info_);
+		if (_request->view_.cached_)
+		{
+			_request->view_.data_ = _gpak_cached_entry_data(_request->view_.cached_);
+			_request->view_.size_ = entry->uncompressed_size_;
+			return 0;
+		}
+
+		// Only chunked files can be interrupted, other files are decoded at once
+		if (!(entry->flags_ & GPAK_ENTRY_FLAG_CHUNKED))
+		{
+			_request->error_ = gpak_fmap(pak, _request->path_, &_request->view_, 1);
+			return 0;
+		}
+
+		_gpak_set_thread_path(_request->path_);
+		_request->file_ = _gpak_fopen_chunked(pak, _request->file_info_);
+		_gpak_set_thread_path(NULL);
+		if (!_request->file_)
+		{
+			_request->error_ = _gpak_last_error() != GPAK_ERROR_OK ? _gpak_last_error() : GPAK_ERROR_READ;
+			return 0;
+		}
+
+		_request->buffer_ = (char*)malloc(entry->uncompressed_size_ + 1ull);
+		_request->buffer_[entry->uncompressed_size_] = '\0';
+	}
+
+	uint64_t chunk_size = _request->file_->chunk_table_.chunk_size_;
+	while (_request->decoded_ < entry->uncompressed_size_)
+	{
+		uint64_t remaining = entry->uncompressed_size_ - _request->decoded_;
+		size_t step = (size_t)(remaining < chunk_size ? remaining : chunk_size);
+
+		_gpak_set_thread_path(_request->path_);
+		size_t readed = _gpak_fread_chunked(_request->buffer_ + _request->decoded_, step, _request->file_);
+		_gpak_set_thread_path(NULL);
+		if (readed != step)
+		{
+			_request->error_ = _gpak_last_error() != GPAK_ERROR_OK ? _gpak_last_error() : GPAK_ERROR_READ;
+			return 0;
+		}
+
+		_request->decoded_ += step;
+		if (_request->decoded_ == entry->uncompressed_size_)
+			break;
+
+		_gpak_mutex_lock(&_queue->mutex_);
+		int interrupted = _gpak_queue_interrupted(_request);
+		int preempted = !interrupted && _queue->heap_count_ > 0ull && _queue->heap_[0]->priority_ > _request->priority_;
+		_gpak_mutex_unlock(&_queue->mutex_);
+
+		if (interrupted || preempted)
+			return preempted;
+	}
+
+	_request->view_.buffer_ = _request->buffer_;
+	_request->view_.data_ = _request->buffer_;
+	_request->view_.size_ = entry->uncompressed_size_;
+	_request->buffer_ = NULL;
+
+	return 0;
+}
+
+void _gpak_queue_worker(void* _arg)
+{
+	struct gpak_queue_worker* worker = (struct gpak_queue_worker*)_arg;
+	struct gpak_queue* queue = worker->queue_;
+
+	_gpak_mutex_lock(&queue->mutex_);
+	for (;;)
+	{
+		while (!queue->stop_ && queue->heap_count_ == 0ull)
+			_gpak_cond_wait(&queue->work_cond_, &queue->mutex_);
+
+		if (queue->stop_)
+			break;
+
+		struct gpak_queue_request* request = queue->heap_[0];
+		_gpak_queue_heap_remove(queue, 0ull);
+
+		// Requests past their deadline are dropped without being read
+		if (_gpak_queue_interrupted(request))
+		{
+			_gpak_queue_finish(queue, request);
+			continue;
+		}
+
+		worker->request_ = request;
+		_gpak_mutex_unlock(&queue->mutex_);
+
+		int preempted = _gpak_queue_process(queue, request);
+
+		_gpak_mutex_lock(&queue->mutex_);
+		worker->request_ = NULL;
+
+		// A request that gave way goes back to the queue with its progress, unless the queue is being freed
+		if (preempted && !queue->stop_)
+			_gpak_queue_heap_push(queue, request);
+		else
+		{
+			if (request->error_ == GPAK_ERROR_OK && request->cancelled_)
+				request->error_ = GPAK_ERROR_CANCELLED;
+			_gpak_queue_finish(queue, request);
+		}
+	}
+	_gpak_mutex_unlock(&queue->mutex_);
+}
+
+gpak_queue_t* gpak_queue_create(gpak_t* _pak, uint32_t _thread_count)
+{
+	if (_thread_count == 0u)
+		_thread_count = _gpak_hardware_concurrency();
+
+	gpak_queue_t* queue = (gpak_queue_t*)calloc(1, sizeof(gpak_queue_t));
+	queue->pak_ = _pak;
+	_gpak_mutex_init(&queue->mutex_);
+	_gpak_cond_init(&queue->work_cond_);
+	_gpak_cond_init(&queue->done_cond_);
+
+	queue->workers_ = (struct gpak_queue_worker*)calloc(_thread_count, sizeof(struct gpak_queue_worker));
+	for (uint32_t idx = 0u; idx < _thread_count; ++idx)
+	{
+		struct gpak_queue_worker* worker = &queue->workers_[queue->worker_count_];
+		worker->queue_ = queue;
+		if (_gpak_thread_create(&worker->thread_, &_gpak_queue_worker, worker) == 0)
+			++queue->worker_count_;
+	}
+
+	if (queue->worker_count_ == 0u)
+	{
+		gpak_queue_free(queue);
+		return NULL;
+	}
+
+	return queue;
+}
+
+uint64_t gpak_queue_request(gpak_queue_t* _queue, const char* _path, int32_t _priority, uint32_t _deadline_ms, gpak_read_handler_t _handler, void* _user_data)
+{
+	filesystem_tree_file_t* _file_info = _gpak_find_entry(_queue->pak_, _path);
+	if (!_file_info)
+	{
+		_gpak_set_thread_path(_path);
+		_gpak_make_error(_queue->pak_, GPAK_ERROR_FILE_NOT_FOUND);
+		_gpak_set_thread_path(NULL);
+		return 0ull;
+	}
+
+	struct gpak_queue_request* request = (struct gpak_queue_request*)calloc(1, sizeof(struct gpak_queue_request));
+	request->file_info_ = _file_info;
+	request->priority_ = _priority;
+	request->deadline_ = _deadline_ms ? _gpak_time_ms() + _deadline_ms : 0ull;
+	request->handler_ = _handler;
+	request->user_data_ = _user_data;
+
+	size_t path_length = strlen(_path);
+	request->path_ = (char*)malloc(path_length + 1ull);
+	memcpy(request->path_, _path, path_length + 1ull);
+
+	// A worker may finish and free the request as soon as the lock is released
+	_gpak_mutex_lock(&_queue->mutex_);
+	uint64_t id = ++_queue->next_id_;
+	request->id_ = id;
+	_gpak_queue_heap_push(_queue, request);
+	++_queue->pending_;
+	_gpak_cond_signal(&_queue->work_cond_);
+	_gpak_mutex_unlock(&_queue->mutex_);
+
+	return id;
+}
+
+int gpak_queue_cancel(gpak_queue_t* _queue, uint64_t _request)
+{
+	int found = 0;
+	_gpak_mutex_lock(&_queue->mutex_);
+
+	for (size_t idx = 0ull; !found && idx < _queue->heap_count_; ++idx)
+	{
+		struct gpak_queue_request* request = _queue->heap_[idx];
+		if (request->id_ == _request)
+		{
+			_gpak_queue_heap_remove(_queue, idx);
+			request->error_ = GPAK_ERROR_CANCELLED;
+			_gpak_queue_finish(_queue, request);
+			found = 1;
+		}
+	}
+
+	// Running requests stop at their next chunk boundary
+	for (uint32_t idx = 0u; !found && idx < _queue->worker_count_; ++idx)
+	{
+		struct gpak_queue_request* request = _queue->workers_[idx].request_;
+		if (request && request->id_ == _request)
+		{
+			request->cancelled_ = 1;
+			found = 1;
+		}
+	}
+
+	// Completed requests waiting for their handler drop their content
+	for (struct gpak_queue_request* request = _queue->done_head_; !found && request; request = request->next_)
+	{
+		if (request->id_ == _request)
+		{
+			if (request->error_ != GPAK_ERROR_CANCELLED)
+			{
+				request->error_ = GPAK_ERROR_CANCELLED;
+				gpak_funmap(&request->view_);
+			}
+			found = 1;
+		}
+	}
+
+	_gpak_mutex_unlock(&_queue->mutex_);
+	return found;
+}
+
+int gpak_queue_set_priority(gpak_queue_t* _queue, uint64_t _request, int32_t _priority)
+{
+	int found = 0;
+	_gpak_mutex_lock(&_queue->mutex_);
+
+	for (size_t idx = 0ull; !found && idx < _queue->heap_count_; ++idx)
+	{
+		struct gpak_queue_request* request = _queue->heap_[idx];
+		if (request->id_ == _request)
+		{
+			request->priority_ = _priority;
+			_gpak_queue_heap_sift(_queue, idx);
+			found = 1;
+		}
+	}
+
+	for (uint32_t idx = 0u; !found && idx < _queue->worker_count_; ++idx)
+	{
+		struct gpak_queue_request* request = _queue->workers_[idx].request_;
+		if (request && request->id_ == _request)
+		{
+			request->priority_ = _priority;
+			found = 1;
+		}
+	}
+
+	_gpak_mutex_unlock(&_queue->mutex_);
+	return found;
+}
+
+uint32_t gpak_queue_poll(gpak_queue_t* _queue, int _wait)
+{
+	_gpak_mutex_lock(&_queue->mutex_);
+	while (_wait && !_queue->done_head_ && _queue->pending_ > 0u)
+		_gpak_cond_wait(&_queue->done_cond_, &_queue->mutex_);
+
+	struct gpak_queue_request* request = _queue->done_head_;
+	_queue->done_head_ = _queue->done_tail_ = NULL;
+	_gpak_mutex_unlock(&_queue->mutex_);
+
+	uint32_t delivered = 0u;
+	while (request)
+	{
+		struct gpak_queue_request* next = request->next_;
+
+		if (request->handler_)
+			request->handler_(request->path_, request->error_, &request->view_, request->user_data_);
+		else
+			gpak_funmap(&request->view_);
+
+		free(request->path_);
+		free(request);
+
+		++delivered;
+		request = next;
+	}
+
+	_gpak_mutex_lock(&_queue->mutex_);
+	_queue->pending_ -= delivered;
+	_gpak_mutex_unlock(&_queue->mutex_);
+
+	return delivered;
+}
+
+uint32_t gpak_queue_pending(gpak_queue_t* _queue)
+{
+	_gpak_mutex_lock(&_queue->mutex_);
+	uint32_t pending = _queue->pending_;
+	_gpak_mutex_unlock(&_queue->mutex_);
+
+	return pending;
+}
+
+void gpak_queue_free(gpak_queue_t* _queue)
+{
+	_gpak_mutex_lock(&_queue->mutex_);
+	while (_queue->heap_count_ > 0ull)
+	{
+		struct gpak_queue_request* request = _queue->heap_[_queue->heap_count_ - 1ull];
+		_gpak_queue_heap_remove(_queue, _queue->heap_count_ - 1ull);
+		request->error_ = GPAK_ERROR_CANCELLED;
+		_gpak_queue_finish(_queue, request);
+	}
+
+	for (uint32_t idx = 0u; idx < _queue->worker_count_; ++idx)
+	{
+		if (_queue->workers_[idx].request_)
+			_queue->workers_[idx].request_->cancelled_ = 1;
+	}
+
+	_queue->stop_ = 1;
+	_gpak_cond_broadcast(&_queue->work_cond_);
+	_gpak_mutex_unlock(&_queue->mutex_);
+
+	for (uint32_t idx = 0u; idx < _queue->worker_count_; ++idx)
+		_gpak_thread_join(_queue->workers_[idx].thread_);
+
+	while (_queue->pending_ > 0u && gpak_queue_poll(_queue, 0) > 0u);
+
+	_gpak_cond_destroy(&_queue->done_cond_);
+	_gpak_cond_destroy(&_queue->work_cond_);
+	_gpak_mutex_destroy(&_queue->mutex_);
+	free(_queue->heap_);
+	free(_queue->workers_);
+	free(_queue);
 }
\ No newline at end of file
@@ -41,6 +41,18 @@ extern "C" {
 	 */
 	GPAK_API gpak_t* gpak_open(const char* _path, int _mode);
 
+	/**
+	 * @brief Opens a G-PAK archive image that is already in memory.
+	 *
+	 * This function opens the archive read-only, for example an archive linked into the executable. The header, the central
+	 * directory and the payloads are read directly from _data, which must stay valid until the archive is closed.
+	 *
+	 * @param _data A pointer to the archive image.
+	 * @param _size The size of the archive image in bytes.
+	 * @return A pointer to the opened gpak_t or NULL if the image is not a valid archive.
+	 */
+	GPAK_API gpak_t* gpak_open_memory(const void* _data, size_t _size);
+
 	/**
 	 * @brief Closes a G-PAK archive.
 	 *
@@ -71,6 +83,16 @@ extern "C" {
 	 */
 	GPAK_API void gpak_set_error_handler(gpak_t* _pak, gpak_error_handler_t _error_handler);
 
+	/**
+	 * @brief Returns the last error code reported on the calling thread.
+	 *
+	 * This function returns the error code of the last failed operation made by the calling thread. Errors are tracked per
+	 * thread rather than per archive, so several threads can read from one gpak_t without seeing each other's errors.
+	 *
+	 * @return The last error code of the calling thread, or GPAK_ERROR_OK if no operation failed on it.
+	 */
+	GPAK_API int gpak_get_last_error();
+
 	/**
 	 * @brief Sets a progress handler for a G-PAK archive.
 	 *
@@ -101,6 +123,178 @@ extern "C" {
 	 */
 	GPAK_API void gpak_set_compression_level(gpak_t* _pak, int _level);
 
+	/**
+	 * @brief Sets the chunk size for a G-PAK archive.
+	 *
+	 * When the chunk size is not zero, files larger than one chunk are split into chunks of _chunk_size bytes that are
+	 * compressed independently and indexed by a per-entry seek table with per-chunk checksums. Seeking in such a file
+	 * decodes only the chunk covering the new position, and large reads decode several chunks in parallel.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _chunk_size The uncompressed chunk size in bytes, or 0 to store every file as a single stream.
+	 */
+	GPAK_API void gpak_set_chunk_size(gpak_t* _pak, uint32_t _chunk_size);
+
+	/**
+	 * @brief Sets the solid block size for a G-PAK archive.
+	 *
+	 * When the block size is not zero, files smaller than _block_size bytes are concatenated into solid blocks of at most
+	 * _block_size bytes that are compressed as a single frame. Opening a file from a solid block decodes the whole block,
+	 * the most recently used blocks stay decoded so sibling files are read without decompressing the block again.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _block_size The uncompressed solid block size in bytes, or 0 to store every file on its own.
+	 */
+	GPAK_API void gpak_set_solid_block_size(gpak_t* _pak, uint32_t _block_size);
+
+	/**
+	 * @brief Enables content-defined chunk deduplication for a G-PAK archive.
+	 *
+	 * When the average chunk size is not zero, files larger than it are split with a rolling hash into chunks of a quarter
+	 * to four times that size whose boundaries depend on the content, so that byte runs shared by different files produce
+	 * identical chunks. Every distinct chunk is compressed and stored once, entries are described as lists of chunks and are
+	 * reassembled transparently by gpak_fopen. Content chunking takes precedence over gpak_set_chunk_size.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _average_chunk_size The average chunk size in bytes, or 0 to disable content chunking.
+	 */
+	GPAK_API void gpak_set_content_chunking(gpak_t* _pak, uint32_t _average_chunk_size);
+
+	/**
+	 * @brief Sets the size from which files are streamed from a G-PAK archive.
+	 *
+	 * When the threshold is not zero, gpak_fopen does not decode files of at least _threshold bytes as a whole. The file
+	 * is decoded into a ring of two fixed windows instead, the next window being decoded in the background while the
+	 * current one is read, so memory use does not depend on the file size. The checksum is accumulated as the file is
+	 * decoded and a mismatch is reported through the error handler when the end of the file is read. Seeking backwards
+	 * decodes the file again from its start. Files from solid blocks and deduplicated chunk lists are never streamed.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _threshold The uncompressed file size in bytes from which files are streamed, or 0 to disable streaming.
+	 */
+	GPAK_API void gpak_set_stream_threshold(gpak_t* _pak, uint64_t _threshold);
+
+	/**
+	 * @brief Enables decoding files of a G-PAK archive in place.
+	 *
+	 * When enabled, the compressed payload of a plain file of a zstd or uncompressed archive is read into the tail of the
+	 * buffer gpak_fopen decodes it into, and decoded from there. No staging buffer is used, so the peak memory of opening
+	 * a file is its decoded size plus a small margin, see gpak_get_in_place_size. Archives read from memory are always
+	 * decoded straight from their image and deflate payloads are staged as usual.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _enabled Whether to decode files in place.
+	 */
+	GPAK_API void gpak_set_in_place_decoding(gpak_t* _pak, int _enabled);
+
+	/**
+	 * @brief Returns the size of a buffer able to decode a file of a G-PAK archive in place.
+	 *
+	 * gpak_read_entry_into decodes the file in place when in place decoding is enabled and its buffer is at least that large.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @return The uncompressed size of the file plus the in place margin, the uncompressed size if the file cannot be
+	 * decoded in place, or 0 if the file cannot be found.
+	 */
+	GPAK_API uint64_t gpak_get_in_place_size(gpak_t* _pak, const char* _path);
+
+	/**
+	 * @brief Sets the memory budget of the decoded entry cache of a G-PAK archive.
+	 *
+	 * When the budget is not zero, files decoded as a whole by gpak_fopen are kept decoded while they fit in _budget bytes.
+	 * Opening such a file again shares the decoded content read-only instead of decoding it again, the content stays
+	 * alive as long as a handle or a view references it. The least recently used entries nobody references are evicted
+	 * when the cache grows over the budget. Chunked and streamed files are not cached unless they are pinned.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _budget The number of decoded bytes the cache may hold, or 0 to disable caching of unpinned entries.
+	 */
+	GPAK_API void gpak_set_entry_cache_budget(gpak_t* _pak, uint64_t _budget);
+
+	/**
+	 * @brief Returns the counters of the decoded entry cache of a G-PAK archive.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _stats A pointer to the gpak_cache_stats_t to fill.
+	 */
+	GPAK_API void gpak_get_cache_stats(gpak_t* _pak, gpak_cache_stats_t* _stats);
+
+	/**
+	 * @brief Sets the rule that groups files for zstd dictionary training.
+	 *
+	 * When the archive is created with zstd compression, a separate dictionary is trained for every class of files that
+	 * has enough samples, and each entry is compressed with the dictionary of its class. The classifier receives the
+	 * internal path and the user data and returns the class name, or NULL to use the default dictionary. Without a
+	 * classifier files are grouped by their lowercase extension.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _classifier The classifier callback, or NULL to group files by extension.
+	 */
+	GPAK_API void gpak_set_dictionary_classifier(gpak_t* _pak, gpak_dictionary_classifier_t _classifier);
+
+	/**
+	 * @brief Packs a new G-PAK archive with registered shared dictionaries instead of its own.
+	 *
+	 * The archive does not train or embed dictionaries, it stores the content id of the dictionary file and compresses
+	 * every entry with the dictionary of its class. The same dictionary file has to be registered with
+	 * gpak_register_dictionary before the archive is opened for reading.
+	 *
+	 * @param _pak A pointer to the gpak_t opened in create mode.
+	 * @param _content_id The content id returned by gpak_register_dictionary.
+	 * @return GPAK_ERROR_OK on success, GPAK_ERROR_DICTIONARY_NOT_REGISTERED if the dictionaries are not registered,
+	 *         or GPAK_ERROR_INVALID_DICTIONARY if the archive is not being created.
+	 */
+	GPAK_API int gpak_set_shared_dictionary(gpak_t* _pak, uint64_t _content_id);
+
+	/**
+	 * @brief Saves the dictionaries of a G-PAK archive to a standalone dictionary file.
+	 *
+	 * The file can be registered with gpak_register_dictionary and shared by many archives, for example the patches
+	 * and downloadable content of a base archive packed with trained dictionaries.
+	 *
+	 * @param _pak A pointer to the gpak_t opened for reading or updating.
+	 * @param _path The path of the dictionary file to write.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the archive has no dictionaries or the file cannot be written.
+	 */
+	GPAK_API int gpak_save_dictionary(gpak_t* _pak, const char* _path);
+
+	/**
+	 * @brief Loads a standalone dictionary file into the process-wide dictionary registry.
+	 *
+	 * The dictionaries are loaded and prepared once and used by every archive that references them. Registering the
+	 * same file again only returns its content id.
+	 *
+	 * @param _path The path of the dictionary file.
+	 * @param _content_id A pointer that receives the content id of the dictionaries, may be NULL.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the file cannot be read or is corrupted.
+	 */
+	GPAK_API int gpak_register_dictionary(const char* _path, uint64_t* _content_id);
+
+	/**
+	 * @brief Removes a dictionary file from the process-wide dictionary registry.
+	 *
+	 * Archives that are still open keep using the dictionaries, they are freed when the last one is closed.
+	 *
+	 * @param _content_id The content id returned by gpak_register_dictionary.
+	 * @return GPAK_ERROR_OK on success, or GPAK_ERROR_DICTIONARY_NOT_REGISTERED if no dictionaries have this content id.
+	 */
+	GPAK_API int gpak_unregister_dictionary(uint64_t _content_id);
+
+	/**
+	 * @brief Sets the payload alignment for a new G-PAK archive.
+	 *
+	 * This function pads the archive so that every entry payload and solid block starts at a multiple of _alignment bytes
+	 * from the beginning of the archive, for example 4096 for memory mapping and direct I/O or 64 for cache line aligned reads.
+	 * The alignment is recorded in the archive header, readers can rely on it through header_.alignment_. Update mode keeps
+	 * the alignment of the existing archive.
+	 *
+	 * @param _pak A pointer to the gpak_t opened with GPAK_MODE_CREATE.
+	 * @param _alignment A power of two, or 0 to store payloads without padding.
+	 * @return GPAK_ERROR_OK on success, GPAK_ERROR_INVALID_ALIGNMENT otherwise.
+	 */
+	GPAK_API int gpak_set_alignment(gpak_t* _pak, uint32_t _alignment);
+
 	/**
 	 * @brief Adds a directory to a G-PAK archive.
 	 *
@@ -193,7 +387,8 @@ extern "C" {
 	/**
 	 * @brief Unreads a character from a G-PAK file.
 	 *
-	 * This function pushes back the specified _character into the G-PAK file's read buffer.
+	 * This function pushes back the specified _character, the next read returns it first. Like ungetc, only one character
+	 * can be pushed back at a time and the position in the payload is not changed, seeking drops it.
 	 *
 	 * @param _file A pointer to the gpak_file_t.
 	 * @param _character The character to unget.
@@ -254,6 +449,285 @@ extern "C" {
 	 */
 	GPAK_API void gpak_fclose(gpak_file_t* _file);
 
+	/**
+	 * @brief Returns the whole content of a file in a G-PAK archive.
+	 *
+	 * For archives opened with GPAK_MODE_MEMORY_MAP or gpak_open_memory, stored entries, those of an uncompressed archive
+	 * or of a stored solid block, are returned as a pointer into the archive image without any copy. Other entries are
+	 * decoded into a buffer owned by the view. Decoded entries are always checked against their CRC-32.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @param _view A pointer to the gpak_view_t receiving the content, release it with gpak_funmap.
+	 * @param _check_crc Whether entries returned in place are checked against their CRC-32 as well.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the file cannot be found or decoded.
+	 */
+	GPAK_API int gpak_fmap(gpak_t* _pak, const char* _path, gpak_view_t* _view, int _check_crc);
+
+	/**
+	 * @brief Releases a view returned by gpak_fmap.
+	 *
+	 * @param _view A pointer to the gpak_view_t to release.
+	 */
+	GPAK_API void gpak_funmap(gpak_view_t* _view);
+
+	/**
+	 * @brief Returns the codec, sizes, checksum and dictionary of the compressed payload of a file in a G-PAK archive.
+	 *
+	 * This function fills _raw without reading the payload, data_ is left NULL. Only plain entries have a payload of their
+	 * own, chunked files, files packed in solid blocks and deduplicated chunk lists are refused.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @param _raw A pointer to the gpak_raw_entry_t receiving the description of the payload.
+	 * @return GPAK_ERROR_OK on success, GPAK_ERROR_FILE_NOT_FOUND or GPAK_ERROR_NOT_PLAIN_ENTRY otherwise.
+	 */
+	GPAK_API int gpak_stat_raw(gpak_t* _pak, const char* _path, gpak_raw_entry_t* _raw);
+
+	/**
+	 * @brief Returns the compressed payload of a file in a G-PAK archive without decoding it.
+	 *
+	 * For archives opened with GPAK_MODE_MEMORY_MAP or gpak_open_memory the payload is returned as a pointer into the
+	 * archive image, otherwise it is read into a buffer owned by _raw. The payload is not checked, it can be handed to a
+	 * client decoding it with the codec and checking it against crc32_ on its own.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @param _raw A pointer to the gpak_raw_entry_t receiving the payload, release it with gpak_funmap_raw.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the file cannot be found, is not a plain entry or cannot be read.
+	 */
+	GPAK_API int gpak_fmap_raw(gpak_t* _pak, const char* _path, gpak_raw_entry_t* _raw);
+
+	/**
+	 * @brief Releases a payload returned by gpak_fmap_raw.
+	 *
+	 * @param _raw A pointer to the gpak_raw_entry_t to release.
+	 */
+	GPAK_API void gpak_funmap_raw(gpak_raw_entry_t* _raw);
+
+	/**
+	 * @brief Reads the compressed payload of a file in a G-PAK archive into a caller-provided buffer.
+	 *
+	 * This function uses a positional read, several threads may read payloads of the same archive at once.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @param _dst The destination buffer.
+	 * @param _dst_size The size of the destination buffer, at least the compressed size returned by gpak_stat_raw.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the file cannot be found, is not a plain entry or cannot be read.
+	 */
+	GPAK_API int gpak_read_raw(gpak_t* _pak, const char* _path, void* _dst, size_t _dst_size);
+
+	/**
+	 * @brief Decodes a file in a G-PAK archive into a caller-provided buffer.
+	 *
+	 * This function decodes the whole file straight into _dst, without the intermediate buffer of
+	 * gpak_fopen. Plain entries are decoded in a single pass from the compressed payload, which is not copied for archives
+	 * opened with GPAK_MODE_MEMORY_MAP or gpak_open_memory. The decoded content is checked against its CRC-32.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @param _dst The destination buffer.
+	 * @param _dst_size The size of the destination buffer, at least the uncompressed size of the file.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the file cannot be found or decoded.
+	 */
+	GPAK_API int gpak_read_entry_into(gpak_t* _pak, const char* _path, void* _dst, size_t _dst_size);
+
+	/**
+	 * @brief Reads many files of a G-PAK archive at once.
+	 *
+	 * This function resolves every path first and reads the payloads in archive order, payloads lying close to each
+	 * other are merged into one sequential read of up to GPAK_BATCH_READ_SIZE bytes. Solid blocks and shared payloads are
+	 * read and decoded once for all the files they hold, and the merged reads are decoded in parallel on the worker
+	 * threads of the archive. Every file is checked against its CRC-32.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _reads The files to read, see gpak_batch_read_t.
+	 * @param _count The number of files.
+	 * @return GPAK_ERROR_OK if every file was read, or the error code of the first file that could not be read.
+	 */
+	GPAK_API int gpak_read_batch(gpak_t* _pak, gpak_batch_read_t* _reads, size_t _count);
+
+	/**
+	 * @brief Extracts every file of a G-PAK archive to a directory.
+	 *
+	 * This function is gpak_extract_directory applied to the root of the archive.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _destination The directory the files are written to, created if it does not exist.
+	 * @return GPAK_ERROR_OK if every file was extracted, or the error code of a file that could not be extracted.
+	 */
+	GPAK_API int gpak_extract_all(gpak_t* _pak, const char* _destination);
+
+	/**
+	 * @brief Extracts a directory of a G-PAK archive and everything below it.
+	 *
+	 * This function recreates the directory tree under _destination on the worker threads, then reads the files in
+	 * archive order with gpak_read_batch, GPAK_EXTRACT_WINDOW_SIZE bytes of decoded content at a time, while writer threads
+	 * store every decoded file with a single write. Reading pauses once GPAK_EXTRACT_BUFFER_SIZE bytes wait to be written.
+	 * Files larger than a window are streamed to disk in writes of GPAK_EXTRACT_WRITE_SIZE bytes. Paths are written
+	 * relative to the extracted directory, names that would escape _destination are refused with GPAK_ERROR_UNSAFE_PATH.
+	 * Files that cannot be extracted are reported to the error handler and the others are still extracted.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the directory, or NULL to extract the whole archive.
+	 * @param _destination The directory the files are written to, created if it does not exist.
+	 * @return GPAK_ERROR_OK if every file was extracted, or the error code of a file that could not be extracted.
+	 */
+	GPAK_API int gpak_extract_directory(gpak_t* _pak, const char* _path, const char* _destination);
+
+	/**
+	 * @brief Keeps a file of a G-PAK archive decoded in the entry cache.
+	 *
+	 * This function decodes the file into the entry cache if it is not there yet and pins it, so it is never evicted and
+	 * every gpak_fopen shares it, whatever the cache budget.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the file cannot be found or decoded.
+	 */
+	GPAK_API int gpak_pin_entry(gpak_t* _pak, const char* _path);
+
+	/**
+	 * @brief Lets a file pinned with gpak_pin_entry be evicted again.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @return GPAK_ERROR_OK on success, or GPAK_ERROR_FILE_NOT_FOUND if the file is not in the entry cache.
+	 */
+	GPAK_API int gpak_unpin_entry(gpak_t* _pak, const char* _path);
+
+	/**
+	 * @brief Creates a queue of asynchronous entry reads on a G-PAK archive.
+	 *
+	 * This function creates the queue used to read many entries at once. On Linux the compressed payloads of plain
+	 * entries are read through io_uring and every payload is decoded on a worker thread as soon as it lands, so reading
+	 * and decoding overlap. Other entries, archive images and platforms without io_uring are read and decoded by the
+	 * worker threads. The queue must be used from one thread and freed before the archive is closed.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _queue_depth The number of reads kept in flight, or 0 for GPAK_ASYNC_QUEUE_DEPTH.
+	 * @return A pointer to the new gpak_async_t.
+	 */
+	GPAK_API gpak_async_t* gpak_async_create(gpak_t* _pak, uint32_t _queue_depth);
+
+	/**
+	 * @brief Queues the read of a file of a G-PAK archive.
+	 *
+	 * This function starts reading the file and returns at once. The handler is called by gpak_async_poll once the file
+	 * is decoded and checked against its CRC-32, it takes over the view and releases it with gpak_funmap.
+	 *
+	 * @param _async A pointer to the gpak_async_t.
+	 * @param _path The internal path of the file.
+	 * @param _handler The function receiving the content, or NULL to drop it.
+	 * @param _user_data User data passed to the handler.
+	 * @return GPAK_ERROR_OK if the read was queued, or GPAK_ERROR_FILE_NOT_FOUND if the file cannot be found.
+	 */
+	GPAK_API int gpak_async_read(gpak_async_t* _async, const char* _path, gpak_read_handler_t _handler, void* _user_data);
+
+	/**
+	 * @brief Calls the handlers of the reads completed so far.
+	 *
+	 * This function also hands the reads waiting for a free slot to the system. Handlers are called on the calling thread.
+	 *
+	 * @param _async A pointer to the gpak_async_t.
+	 * @param _wait Whether to block until at least one read completes, if any is pending.
+	 * @return The number of handlers called.
+	 */
+	GPAK_API uint32_t gpak_async_poll(gpak_async_t* _async, int _wait);
+
+	/**
+	 * @brief Returns the number of queued reads whose handler has not been called yet.
+	 *
+	 * @param _async A pointer to the gpak_async_t.
+	 * @return The number of pending reads.
+	 */
+	GPAK_API uint32_t gpak_async_pending(gpak_async_t* _async);
+
+	/**
+	 * @brief Completes every pending read, calling its handler, and destroys the queue.
+	 *
+	 * @param _async A pointer to the gpak_async_t.
+	 */
+	GPAK_API void gpak_async_free(gpak_async_t* _async);
+
+	/**
+	 * @brief Creates a prioritized queue of entry reads on a G-PAK archive.
+	 *
+	 * This function starts the worker threads reading and decoding the requested files, highest priority first and, at
+	 * equal priority, earliest deadline first. A chunked file being decoded for a request gives way at the next chunk
+	 * boundary to a queued request of higher priority, it resumes where it stopped once that request is done. The queue
+	 * must be used from one thread and freed before the archive is closed.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _thread_count The number of worker threads, or 0 to use one per hardware thread.
+	 * @return A pointer to the new gpak_queue_t.
+	 */
+	GPAK_API gpak_queue_t* gpak_queue_create(gpak_t* _pak, uint32_t _thread_count);
+
+	/**
+	 * @brief Requests a file of a G-PAK archive.
+	 *
+	 * This function queues the request and returns at once. The handler is called by gpak_queue_poll once the file is
+	 * decoded, or with GPAK_ERROR_CANCELLED or GPAK_ERROR_DEADLINE_EXCEEDED, it takes over the view and releases it with
+	 * gpak_funmap.
+	 *
+	 * @param _queue A pointer to the gpak_queue_t.
+	 * @param _path The internal path of the file.
+	 * @param _priority The priority of the request, higher values are served first.
+	 * @param _deadline_ms The number of milliseconds after which the request is dropped if not completed, or 0 for none.
+	 * @param _handler The function receiving the content, or NULL to drop it.
+	 * @param _user_data User data passed to the handler.
+	 * @return The identifier of the request, or 0 if the file cannot be found.
+	 */
+	GPAK_API uint64_t gpak_queue_request(gpak_queue_t* _queue, const char* _path, int32_t _priority, uint32_t _deadline_ms, gpak_read_handler_t _handler, void* _user_data);
+
+	/**
+	 * @brief Cancels a request whose handler has not been called yet.
+	 *
+	 * This function drops a queued request, or stops a running one at its next chunk boundary. The handler is still
+	 * called, with GPAK_ERROR_CANCELLED.
+	 *
+	 * @param _queue A pointer to the gpak_queue_t.
+	 * @param _request The identifier returned by gpak_queue_request.
+	 * @return 1 if the request was cancelled, 0 if it is unknown or its handler was already called.
+	 */
+	GPAK_API int gpak_queue_cancel(gpak_queue_t* _queue, uint64_t _request);
+
+	/**
+	 * @brief Changes the priority of a request that is queued or running.
+	 *
+	 * @param _queue A pointer to the gpak_queue_t.
+	 * @param _request The identifier returned by gpak_queue_request.
+	 * @param _priority The new priority of the request.
+	 * @return 1 if the priority was changed, 0 if the request is unknown or already completed.
+	 */
+	GPAK_API int gpak_queue_set_priority(gpak_queue_t* _queue, uint64_t _request, int32_t _priority);
+
+	/**
+	 * @brief Calls the handlers of the requests completed so far, on the calling thread.
+	 *
+	 * @param _queue A pointer to the gpak_queue_t.
+	 * @param _wait Whether to block until at least one request completes, if any is pending.
+	 * @return The number of handlers called.
+	 */
+	GPAK_API uint32_t gpak_queue_poll(gpak_queue_t* _queue, int _wait);
+
+	/**
+	 * @brief Returns the number of requests whose handler has not been called yet.
+	 *
+	 * @param _queue A pointer to the gpak_queue_t.
+	 * @return The number of pending requests.
+	 */
+	GPAK_API uint32_t gpak_queue_pending(gpak_queue_t* _queue);
+
+	/**
+	 * @brief Cancels every pending request, calls their handlers and destroys the queue.
+	 *
+	 * @param _queue A pointer to the gpak_queue_t.
+	 */
+	GPAK_API void gpak_queue_free(gpak_queue_t* _queue);
+
 #ifdef __cplusplus
 }
 #endif
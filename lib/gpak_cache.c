@@ -0,0 +1,267 @@
+#include "gpak_cache.h"
+
+#include "gpak_threads.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define _ENTRY_CACHE_BUCKETS 256u
+
+struct gpak_cached_entry
+{
+	struct gpak_entry_cache* cache_;
+	const void* key_;
+	char* data_;
+	uint64_t size_;
+	uint32_t references_;
+	int pinned_;
+	struct gpak_cached_entry* older_;
+	struct gpak_cached_entry* newer_;
+	struct gpak_cached_entry* next_in_bucket_;
+};
+
+struct gpak_entry_cache
+{
+	gpak_mutex_t mutex_;
+	uint64_t budget_;
+	gpak_cached_entry_t* buckets_[_ENTRY_CACHE_BUCKETS];
+	gpak_cached_entry_t* newest_;
+	gpak_cached_entry_t* oldest_;
+	gpak_cache_stats_t stats_;
+};
+
+static uint32_t _gpak_entry_cache_bucket(const void* _key)
+{
+	return (uint32_t)((((uint64_t)(uintptr_t)_key >> 4) * 0x9E3779B97F4A7C15ull) >> 56) & (_ENTRY_CACHE_BUCKETS - 1u);
+}
+
+static void _gpak_entry_cache_unlink(gpak_entry_cache_t* _cache, gpak_cached_entry_t* _entry)
+{
+	if (_entry->older_)
+		_entry->older_->newer_ = _entry->newer_;
+	else
+		_cache->oldest_ = _entry->newer_;
+
+	if (_entry->newer_)
+		_entry->newer_->older_ = _entry->older_;
+	else
+		_cache->newest_ = _entry->older_;
+
+	_entry->older_ = _entry->newer_ = NULL;
+}
+
+static void _gpak_entry_cache_push(gpak_entry_cache_t* _cache, gpak_cached_entry_t* _entry)
+{
+	_entry->older_ = _cache->newest_;
+	_entry->newer_ = NULL;
+
+	if (_cache->newest_)
+		_cache->newest_->newer_ = _entry;
+	else
+		_cache->oldest_ = _entry;
+
+	_cache->newest_ = _entry;
+}
+
+// Expects the cache mutex to be held
+static void _gpak_entry_cache_remove(gpak_entry_cache_t* _cache, gpak_cached_entry_t* _entry)
+{
+	gpak_cached_entry_t** link = &_cache->buckets_[_gpak_entry_cache_bucket(_entry->key_)];
+	while (*link != _entry)
+		link = &(*link)->next_in_bucket_;
+	*link = _entry->next_in_bucket_;
+
+	_gpak_entry_cache_unlink(_cache, _entry);
+
+	_cache->stats_.size_ -= _entry->size_;
+	--_cache->stats_.entry_count_;
+	if (_entry->pinned_)
+		--_cache->stats_.pinned_count_;
+}
+
+// Expects the cache mutex to be held, entries still referenced or pinned stay even over budget
+static void _gpak_entry_cache_evict(gpak_entry_cache_t* _cache)
+{
+	gpak_cached_entry_t* entry = _cache->oldest_;
+	while (entry && _cache->stats_.size_ > _cache->budget_)
+	{
+		gpak_cached_entry_t* newer = entry->newer_;
+		if (entry->references_ == 0u && !entry->pinned_)
+		{
+			_gpak_entry_cache_remove(_cache, entry);
+			++_cache->stats_.evictions_;
+			free(entry->data_);
+			free(entry);
+		}
+
+		entry = newer;
+	}
+}
+
+// Expects the cache mutex to be held
+static gpak_cached_entry_t* _gpak_entry_cache_find(gpak_entry_cache_t* _cache, const void* _key)
+{
+	gpak_cached_entry_t* entry = _cache->buckets_[_gpak_entry_cache_bucket(_key)];
+	while (entry && entry->key_ != _key)
+		entry = entry->next_in_bucket_;
+
+	return entry;
+}
+
+gpak_entry_cache_t* _gpak_entry_cache_create(uint64_t _budget)
+{
+	gpak_entry_cache_t* cache = (gpak_entry_cache_t*)calloc(1, sizeof(gpak_entry_cache_t));
+	_gpak_mutex_init(&cache->mutex_);
+	cache->budget_ = _budget;
+	cache->stats_.budget_ = _budget;
+	return cache;
+}
+
+void _gpak_entry_cache_free(gpak_entry_cache_t* _cache)
+{
+	if (!_cache)
+		return;
+
+	gpak_cached_entry_t* entry = _cache->oldest_;
+	while (entry)
+	{
+		gpak_cached_entry_t* newer = entry->newer_;
+		free(entry->data_);
+		free(entry);
+		entry = newer;
+	}
+
+	_gpak_mutex_destroy(&_cache->mutex_);
+	free(_cache);
+}
+
+void _gpak_entry_cache_set_budget(gpak_entry_cache_t* _cache, uint64_t _budget)
+{
+	_gpak_mutex_lock(&_cache->mutex_);
+	_cache->budget_ = _budget;
+	_cache->stats_.budget_ = _budget;
+	_gpak_entry_cache_evict(_cache);
+	_gpak_mutex_unlock(&_cache->mutex_);
+}
+
+gpak_cached_entry_t* _gpak_entry_cache_acquire(gpak_entry_cache_t* _cache, const void* _key)
+{
+	gpak_cached_entry_t* entry = NULL;
+
+	_gpak_mutex_lock(&_cache->mutex_);
+
+	// A disabled cache without pinned entries does not count lookups
+	if (_cache->budget_ > 0ull || _cache->stats_.entry_count_ > 0ull)
+	{
+		entry = _gpak_entry_cache_find(_cache, _key);
+		if (entry)
+		{
+			++entry->references_;
+			++_cache->stats_.hits_;
+			_gpak_entry_cache_unlink(_cache, entry);
+			_gpak_entry_cache_push(_cache, entry);
+		}
+		else
+			++_cache->stats_.misses_;
+	}
+
+	_gpak_mutex_unlock(&_cache->mutex_);
+
+	return entry;
+}
+
+gpak_cached_entry_t* _gpak_entry_cache_insert(gpak_entry_cache_t* _cache, const void* _key, char* _data, uint64_t _size, int _pin)
+{
+	_gpak_mutex_lock(&_cache->mutex_);
+
+	// Another reader decoded the same entry in the meantime
+	gpak_cached_entry_t* entry = _gpak_entry_cache_find(_cache, _key);
+	if (entry)
+	{
+		++entry->references_;
+		if (_pin && !entry->pinned_)
+		{
+			entry->pinned_ = 1;
+			++_cache->stats_.pinned_count_;
+		}
+
+		_gpak_mutex_unlock(&_cache->mutex_);
+		free(_data);
+		return entry;
+	}
+
+	if (!_pin && (_cache->budget_ == 0ull || _size > _cache->budget_))
+	{
+		_gpak_mutex_unlock(&_cache->mutex_);
+		return NULL;
+	}
+
+	entry = (gpak_cached_entry_t*)calloc(1, sizeof(gpak_cached_entry_t));
+	entry->cache_ = _cache;
+	entry->key_ = _key;
+	entry->data_ = _data;
+	entry->size_ = _size;
+	entry->references_ = 1u;
+	entry->pinned_ = _pin;
+
+	uint32_t bucket = _gpak_entry_cache_bucket(_key);
+	entry->next_in_bucket_ = _cache->buckets_[bucket];
+	_cache->buckets_[bucket] = entry;
+	_gpak_entry_cache_push(_cache, entry);
+
+	_cache->stats_.size_ += _size;
+	++_cache->stats_.entry_count_;
+	if (_pin)
+		++_cache->stats_.pinned_count_;
+
+	_gpak_entry_cache_evict(_cache);
+
+	_gpak_mutex_unlock(&_cache->mutex_);
+
+	return entry;
+}
+
+void _gpak_entry_cache_release(gpak_cached_entry_t* _entry)
+{
+	gpak_entry_cache_t* cache = _entry->cache_;
+
+	_gpak_mutex_lock(&cache->mutex_);
+	if (--_entry->references_ == 0u)
+		_gpak_entry_cache_evict(cache);
+	_gpak_mutex_unlock(&cache->mutex_);
+}
+
+int _gpak_entry_cache_pin(gpak_entry_cache_t* _cache, const void* _key, int _pin)
+{
+	_gpak_mutex_lock(&_cache->mutex_);
+
+	gpak_cached_entry_t* entry = _gpak_entry_cache_find(_cache, _key);
+	int found = entry != NULL;
+	if (entry && entry->pinned_ != (_pin != 0))
+	{
+		entry->pinned_ = _pin != 0;
+		if (entry->pinned_)
+			++_cache->stats_.pinned_count_;
+		else
+		{
+			--_cache->stats_.pinned_count_;
+			_gpak_entry_cache_evict(_cache);
+		}
+	}
+
+	_gpak_mutex_unlock(&_cache->mutex_);
+
+	return found;
+}
+
+char* _gpak_cached_entry_data(gpak_cached_entry_t* _entry)
+{
+	return _entry->data_;
+}
+
+void _gpak_entry_cache_stats(gpak_entry_cache_t* _cache, gpak_cache_stats_t* _stats)
+{
+	_gpak_mutex_lock(&_cache->mutex_);
+	*_stats = _cache->stats_;
+	_gpak_mutex_unlock(&_cache->mutex_);
+}
\ No newline at end of file
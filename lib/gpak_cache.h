@@ -0,0 +1,124 @@
+/**
+ * @file gpak_cache.h
+ * @author AdamFull
+ * @date 17.10.2026
+ * @brief The gpak_cache.h header file contains the cache of decoded entries
+ *        used internally by the Gpak library.
+ *
+ * This header file defines a least recently used cache of whole decoded
+ * entries bounded by a byte budget. Entries are handed out as reference
+ * counted, read-only items, so a file opened again and again is decoded once
+ * and shared by every handle. Unreferenced entries are evicted when the cache
+ * grows over its budget, pinned entries are never evicted.
+ */
+
+#ifndef GPAK_CACHE_H
+#define GPAK_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	#include "gpak_export.h"
+	#include "gpak_data.h"
+
+	/**
+	 * @brief Typedef for the opaque gpak_entry_cache structure.
+	 */
+	typedef struct gpak_entry_cache gpak_entry_cache_t;
+
+	/**
+	 * @brief Typedef for the opaque gpak_cached_entry structure, one decoded entry held by the cache.
+	 */
+	typedef struct gpak_cached_entry gpak_cached_entry_t;
+
+	/**
+	 * @brief Creates an empty entry cache.
+	 *
+	 * @param _budget The number of decoded bytes the cache may hold, 0 to only keep pinned entries.
+	 * @return A pointer to the new gpak_entry_cache_t.
+	 */
+	GPAK_API gpak_entry_cache_t* _gpak_entry_cache_create(uint64_t _budget);
+
+	/**
+	 * @brief Destroys an entry cache and every entry it holds, referenced or not.
+	 *
+	 * @param _cache A pointer to the gpak_entry_cache_t, or NULL.
+	 */
+	GPAK_API void _gpak_entry_cache_free(gpak_entry_cache_t* _cache);
+
+	/**
+	 * @brief Changes the byte budget of an entry cache.
+	 *
+	 * This function evicts unreferenced, unpinned entries until the cache fits in the new budget.
+	 *
+	 * @param _cache A pointer to the gpak_entry_cache_t.
+	 * @param _budget The number of decoded bytes the cache may hold, 0 to only keep pinned entries.
+	 */
+	GPAK_API void _gpak_entry_cache_set_budget(gpak_entry_cache_t* _cache, uint64_t _budget);
+
+	/**
+	 * @brief Looks an entry up and takes a reference to it.
+	 *
+	 * This function counts a hit or a miss, unless the cache is disabled and empty. It is thread-safe.
+	 *
+	 * @param _cache A pointer to the gpak_entry_cache_t.
+	 * @param _key The key of the entry, the address of its filesystem tree file.
+	 * @return A pointer to the referenced gpak_cached_entry_t, or NULL if the entry is not cached.
+	 */
+	GPAK_API gpak_cached_entry_t* _gpak_entry_cache_acquire(gpak_entry_cache_t* _cache, const void* _key);
+
+	/**
+	 * @brief Adds a decoded entry to the cache and takes a reference to it.
+	 *
+	 * When the entry is admitted the cache owns _data. If another thread cached the same entry in the meantime, _data is freed
+	 * and the existing entry is returned instead. Entries larger than the budget are only admitted when they are pinned. It is
+	 * thread-safe.
+	 *
+	 * @param _cache A pointer to the gpak_entry_cache_t.
+	 * @param _key The key of the entry, the address of its filesystem tree file.
+	 * @param _data The decoded content, allocated with malloc.
+	 * @param _size The size of the decoded content in bytes.
+	 * @param _pin Whether the entry is pinned.
+	 * @return A pointer to the referenced gpak_cached_entry_t, or NULL if the entry was not admitted and _data still belongs to the caller.
+	 */
+	GPAK_API gpak_cached_entry_t* _gpak_entry_cache_insert(gpak_entry_cache_t* _cache, const void* _key, char* _data, uint64_t _size, int _pin);
+
+	/**
+	 * @brief Drops a reference taken with _gpak_entry_cache_acquire or _gpak_entry_cache_insert.
+	 *
+	 * @param _entry A pointer to the gpak_cached_entry_t.
+	 */
+	GPAK_API void _gpak_entry_cache_release(gpak_cached_entry_t* _entry);
+
+	/**
+	 * @brief Pins or unpins a cached entry.
+	 *
+	 * @param _cache A pointer to the gpak_entry_cache_t.
+	 * @param _key The key of the entry, the address of its filesystem tree file.
+	 * @param _pin Whether the entry is pinned.
+	 * @return 1 if the entry is cached, or 0 otherwise.
+	 */
+	GPAK_API int _gpak_entry_cache_pin(gpak_entry_cache_t* _cache, const void* _key, int _pin);
+
+	/**
+	 * @brief Returns the decoded content of a cached entry.
+	 *
+	 * @param _entry A pointer to the referenced gpak_cached_entry_t.
+	 * @return A pointer to the decoded content, valid until the reference is dropped.
+	 */
+	GPAK_API char* _gpak_cached_entry_data(gpak_cached_entry_t* _entry);
+
+	/**
+	 * @brief Fills the counters of an entry cache.
+	 *
+	 * @param _cache A pointer to the gpak_entry_cache_t.
+	 * @param _stats A pointer to the gpak_cache_stats_t to fill.
+	 */
+	GPAK_API void _gpak_entry_cache_stats(gpak_entry_cache_t* _cache, gpak_cache_stats_t* _stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPAK_CACHE_H
\ No newline at end of file
@@ -1,42 +1,26 @@
 #include "gpak_compressors.h"
 
 #include "gpak_helper.h"
+#include "gpak_threads.h"
 #include "filesystem_tree.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <assert.h>
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <unistd.h>
-#include <sys/sysinfo.h>
-#endif
-
 // Zlib
 #include <zlib.h>
 
-// Z-standard
+// Z-standard, the static section only provides ZSTD_DECOMPRESSION_MARGIN, a macro
+#define ZSTD_STATIC_LINKING_ONLY
 #include <zstd.h>
 #include <zdict.h>
 
 #define _DICTIONARY_SAMPLE_COUNT 200
-
-
-int get_num_threads() 
-{
-	int numThreads;
-
-#ifdef _WIN32
-	SYSTEM_INFO sysinfo;
-	GetSystemInfo(&sysinfo);
-	numThreads = sysinfo.dwNumberOfProcessors;
-#else
-	numThreads = sysconf(_SC_THREAD_THREADS_MAX);
-#endif
-
-	return numThreads;
-}
+#define _DICTIONARY_SAMPLE_SIZE 16384
+#define _DICTIONARY_MIN_SAMPLES 8
+#define _DICTIONARY_MAX_SIZE 114688
 
 
 uint32_t _gpak_compressor_none(gpak_t* _pak, FILE* _infile, FILE* _outfile)
@@ -64,35 +48,6 @@ uint32_t _gpak_compressor_none(gpak_t* _pak, FILE* _infile, FILE* _outfile)
 	return _crc32;
 }
 
-uint32_t _gpak_decompressor_none(gpak_t* _pak, FILE* _infile, FILE* _outfile, size_t _read_size)
-{
-	char* _bufferIn = (char*)malloc(_DEFAULT_BLOCK_SIZE);
-	size_t bytesReaded = 0ull;
-	size_t nextBlockSize = _DEFAULT_BLOCK_SIZE;
-
-	uint32_t _crc32 = crc32(0L, Z_NULL, 0);
-
-	do
-	{
-		size_t _readed = _freadb(_bufferIn, 1ull, nextBlockSize, _infile);
-		_crc32 = crc32(_crc32, _bufferIn, _readed);
-
-		_fwriteb(_bufferIn, 1ull, _readed, _outfile);
-		bytesReaded += _readed;
-		_gpak_pass_progress(_pak, bytesReaded, _read_size, GPAK_STAGE_DECOMPRESSION);
-
-		if (_read_size - bytesReaded < nextBlockSize)
-			nextBlockSize = _read_size - bytesReaded;
-	} while (bytesReaded != _read_size);
-
-	if (bytesReaded != _read_size)
-		return _gpak_make_error(_pak, GPAK_ERROR_READ);
-
-	free(_bufferIn);
-
-	return _crc32;
-}
-
 
 uint32_t _gpak_compressor_deflate(gpak_t* _pak, FILE* _infile, FILE* _outfile)
 {
@@ -159,72 +114,8 @@ end:
 	return _crc32;
 }
 
-uint32_t _gpak_decompressor_inflate(gpak_t* _pak, FILE* _infile, FILE* _outfile, size_t _read_size)
-{
-	z_stream strm;
-	strm.zalloc = Z_NULL;
-	strm.zfree = Z_NULL;
-	strm.opaque = Z_NULL;
-
-	char* _bufferIn = (char*)malloc(_DEFAULT_BLOCK_SIZE);
-	char* _bufferOut = (char*)malloc(_DEFAULT_BLOCK_SIZE);
-
-	int ret = inflateInit(&strm);
-	if (ret != Z_OK)
-		return _gpak_make_error(_pak, GPAK_ERROR_INFLATE_INIT);
-
-	uint32_t _crc32 = crc32(0L, Z_NULL, 0);
-
-	unsigned have;
-	size_t total_read = 0ull;
 
-	do
-	{
-		size_t bytes_to_read = _read_size - total_read < _DEFAULT_BLOCK_SIZE ? _read_size - total_read : _DEFAULT_BLOCK_SIZE;
-		strm.avail_in = _freadb(_bufferIn, 1, bytes_to_read, _infile);
-		total_read += strm.avail_in;
-		_gpak_pass_progress(_pak, total_read, _read_size, GPAK_STAGE_DECOMPRESSION);
-
-		strm.next_in = _bufferIn;
-
-		do
-		{
-			strm.avail_out = _DEFAULT_BLOCK_SIZE;
-			strm.next_out = _bufferOut;
-			ret = inflate(&strm, Z_NO_FLUSH);
-			assert(ret != Z_STREAM_ERROR);
-
-			switch (ret) {
-			case Z_NEED_DICT:
-			case Z_DATA_ERROR:
-			case Z_MEM_ERROR:
-				goto end;
-			}
-
-			have = _DEFAULT_BLOCK_SIZE - strm.avail_out;
-
-			_crc32 = crc32(_crc32, _bufferOut, have);
-
-			if (_fwriteb(_bufferOut, 1, have, _outfile) != have || ferror(_outfile))
-			{
-				_gpak_make_error(_pak, GPAK_ERROR_INFLATE_FAILED);
-				goto end;
-			}
-
-		} while (strm.avail_out == 0);
-
-	} while (ret != Z_STREAM_END);
-
-end:
-	free(_bufferIn);
-	free(_bufferOut);
-	(void)inflateEnd(&strm);
-
-	return _crc32;
-}
-
-
-uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile)
+uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile, uint32_t _dictionary_id)
 {
 	size_t const buffInSize = ZSTD_CStreamInSize();
 	void* const buffIn = malloc(buffInSize);
@@ -240,7 +131,7 @@ uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile)
 	/* Create the context. */
 	ZSTD_CCtx* const cctx = ZSTD_createCCtx();
 
-	uint32_t thread_count = get_num_threads();
+	uint32_t thread_count = _gpak_hardware_concurrency();
 
 	/* Set parameters. */
 	ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, _pak->header_.compression_level_);
@@ -250,8 +141,8 @@ uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile)
 	ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, thread_count);
 	ZSTD_CCtx_setParameter(cctx, ZSTD_c_jobSize, buffInSize * thread_count);
 	
-	if (_pak->dictionary_ && _pak->header_.dictionary_size_ > 0)
-		ZSTD_CCtx_loadDictionary(cctx, _pak->dictionary_, _pak->header_.dictionary_size_);
+	if (_dictionary_id > 0u && _pak->cdicts_)
+		ZSTD_CCtx_refCDict(cctx, _pak->cdicts_[_dictionary_id - 1u]);
 
 	size_t _total_readed = 0ull;
 	size_t const toRead = buffInSize;
@@ -288,135 +179,743 @@ uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile)
 	return _crc32;
 }
 
-uint32_t _gpak_decompressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile, size_t _read_size)
+size_t _gpak_decompress_chunk(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id)
 {
-	size_t const buffInSize = ZSTD_DStreamInSize();
-	void* const buffIn = malloc(buffInSize);
-	size_t const buffOutSize = ZSTD_DStreamOutSize();
-	void* const buffOut = malloc(buffOutSize);
+	// Stored chunk
+	if (_src_size == _dst_size)
+	{
+		memcpy(_dst, _src, _dst_size);
+		return _dst_size;
+	}
 
-	uint32_t _crc32 = crc32(0L, Z_NULL, 0);
+	return _gpak_decompress_buffer(_pak, _src, _src_size, _dst, _dst_size, _dictionary_id);
+}
 
-	ZSTD_DCtx* const dctx = ZSTD_createDCtx();
-	assert(dctx != NULL && "ZSTD_createDCtx() failed!");
+size_t _gpak_decompress_buffer(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id)
+{
+	if (!(_pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)))
+	{
+		if (_src_size != _dst_size)
+			return 0ull;
 
-	if (_pak->dictionary_ && _pak->header_.dictionary_size_ > 0)
-		ZSTD_DCtx_loadDictionary(dctx, _pak->dictionary_, _pak->header_.dictionary_size_);
+		memcpy(_dst, _src, _dst_size);
+		return _dst_size;
+	}
 
-	size_t bytesRead = 0;
-	size_t lastRet = 0;
-	int isEmpty = 1;
+	// Contexts are reused across calls, creating one costs more than decoding a small entry
+	gpak_decoder_t* decoder = _gpak_decoder_acquire(_pak);
+	if (!decoder)
+		return 0ull;
 
-	while (bytesRead < _read_size)
-	{
-		size_t const toRead = (bytesRead + buffInSize <= _read_size) ? buffInSize : (_read_size - bytesRead);
-		size_t read = _freadb(buffIn, 1, toRead, _infile);
+	size_t decompressed = _gpak_decoder_decompress(decoder, _src, _src_size, _dst, _dst_size, _dictionary_id);
+	_gpak_decoder_release(_pak, decoder);
 
-		if (!read)
-		{
-			break;
-		}
+	return decompressed;
+}
 
-		bytesRead += read;
+void _gpak_dictionary_class(gpak_t* _pak, const char* _path, char* _class)
+{
+	const char* class_name = _pak->dictionary_classifier_ ? _pak->dictionary_classifier_(_path, _pak->user_data_) : NULL;
 
-		_gpak_pass_progress(_pak, bytesRead, _read_size, GPAK_STAGE_DECOMPRESSION);
+	// By default files are grouped by their lowercase extension
+	if (!class_name)
+	{
+		const char* file_name = strrchr(_path, '/');
+		file_name = file_name ? file_name + 1 : _path;
 
-		isEmpty = 0;
-		ZSTD_inBuffer input = { buffIn, read, 0 };
-		while (input.pos < input.size)
-		{
-			ZSTD_outBuffer output = { buffOut, buffOutSize, 0 };
-			size_t const ret = ZSTD_decompressStream(dctx, &output, &input);
+		const char* extension = strrchr(file_name, '.');
+		class_name = extension ? extension + 1 : "";
+	}
 
-			_crc32 = crc32(_crc32, buffOut, output.pos);
+	size_t length = 0ull;
+	for (; class_name[length] && length < GPAK_DICTIONARY_CLASS_SIZE - 1u; ++length)
+		_class[length] = (char)tolower((unsigned char)class_name[length]);
+	_class[length] = '\0';
+}
 
-			_fwriteb(buffOut, 1, output.pos, _outfile);
-			lastRet = ret;
-		}
-	}
+uint32_t _gpak_dictionary_find(gpak_t* _pak, const char* _path)
+{
+	if (_pak->dictionary_count_ == 0u)
+		return 0u;
 
-	if (isEmpty)
-	{
-		_gpak_make_error(_pak, GPAK_ERROR_EMPTY_INPUT);
-		goto clear;
-	}
+	char class_name[GPAK_DICTIONARY_CLASS_SIZE];
+	_gpak_dictionary_class(_pak, _path, class_name);
 
-	if (lastRet != 0)
+	uint32_t fallback = 0u;
+	for (uint32_t idx = 0u; idx < _pak->dictionary_count_; ++idx)
 	{
-		_gpak_make_error(_pak, GPAK_ERROR_EOF_BEFORE_EOS);
-		goto clear;
+		if (strncmp(_pak->dictionaries_[idx].class_, class_name, GPAK_DICTIONARY_CLASS_SIZE) == 0)
+			return idx + 1u;
+
+		if (strcmp(_pak->dictionaries_[idx].class_, "*") == 0)
+			fallback = idx + 1u;
 	}
 
-clear:
-	ZSTD_freeDCtx(dctx);
-	free(buffIn);
-	free(buffOut);
+	return fallback;
+}
 
-	return _crc32;
+struct gpak_dictionary_samples
+{
+	char class_[GPAK_DICTIONARY_CLASS_SIZE];
+	char* samples_;
+	size_t sample_sizes_[_DICTIONARY_SAMPLE_COUNT];
+	size_t samples_count_;
+	size_t samples_size_;
+};
+
+void _gpak_dictionary_add_sample(struct gpak_dictionary_samples* _class, const char* _sample, size_t _size)
+{
+	if (_class->samples_count_ >= _DICTIONARY_SAMPLE_COUNT)
+		return;
+
+	_class->samples_ = (char*)realloc(_class->samples_, _class->samples_size_ + _size + 1ull);
+	memcpy(_class->samples_ + _class->samples_size_, _sample, _size);
+	_class->samples_size_ += _size;
+	_class->sample_sizes_[_class->samples_count_++] = _size;
 }
 
 int32_t _gpak_compressor_generate_dictionary(gpak_t* _pak)
 {
-	char* samples = NULL;
-	size_t sample_sizes[_DICTIONARY_SAMPLE_COUNT];
-	size_t samples_count = 0ull;
-	size_t samples_capacity = 0ull;
-	size_t current_offset = 0ull;
+	// The last class gathers the files of every class that does not get a dictionary of its own
+	struct gpak_dictionary_samples* classes = (struct gpak_dictionary_samples*)calloc(GPAK_MAX_DICTIONARIES, sizeof(struct gpak_dictionary_samples));
+	struct gpak_dictionary_samples* other = &classes[GPAK_MAX_DICTIONARIES - 1u];
+	strcpy(other->class_, "*");
+	uint32_t class_count = 0u;
+
+	char* sample = (char*)malloc(_DICTIONARY_SAMPLE_SIZE);
 
 	filesystem_tree_iterator_t* iterator = filesystem_iterator_create(_pak->root_);
 	filesystem_tree_node_t* next_directory = _pak->root_;
 	do
 	{
-		if (samples_count >= _DICTIONARY_SAMPLE_COUNT - 1)
-			break;
-
 		filesystem_tree_file_t* next_file = NULL;
 		while ((next_file = filesystem_iterator_next_file(iterator)))
 		{
-			FILE* _infile = fopen(next_file->path_, "rb");
+			// Entries already stored in an updated archive have no source file to sample
+			if (!next_file->path_)
+				continue;
 
-			fseek(_infile, 0, SEEK_END);
-			sample_sizes[samples_count] = ftell(_infile);
-			fseek(_infile, 0, SEEK_SET);
+			char* internal_path = filesystem_tree_file_path(next_directory, next_file);
+			char class_name[GPAK_DICTIONARY_CLASS_SIZE];
+			_gpak_dictionary_class(_pak, internal_path, class_name);
+			free(internal_path);
 
-			samples_capacity += sample_sizes[samples_count];
-			samples = (char*)realloc(samples, samples_capacity);
+			struct gpak_dictionary_samples* target = other;
+			for (uint32_t idx = 0u; idx < class_count; ++idx)
+			{
+				if (strcmp(classes[idx].class_, class_name) == 0)
+					target = &classes[idx];
+			}
 
-			_freadb(samples + current_offset, 1ull, sample_sizes[samples_count], _infile);
+			if (target == other && class_count < GPAK_MAX_DICTIONARIES - 1u && strcmp(class_name, "*") != 0)
+			{
+				target = &classes[class_count++];
+				strcpy(target->class_, class_name);
+			}
 
-			current_offset += sample_sizes[samples_count];
+			if (target->samples_count_ >= _DICTIONARY_SAMPLE_COUNT)
+				continue;
 
-			fclose(_infile);
+			// Dictionaries mostly help small files, the head of a large one is a good enough sample
+			FILE* _infile = fopen(next_file->path_, "rb");
+			if (!_infile)
+				continue;
 
-			if (samples_count >= _DICTIONARY_SAMPLE_COUNT - 1)
-				break;
+			size_t readed = _freadb(sample, 1ull, _DICTIONARY_SAMPLE_SIZE, _infile);
+			fclose(_infile);
 
-			++samples_count;
+			if (readed > 0ull)
+				_gpak_dictionary_add_sample(target, sample, readed);
 		}
 	} while ((next_directory = filesystem_iterator_next_directory(iterator)));
 
 	filesystem_iterator_free(iterator);
+	free(sample);
 
-	size_t average_file_size = 0ull;
+	// Classes with too few samples to train on are folded into the shared one
+	for (uint32_t idx = 0u; idx < class_count; ++idx)
+	{
+		if (classes[idx].samples_count_ >= _DICTIONARY_MIN_SAMPLES)
+			continue;
 
-	for (size_t idx = 0ull; idx < samples_count; ++idx)
-		average_file_size += sample_sizes[idx] / samples_count;
+		size_t offset = 0ull;
+		for (size_t sample_idx = 0ull; sample_idx < classes[idx].samples_count_; ++sample_idx)
+		{
+			_gpak_dictionary_add_sample(other, classes[idx].samples_ + offset, classes[idx].sample_sizes_[sample_idx]);
+			offset += classes[idx].sample_sizes_[sample_idx];
+		}
 
-	size_t nearest_pow_of_2 = 1;
-	while (nearest_pow_of_2 < average_file_size)
-		nearest_pow_of_2 *= 2;
+		classes[idx].samples_count_ = 0ull;
+	}
 
-	_pak->header_.dictionary_size_ = nearest_pow_of_2;
+	_pak->dictionaries_ = (pak_dictionary_t*)calloc(GPAK_MAX_DICTIONARIES, sizeof(pak_dictionary_t));
+	_pak->dictionary_count_ = 0u;
+	_pak->header_.dictionary_size_ = 0u;
 
-	_pak->dictionary_ = (char*)malloc(_pak->header_.dictionary_size_);
-	_pak->header_.dictionary_size_ = ZDICT_trainFromBuffer(_pak->dictionary_, _pak->header_.dictionary_size_, samples, sample_sizes, samples_count);
-	_pak->dictionary_ = (char*)realloc(_pak->dictionary_, _pak->header_.dictionary_size_);
+	for (uint32_t idx = 0u; idx < GPAK_MAX_DICTIONARIES; ++idx)
+	{
+		struct gpak_dictionary_samples* target = &classes[idx];
+		if (target->samples_count_ < _DICTIONARY_MIN_SAMPLES)
+		{
+			free(target->samples_);
+			continue;
+		}
+
+		size_t average_sample_size = target->samples_size_ / target->samples_count_;
+
+		size_t capacity = 1024ull;
+		while (capacity < average_sample_size && capacity < _DICTIONARY_MAX_SIZE)
+			capacity *= 2ull;
+		if (capacity > _DICTIONARY_MAX_SIZE)
+			capacity = _DICTIONARY_MAX_SIZE;
 
-	fseek(_pak->stream_, sizeof(pak_header_t), SEEK_SET);
+		_pak->dictionary_ = (char*)realloc(_pak->dictionary_, _pak->header_.dictionary_size_ + capacity);
+		size_t dictionary_size = ZDICT_trainFromBuffer(_pak->dictionary_ + _pak->header_.dictionary_size_, capacity,
+			target->samples_, target->sample_sizes_, (unsigned)target->samples_count_);
 
-	_fwriteb(_pak->dictionary_, 1ull, _pak->header_.dictionary_size_, _pak->stream_);
+		// Too few or too similar samples leave the class without a dictionary
+		if (!ZDICT_isError(dictionary_size))
+		{
+			pak_dictionary_t* dictionary = &_pak->dictionaries_[_pak->dictionary_count_++];
+			dictionary->offset_ = _pak->header_.dictionary_size_;
+			dictionary->size_ = (uint32_t)dictionary_size;
+			strcpy(dictionary->class_, target->class_);
+
+			_pak->header_.dictionary_size_ += (uint32_t)dictionary_size;
+		}
 
-	free(samples);
+		free(target->samples_);
+	}
+
+	free(classes);
+
+	if (_pak->dictionary_count_ == 0u)
+	{
+		free(_pak->dictionary_);
+		_pak->dictionary_ = NULL;
+	}
 
 	return _gpak_make_error(_pak, GPAK_ERROR_OK);
+}
+
+int _gpak_dictionaries_prepare(gpak_t* _pak, int _compress)
+{
+	if (_pak->dictionary_count_ == 0u)
+		return GPAK_ERROR_OK;
+
+	// Dictionaries are digested once and shared by every context
+	if (_compress && !_pak->cdicts_)
+	{
+		_pak->cdicts_ = (ZSTD_CDict**)calloc(_pak->dictionary_count_, sizeof(ZSTD_CDict*));
+		for (uint32_t idx = 0u; idx < _pak->dictionary_count_; ++idx)
+		{
+			_pak->cdicts_[idx] = ZSTD_createCDict(_pak->dictionary_ + _pak->dictionaries_[idx].offset_, _pak->dictionaries_[idx].size_, _pak->header_.compression_level_);
+			if (!_pak->cdicts_[idx])
+				return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DICTIONARY);
+		}
+	}
+
+	if (!_pak->ddicts_)
+	{
+		_pak->ddicts_ = (ZSTD_DDict**)calloc(_pak->dictionary_count_, sizeof(ZSTD_DDict*));
+		for (uint32_t idx = 0u; idx < _pak->dictionary_count_; ++idx)
+		{
+			_pak->ddicts_[idx] = ZSTD_createDDict(_pak->dictionary_ + _pak->dictionaries_[idx].offset_, _pak->dictionaries_[idx].size_);
+			if (!_pak->ddicts_[idx])
+				return _gpak_make_error(_pak, GPAK_ERROR_INVALID_DICTIONARY);
+		}
+	}
+
+	return GPAK_ERROR_OK;
+}
+
+void _gpak_dictionaries_free(gpak_t* _pak)
+{
+	for (uint32_t idx = 0u; idx < _pak->dictionary_count_; ++idx)
+	{
+		if (_pak->cdicts_)
+			ZSTD_freeCDict(_pak->cdicts_[idx]);
+
+		if (_pak->ddicts_ && !_pak->shared_dictionary_)
+			ZSTD_freeDDict(_pak->ddicts_[idx]);
+	}
+
+	free(_pak->cdicts_);
+
+	// Shared dictionaries belong to the registry
+	if (_pak->shared_dictionary_)
+	{
+		_gpak_shared_dictionary_release(_pak->shared_dictionary_);
+		_pak->shared_dictionary_ = NULL;
+		_pak->dictionary_ = NULL;
+	}
+	else
+	{
+		free(_pak->ddicts_);
+		free(_pak->dictionaries_);
+	}
+
+	_pak->cdicts_ = NULL;
+	_pak->ddicts_ = NULL;
+	_pak->dictionaries_ = NULL;
+}
+
+// Standalone dictionary files registered by the application, shared by every archive of the process
+static gpak_shared_dictionary_t* _gpak_dictionary_registry = NULL;
+static gpak_mutex_t _gpak_dictionary_registry_mutex;
+static gpak_once_t _gpak_dictionary_registry_once = GPAK_ONCE_INIT;
+
+static void _gpak_dictionary_registry_init(void)
+{
+	_gpak_mutex_init(&_gpak_dictionary_registry_mutex);
+}
+
+uint64_t _gpak_dictionary_content_id(const pak_dictionary_t* _dictionaries, uint32_t _dictionary_count, const char* _dictionary, uint32_t _dictionary_size)
+{
+	uint64_t hash = _gpak_hash_bytes(14695981039346656037ull, _dictionaries, sizeof(pak_dictionary_t) * _dictionary_count);
+	hash = _gpak_hash_bytes(hash, _dictionary, _dictionary_size);
+
+	// Zero marks archives that store their own dictionaries
+	return hash != 0ull ? hash : 1ull;
+}
+
+gpak_shared_dictionary_t* _gpak_shared_dictionary_register(char* _dictionary, uint32_t _dictionary_size, pak_dictionary_t* _dictionaries, uint32_t _dictionary_count, uint64_t _content_id)
+{
+	_gpak_call_once(&_gpak_dictionary_registry_once, &_gpak_dictionary_registry_init);
+	_gpak_mutex_lock(&_gpak_dictionary_registry_mutex);
+
+	gpak_shared_dictionary_t* shared = _gpak_dictionary_registry;
+	while (shared && shared->content_id_ != _content_id)
+		shared = shared->next_;
+
+	// The same file registered twice is loaded once
+	if (shared)
+	{
+		_gpak_mutex_unlock(&_gpak_dictionary_registry_mutex);
+		free(_dictionary);
+		free(_dictionaries);
+		return shared;
+	}
+
+	shared = (gpak_shared_dictionary_t*)calloc(1, sizeof(gpak_shared_dictionary_t));
+	shared->content_id_ = _content_id;
+	shared->reference_count_ = 1u;
+	shared->dictionary_count_ = _dictionary_count;
+	shared->dictionary_size_ = _dictionary_size;
+	shared->dictionary_ = _dictionary;
+	shared->dictionaries_ = _dictionaries;
+	shared->ddicts_ = (ZSTD_DDict**)calloc(_dictionary_count + 1u, sizeof(ZSTD_DDict*));
+
+	for (uint32_t idx = 0u; idx < _dictionary_count; ++idx)
+	{
+		shared->ddicts_[idx] = ZSTD_createDDict(_dictionary + _dictionaries[idx].offset_, _dictionaries[idx].size_);
+		if (!shared->ddicts_[idx])
+		{
+			_gpak_mutex_unlock(&_gpak_dictionary_registry_mutex);
+			shared->reference_count_ = 0u;
+			_gpak_shared_dictionary_release(shared);
+			return NULL;
+		}
+	}
+
+	shared->next_ = _gpak_dictionary_registry;
+	_gpak_dictionary_registry = shared;
+
+	_gpak_mutex_unlock(&_gpak_dictionary_registry_mutex);
+	return shared;
+}
+
+int _gpak_shared_dictionary_unregister(uint64_t _content_id)
+{
+	_gpak_call_once(&_gpak_dictionary_registry_once, &_gpak_dictionary_registry_init);
+	_gpak_mutex_lock(&_gpak_dictionary_registry_mutex);
+
+	gpak_shared_dictionary_t** link = &_gpak_dictionary_registry;
+	while (*link && (*link)->content_id_ != _content_id)
+		link = &(*link)->next_;
+
+	gpak_shared_dictionary_t* shared = *link;
+	if (shared)
+		*link = shared->next_;
+
+	_gpak_mutex_unlock(&_gpak_dictionary_registry_mutex);
+
+	if (!shared)
+		return GPAK_ERROR_DICTIONARY_NOT_REGISTERED;
+
+	// Archives still using the dictionaries keep them alive
+	_gpak_shared_dictionary_release(shared);
+	return GPAK_ERROR_OK;
+}
+
+gpak_shared_dictionary_t* _gpak_shared_dictionary_acquire(uint64_t _content_id)
+{
+	_gpak_call_once(&_gpak_dictionary_registry_once, &_gpak_dictionary_registry_init);
+	_gpak_mutex_lock(&_gpak_dictionary_registry_mutex);
+
+	gpak_shared_dictionary_t* shared = _gpak_dictionary_registry;
+	while (shared && shared->content_id_ != _content_id)
+		shared = shared->next_;
+
+	if (shared)
+		++shared->reference_count_;
+
+	_gpak_mutex_unlock(&_gpak_dictionary_registry_mutex);
+	return shared;
+}
+
+void _gpak_shared_dictionary_release(gpak_shared_dictionary_t* _shared)
+{
+	_gpak_call_once(&_gpak_dictionary_registry_once, &_gpak_dictionary_registry_init);
+	_gpak_mutex_lock(&_gpak_dictionary_registry_mutex);
+	uint32_t reference_count = _shared->reference_count_ > 0u ? --_shared->reference_count_ : 0u;
+	_gpak_mutex_unlock(&_gpak_dictionary_registry_mutex);
+
+	if (reference_count > 0u)
+		return;
+
+	for (uint32_t idx = 0u; idx < _shared->dictionary_count_; ++idx)
+		ZSTD_freeDDict(_shared->ddicts_[idx]);
+
+	free(_shared->ddicts_);
+	free(_shared->dictionaries_);
+	free(_shared->dictionary_);
+	free(_shared);
+}
+
+struct gpak_decoder
+{
+	gpak_t* pak_;
+	uint32_t dictionary_id_;
+	ZSTD_DCtx* zstd_;
+	z_stream inflate_;
+	int inflate_ready_;
+	char* scratch_;
+	size_t scratch_size_;
+	struct gpak_decoder* next_;
+};
+
+struct gpak_decoder_pool
+{
+	gpak_mutex_t mutex_;
+	gpak_decoder_t* free_;
+};
+
+gpak_decoder_t* _gpak_decoder_create(gpak_t* _pak, uint32_t _dictionary_id)
+{
+	gpak_decoder_t* decoder = (gpak_decoder_t*)calloc(1, sizeof(gpak_decoder_t));
+	decoder->pak_ = _pak;
+	decoder->dictionary_id_ = _dictionary_id;
+
+	if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
+	{
+		decoder->inflate_.zalloc = Z_NULL;
+		decoder->inflate_.zfree = Z_NULL;
+		decoder->inflate_.opaque = Z_NULL;
+		decoder->inflate_.next_in = Z_NULL;
+		decoder->inflate_.avail_in = 0;
+		decoder->inflate_ready_ = inflateInit(&decoder->inflate_) == Z_OK;
+		if (!decoder->inflate_ready_)
+		{
+			free(decoder);
+			return NULL;
+		}
+	}
+	else if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
+	{
+		decoder->zstd_ = ZSTD_createDCtx();
+		if (!decoder->zstd_)
+		{
+			free(decoder);
+			return NULL;
+		}
+
+		if (_dictionary_id > 0u && _pak->ddicts_)
+			ZSTD_DCtx_refDDict(decoder->zstd_, _pak->ddicts_[_dictionary_id - 1u]);
+	}
+
+	return decoder;
+}
+
+int _gpak_decoder_reset(gpak_decoder_t* _decoder)
+{
+	if (_decoder->inflate_ready_ && inflateReset(&_decoder->inflate_) != Z_OK)
+		return GPAK_ERROR_INFLATE_INIT;
+
+	// Resetting the session only keeps the referenced dictionary
+	if (_decoder->zstd_ && ZSTD_isError(ZSTD_DCtx_reset(_decoder->zstd_, ZSTD_reset_session_only)))
+		return GPAK_ERROR_READ;
+
+	return GPAK_ERROR_OK;
+}
+
+int _gpak_decoder_run(gpak_decoder_t* _decoder, const void* _src, size_t _src_size, size_t* _src_used, void* _dst, size_t _dst_size, size_t* _dst_used)
+{
+	if (_decoder->inflate_ready_)
+	{
+		_decoder->inflate_.next_in = (Bytef*)_src;
+		_decoder->inflate_.avail_in = (uInt)_src_size;
+		_decoder->inflate_.next_out = (Bytef*)_dst;
+		_decoder->inflate_.avail_out = (uInt)_dst_size;
+
+		int ret = inflate(&_decoder->inflate_, Z_NO_FLUSH);
+
+		*_src_used = _src_size - _decoder->inflate_.avail_in;
+		*_dst_used = _dst_size - _decoder->inflate_.avail_out;
+
+		if (ret == Z_STREAM_END)
+			return 1;
+
+		// No progress is possible without more input or output space
+		if (ret == Z_OK || ret == Z_BUF_ERROR)
+			return 0;
+
+		return GPAK_ERROR_INFLATE_FAILED;
+	}
+	else if (_decoder->zstd_)
+	{
+		ZSTD_inBuffer input = { _src, _src_size, 0 };
+		ZSTD_outBuffer output = { _dst, _dst_size, 0 };
+
+		size_t ret = ZSTD_decompressStream(_decoder->zstd_, &output, &input);
+
+		*_src_used = input.pos;
+		*_dst_used = output.pos;
+
+		if (ZSTD_isError(ret))
+			return GPAK_ERROR_READ;
+
+		return ret == 0 ? 1 : 0;
+	}
+
+	// Stored payloads are copied, nothing is ever buffered
+	size_t copied = _src_size < _dst_size ? _src_size : _dst_size;
+	memcpy(_dst, _src, copied);
+
+	*_src_used = copied;
+	*_dst_used = copied;
+	return 1;
+}
+
+void _gpak_decoder_free(gpak_decoder_t* _decoder)
+{
+	if (!_decoder)
+		return;
+
+	if (_decoder->inflate_ready_)
+		inflateEnd(&_decoder->inflate_);
+
+	ZSTD_freeDCtx(_decoder->zstd_);
+	free(_decoder->scratch_);
+	free(_decoder);
+}
+
+size_t _gpak_decoder_decompress(gpak_decoder_t* _decoder, const void* _src, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id)
+{
+	gpak_t* pak = _decoder->pak_;
+	size_t decompressed = 0ull;
+
+	if (_decoder->inflate_ready_)
+	{
+		if (inflateReset(&_decoder->inflate_) != Z_OK)
+			return 0ull;
+
+		_decoder->inflate_.next_in = (Bytef*)_src;
+		_decoder->inflate_.avail_in = (uInt)_src_size;
+		_decoder->inflate_.next_out = (Bytef*)_dst;
+		_decoder->inflate_.avail_out = (uInt)_dst_size;
+
+		if (inflate(&_decoder->inflate_, Z_FINISH) == Z_STREAM_END)
+			decompressed = _dst_size - _decoder->inflate_.avail_out;
+	}
+	else if (_decoder->zstd_)
+	{
+		// The prepared dictionary is passed per call, one context serves entries of every dictionary
+		size_t ret;
+		if (_dictionary_id > 0u && pak->ddicts_)
+			ret = ZSTD_decompress_usingDDict(_decoder->zstd_, _dst, _dst_size, _src, _src_size, pak->ddicts_[_dictionary_id - 1u]);
+		else
+			ret = ZSTD_decompressDCtx(_decoder->zstd_, _dst, _dst_size, _src, _src_size);
+
+		if (!ZSTD_isError(ret))
+			decompressed = ret;
+	}
+	else if (_src_size == _dst_size)
+	{
+		memcpy(_dst, _src, _dst_size);
+		decompressed = _dst_size;
+	}
+
+	return decompressed;
+}
+
+size_t _gpak_in_place_margin(gpak_t* _pak, size_t _uncompressed_size)
+{
+	if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
+	{
+#ifdef ZSTD_DECOMPRESSION_MARGIN
+		return ZSTD_DECOMPRESSION_MARGIN(_uncompressed_size, ZSTD_BLOCKSIZE_MAX);
+#else
+		return SIZE_MAX;
+#endif
+	}
+	else if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
+		return SIZE_MAX;
+
+	// Stored payloads are read where they belong
+	(void)_uncompressed_size;
+	return 0ull;
+}
+
+char* _gpak_decoder_scratch(gpak_decoder_t* _decoder, size_t _size)
+{
+	if (_decoder->scratch_size_ < _size)
+	{
+		free(_decoder->scratch_);
+		_decoder->scratch_ = (char*)malloc(_size);
+		_decoder->scratch_size_ = _decoder->scratch_ ? _size : 0ull;
+	}
+
+	return _decoder->scratch_;
+}
+
+struct gpak_decoder_pool* _gpak_decoder_pool_create()
+{
+	struct gpak_decoder_pool* pool = (struct gpak_decoder_pool*)calloc(1, sizeof(struct gpak_decoder_pool));
+	_gpak_mutex_init(&pool->mutex_);
+	return pool;
+}
+
+void _gpak_decoder_pool_free(struct gpak_decoder_pool* _pool)
+{
+	if (!_pool)
+		return;
+
+	while (_pool->free_)
+	{
+		gpak_decoder_t* next = _pool->free_->next_;
+		_gpak_decoder_free(_pool->free_);
+		_pool->free_ = next;
+	}
+
+	_gpak_mutex_destroy(&_pool->mutex_);
+	free(_pool);
+}
+
+gpak_decoder_t* _gpak_decoder_acquire(gpak_t* _pak)
+{
+	struct gpak_decoder_pool* pool = _pak->decoder_pool_;
+
+	_gpak_mutex_lock(&pool->mutex_);
+	gpak_decoder_t* decoder = pool->free_;
+	if (decoder)
+		pool->free_ = decoder->next_;
+	_gpak_mutex_unlock(&pool->mutex_);
+
+	// The pool grows to the number of threads decoding at once
+	if (!decoder)
+		decoder = _gpak_decoder_create(_pak, 0u);
+
+	return decoder;
+}
+
+void _gpak_decoder_release(gpak_t* _pak, gpak_decoder_t* _decoder)
+{
+	struct gpak_decoder_pool* pool = _pak->decoder_pool_;
+
+	// Scratch memory left by an unusually large payload is not kept around
+	if (_decoder->scratch_size_ > GPAK_DECODER_SCRATCH_LIMIT)
+	{
+		free(_decoder->scratch_);
+		_decoder->scratch_ = NULL;
+		_decoder->scratch_size_ = 0ull;
+	}
+
+	_gpak_mutex_lock(&pool->mutex_);
+	_decoder->next_ = pool->free_;
+	pool->free_ = _decoder;
+	_gpak_mutex_unlock(&pool->mutex_);
+}
+
+size_t _gpak_compress_bound(gpak_t* _pak, size_t _src_size)
+{
+	size_t bound = _src_size;
+
+	if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
+		bound = compressBound((uLong)_src_size);
+	else if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
+		bound = ZSTD_compressBound(_src_size);
+
+	return bound > _src_size ? bound : _src_size;
+}
+
+// Compresses the data as a single frame of the archive codec, returns 0 if the codec fails
+static size_t _gpak_compress_frame(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, uint32_t _dictionary_id, int _checksum)
+{
+	size_t bound = _gpak_compress_bound(_pak, _src_size);
+	size_t compressed = 0ull;
+
+	if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_DEFLATE)
+	{
+		z_stream strm;
+		strm.zalloc = Z_NULL;
+		strm.zfree = Z_NULL;
+		strm.opaque = Z_NULL;
+
+		if (deflateInit(&strm, _pak->header_.compression_level_) == Z_OK)
+		{
+			strm.next_in = (Bytef*)_src;
+			strm.avail_in = (uInt)_src_size;
+			strm.next_out = (Bytef*)_dst;
+			strm.avail_out = (uInt)bound;
+
+			if (deflate(&strm, Z_FINISH) == Z_STREAM_END)
+				compressed = bound - strm.avail_out;
+
+			deflateEnd(&strm);
+		}
+	}
+	else if (_pak->header_.compression_ & GPAK_HEADER_COMPRESSION_ZST)
+	{
+		ZSTD_CCtx* const cctx = ZSTD_createCCtx();
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, _pak->header_.compression_level_);
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, _checksum);
+
+		if (_dictionary_id > 0u && _pak->cdicts_)
+			ZSTD_CCtx_refCDict(cctx, _pak->cdicts_[_dictionary_id - 1u]);
+
+		size_t const ret = ZSTD_compress2(cctx, _dst, bound, _src, _src_size);
+		if (!ZSTD_isError(ret))
+			compressed = ret;
+
+		ZSTD_freeCCtx(cctx);
+	}
+
+	return compressed;
+}
+
+size_t _gpak_compress_block(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, uint32_t _dictionary_id)
+{
+	size_t compressed = _gpak_compress_frame(_pak, _src, _src_size, _dst, _dictionary_id, 0);
+
+	// Data that does not shrink is stored as is
+	if (compressed == 0ull || compressed >= _src_size)
+	{
+		memcpy(_dst, _src, _src_size);
+		compressed = _src_size;
+	}
+
+	return compressed;
+}
+
+size_t _gpak_compress_buffer(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, uint32_t _dictionary_id)
+{
+	if (!(_pak->header_.compression_ & (GPAK_HEADER_COMPRESSION_DEFLATE | GPAK_HEADER_COMPRESSION_ZST)))
+	{
+		memcpy(_dst, _src, _src_size);
+		return _src_size;
+	}
+
+	// Whole files carry a checksum in their frame, as the streamed ones do
+	return _gpak_compress_frame(_pak, _src, _src_size, _dst, _dictionary_id, 1);
 }
\ No newline at end of file
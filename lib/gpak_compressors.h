@@ -33,6 +33,11 @@ extern "C" {
 	#include "gpak_export.h"
 	#include "gpak_data.h"
 
+	/**
+	 * @brief Typedef for the opaque gpak_decoder structure, an incremental decoder of a single entry payload.
+	 */
+	typedef struct gpak_decoder gpak_decoder_t;
+
 	/**
 	 * @brief Performs no compression on the input file.
 	 *
@@ -46,74 +51,307 @@ extern "C" {
 	GPAK_API uint32_t _gpak_compressor_none(gpak_t* _pak, FILE* _infile, FILE* _outfile);
 
 	/**
-	 * @brief Performs no decompression on the input file.
+	 * @brief Compresses the input file using the Deflate algorithm.
 	 *
-	 * This function reads data from the input file and writes it directly to the output file without any decompression.
+	 * This function compresses the input file using the Deflate algorithm and writes the compressed data to the output file.
 	 *
 	 * @param _pak A pointer to the gpak_t.
 	 * @param _infile A pointer to the input FILE.
 	 * @param _outfile A pointer to the output FILE.
-	 * @param _read_size The number of bytes to read from the input file.
 	 * @return The number of bytes written to the output file.
 	 */
-	GPAK_API uint32_t _gpak_decompressor_none(gpak_t* _pak, FILE* _infile, FILE* _outfile, size_t _read_size);
+	GPAK_API uint32_t _gpak_compressor_deflate(gpak_t* _pak, FILE* _infile, FILE* _outfile);
 
 	/**
-	 * @brief Compresses the input file using the Deflate algorithm.
-	 *
-	 * This function compresses the input file using the Deflate algorithm and writes the compressed data to the output file.
-	 *
+	 * @brief Compresses the input file using the Zstandard (zstd) algorithm.
+	 * 
+	 * This function compresses the input file using the Zstandard (zstd) algorithm and writes the compressed data to the output file.
+	 * 
 	 * @param _pak A pointer to the gpak_t.
 	 * @param _infile A pointer to the input FILE.
 	 * @param _outfile A pointer to the output FILE.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
 	 * @return The number of bytes written to the output file.
 	 */
-	GPAK_API uint32_t _gpak_compressor_deflate(gpak_t* _pak, FILE* _infile, FILE* _outfile);
+	GPAK_API uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile, uint32_t _dictionary_id);
 
 	/**
-	 * @brief Decompresses the input file using the Inflate algorithm.
+	 * @brief Decompresses a single chunk from memory to memory.
 	 *
-	 * This function decompresses the input file using the Inflate algorithm and writes the decompressed data to the output file.
+	 * This function decodes one chunk of an entry stored with GPAK_ENTRY_FLAG_CHUNKED, as compressed by _gpak_compress_block. It does not touch the archive stream and may be called from several threads at once.
 	 *
 	 * @param _pak A pointer to the gpak_t.
-	 * @param _infile A pointer to the input FILE.
-	 * @param _outfile A pointer to the output FILE.
-	 * @param _read_size The number of bytes to read from the input file.
-	 * @return The number of bytes written to the output file.
+	 * @param _src A pointer to the compressed chunk.
+	 * @param _src_size The compressed size of the chunk in bytes.
+	 * @param _dst A pointer to the buffer receiving the uncompressed chunk.
+	 * @param _dst_size The uncompressed size of the chunk in bytes.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
+	 * @return The number of bytes written to _dst, which differs from _dst_size if the chunk is corrupted.
 	 */
-	GPAK_API uint32_t _gpak_decompressor_inflate(gpak_t* _pak, FILE* _infile, FILE* _outfile, size_t _read_size);
+	GPAK_API size_t _gpak_decompress_chunk(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id);
 
 	/**
-	 * @brief Compresses the input file using the Zstandard (zstd) algorithm.
-	 * 
-	 * This function compresses the input file using the Zstandard (zstd) algorithm and writes the compressed data to the output file.
-	 * 
+	 * @brief Decompresses a whole entry payload from memory to memory.
+	 *
+	 * This function decodes a payload written by the streaming compressors, or copies it if the archive is not compressed. Unlike
+	 * _gpak_decompress_chunk it never treats a payload whose size equals the uncompressed size as stored.
+	 *
 	 * @param _pak A pointer to the gpak_t.
-	 * @param _infile A pointer to the input FILE.
-	 * @param _outfile A pointer to the output FILE.
-	 * @return The number of bytes written to the output file.
+	 * @param _src A pointer to the compressed payload.
+	 * @param _src_size The compressed size of the payload in bytes.
+	 * @param _dst A pointer to the buffer receiving the uncompressed payload.
+	 * @param _dst_size The uncompressed size of the payload in bytes.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
+	 * @return The number of bytes written to _dst, which differs from _dst_size if the payload is corrupted.
+	 */
+	GPAK_API size_t _gpak_decompress_buffer(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id);
+
+	/**
+	 * @brief Creates an incremental decoder for payloads written by the streaming compressors.
+	 *
+	 * @param _pak A pointer to the gpak_t whose codec and dictionaries are used.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
+	 * @return A pointer to the new gpak_decoder_t, or NULL if the codec context cannot be created.
+	 */
+	GPAK_API gpak_decoder_t* _gpak_decoder_create(gpak_t* _pak, uint32_t _dictionary_id);
+
+	/**
+	 * @brief Prepares a decoder for a new payload, keeping its context and dictionary.
+	 *
+	 * @param _decoder A pointer to the gpak_decoder_t.
+	 * @return GPAK_ERROR_OK on success, or a negative error code if the codec context cannot be reset.
+	 */
+	GPAK_API int _gpak_decoder_reset(gpak_decoder_t* _decoder);
+
+	/**
+	 * @brief Decodes as much of the input as fits into the output.
+	 *
+	 * This function may consume input without producing output and the other way around, the codec buffers data internally.
+	 *
+	 * @param _decoder A pointer to the gpak_decoder_t.
+	 * @param _src A pointer to the next compressed bytes.
+	 * @param _src_size The number of compressed bytes available, may be 0 to drain buffered output.
+	 * @param _src_used A pointer that receives the number of compressed bytes consumed.
+	 * @param _dst A pointer to the output buffer.
+	 * @param _dst_size The size of the output buffer in bytes.
+	 * @param _dst_used A pointer that receives the number of bytes written to _dst.
+	 * @return 1 if the end of the compressed stream was reached, 0 if more input or output space is needed, or a negative error code.
+	 */
+	GPAK_API int _gpak_decoder_run(gpak_decoder_t* _decoder, const void* _src, size_t _src_size, size_t* _src_used, void* _dst, size_t _dst_size, size_t* _dst_used);
+
+	/**
+	 * @brief Destroys a decoder created with _gpak_decoder_create.
+	 *
+	 * @param _decoder A pointer to the gpak_decoder_t, or NULL.
+	 */
+	GPAK_API void _gpak_decoder_free(gpak_decoder_t* _decoder);
+
+	/**
+	 * @brief Decompresses a whole payload from memory to memory with a decoder.
+	 *
+	 * This function decodes in one shot like _gpak_decompress_buffer but reuses the codec context of the decoder. The dictionary
+	 * the decoder was created with is ignored, the prepared dictionary _dictionary_id is used instead.
+	 *
+	 * @param _decoder A pointer to the gpak_decoder_t, usually taken from _gpak_decoder_acquire.
+	 * @param _src A pointer to the compressed payload.
+	 * @param _src_size The compressed size of the payload in bytes.
+	 * @param _dst A pointer to the buffer receiving the uncompressed payload.
+	 * @param _dst_size The uncompressed size of the payload in bytes.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
+	 * @return The number of bytes written to _dst, which differs from _dst_size if the payload is corrupted.
+	 */
+	GPAK_API size_t _gpak_decoder_decompress(gpak_decoder_t* _decoder, const void* _src, size_t _src_size, void* _dst, size_t _dst_size, uint32_t _dictionary_id);
+
+	/**
+	 * @brief Returns a scratch buffer owned by a decoder.
+	 *
+	 * The buffer keeps its content until the next call and is reused by the next owner of the decoder once it is released.
+	 *
+	 * @param _decoder A pointer to the gpak_decoder_t.
+	 * @param _size The number of bytes needed.
+	 * @return A pointer to at least _size bytes, or NULL if the memory cannot be allocated.
+	 */
+	GPAK_API char* _gpak_decoder_scratch(gpak_decoder_t* _decoder, size_t _size);
+
+	/**
+	 * @brief Returns the room needed past the uncompressed size of a payload to decode it in place.
+	 *
+	 * A payload decoded in place is read into the tail of its destination buffer and decoded towards its head, the margin
+	 * keeps the decoded bytes from overtaking the compressed bytes not consumed yet. Only single zstd frames can be decoded
+	 * in place.
+	 *
+	 * @param _pak A pointer to the gpak_t whose codec decodes the payload.
+	 * @param _uncompressed_size The uncompressed size of the payload in bytes.
+	 * @return The margin in bytes, 0 for stored payloads, or SIZE_MAX if the codec cannot decode in place.
+	 */
+	GPAK_API size_t _gpak_in_place_margin(gpak_t* _pak, size_t _uncompressed_size);
+
+	/**
+	 * @brief Creates the pool of reusable decoders of an archive.
+	 *
+	 * @return A pointer to the new, empty pool.
+	 */
+	GPAK_API struct gpak_decoder_pool* _gpak_decoder_pool_create();
+
+	/**
+	 * @brief Destroys a decoder pool and every decoder it holds.
+	 *
+	 * @param _pool A pointer to the pool, or NULL.
 	 */
-	GPAK_API uint32_t _gpak_compressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile);
+	GPAK_API void _gpak_decoder_pool_free(struct gpak_decoder_pool* _pool);
 
 	/**
-	 * @brief Decompresses the input file using the Zstandard (zstd) algorithm.
-	 * This function decompresses the input file using the Zstandard (zstd) algorithm and writes the decompressed data to the output file.
+	 * @brief Takes a decoder from the pool of an archive, creating one if the pool is empty.
+	 *
+	 * This function is thread-safe. The decoder has to be returned with _gpak_decoder_release.
+	 *
 	 * @param _pak A pointer to the gpak_t.
-	 * @param _infile A pointer to the input FILE.
-	 * @param _outfile A pointer to the output FILE.
-	 * @param _read_size The number of bytes to read from the input file.
-	 * @return The number of bytes written to the output file.
+	 * @return A pointer to the gpak_decoder_t, or NULL if the codec context cannot be created.
 	 */
-	GPAK_API uint32_t _gpak_decompressor_zstd(gpak_t* _pak, FILE* _infile, FILE* _outfile, size_t _read_size);
+	GPAK_API gpak_decoder_t* _gpak_decoder_acquire(gpak_t* _pak);
 
 	/**
-	 * @brief Generates a compression dictionary for the specified G-PAK archive.
-	 * This function generates a compression dictionary for the specified G-PAK archive, which can be used to improve the compression ratio for certain algorithms.
+	 * @brief Returns a decoder to the pool of an archive.
+	 *
+	 * This function is thread-safe.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _decoder A pointer to the gpak_decoder_t taken with _gpak_decoder_acquire.
+	 */
+	GPAK_API void _gpak_decoder_release(gpak_t* _pak, gpak_decoder_t* _decoder);
+
+	/**
+	 * @brief Compresses a block of memory with the archive codec.
+	 *
+	 * This function produces a single frame that _gpak_decompress_chunk can decode. If the codec fails or the data does not shrink,
+	 * the input is copied as is so that the compressed size equals the uncompressed size, which marks the block as stored.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _src A pointer to the uncompressed data.
+	 * @param _src_size The uncompressed size in bytes.
+	 * @param _dst A pointer to the buffer receiving the compressed data, at least _gpak_compress_bound(_pak, _src_size) bytes long.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
+	 * @return The number of bytes written to _dst.
+	 */
+	GPAK_API size_t _gpak_compress_block(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, uint32_t _dictionary_id);
+
+	/**
+	 * @brief Compresses a whole file in memory.
+	 *
+	 * This function produces the same payload as the streaming compressors, a single frame of the archive codec that is never
+	 * replaced by the input, so that plain entries decode the same way whichever path packed them. Archives without
+	 * compression get a copy of the input.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _src A pointer to the uncompressed data.
+	 * @param _src_size The uncompressed size in bytes.
+	 * @param _dst A pointer to the buffer receiving the compressed data, at least _gpak_compress_bound(_pak, _src_size) bytes long.
+	 * @param _dictionary_id The dictionary to use, see pak_entry_t::dictionary_id_.
+	 * @return The number of bytes written to _dst, or 0 if the codec failed.
+	 */
+	GPAK_API size_t _gpak_compress_buffer(gpak_t* _pak, const void* _src, size_t _src_size, void* _dst, uint32_t _dictionary_id);
+
+	/**
+	 * @brief Returns the size of the buffer needed by _gpak_compress_block.
+	 *
+	 * This function returns the worst case compressed size of _src_size bytes for the archive codec.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _src_size The uncompressed size in bytes.
+	 * @return The required size of the destination buffer in bytes.
+	 */
+	GPAK_API size_t _gpak_compress_bound(gpak_t* _pak, size_t _src_size);
+
+	/**
+	 * @brief Generates the compression dictionaries for the specified G-PAK archive.
+	 * This function groups the files to pack by class, their extension or the class returned by the dictionary classifier, and trains a dictionary for
+	 * every class with enough samples. Files of the remaining classes share a dictionary trained on all of them, stored with the class "*".
 	 * @param _pak A pointer to the gpak_t.
 	 * @return A non-negative value if the dictionary generation is successful, or a negative value if an error occurred.
 	 */
 	GPAK_API int32_t _gpak_compressor_generate_dictionary(gpak_t* _pak);
 
+	/**
+	 * @brief Returns the dictionary a file should be compressed with.
+	 *
+	 * This function classifies the internal path the same way _gpak_compressor_generate_dictionary does and looks the class up in the dictionary table.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _path The internal path of the file.
+	 * @return The dictionary id of the file class, the id of the shared dictionary if the class has none, or 0 if the archive has no dictionary.
+	 */
+	GPAK_API uint32_t _gpak_dictionary_find(gpak_t* _pak, const char* _path);
+
+	/**
+	 * @brief Prepares the dictionaries of the specified G-PAK archive for use.
+	 *
+	 * This function digests every dictionary once into a decompression dictionary, and into a compression dictionary when _compress is set,
+	 * so that compression and decompression contexts only reference them.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 * @param _compress Whether compression dictionaries are needed as well.
+	 * @return GPAK_ERROR_OK on success, or GPAK_ERROR_INVALID_DICTIONARY if a dictionary cannot be loaded.
+	 */
+	GPAK_API int _gpak_dictionaries_prepare(gpak_t* _pak, int _compress);
+
+	/**
+	 * @brief Releases the dictionary table and the prepared dictionaries of the specified G-PAK archive.
+	 *
+	 * @param _pak A pointer to the gpak_t.
+	 */
+	GPAK_API void _gpak_dictionaries_free(gpak_t* _pak);
+
+	/**
+	 * @brief Computes the content id of a set of dictionaries.
+	 * This function hashes the dictionary records and the dictionaries, the result is never 0.
+	 *
+	 * @param _dictionaries A pointer to the dictionary records.
+	 * @param _dictionary_count The number of dictionary records.
+	 * @param _dictionary A pointer to the dictionaries, stored back to back.
+	 * @param _dictionary_size The total size of the dictionaries in bytes.
+	 * @return The 64-bit content id.
+	 */
+	GPAK_API uint64_t _gpak_dictionary_content_id(const pak_dictionary_t* _dictionaries, uint32_t _dictionary_count, const char* _dictionary, uint32_t _dictionary_size);
+
+	/**
+	 * @brief Adds a set of dictionaries to the process-wide dictionary registry.
+	 * This function takes ownership of _dictionary and _dictionaries and prepares a decompression dictionary for each record.
+	 * If dictionaries with the same content id are already registered, the arguments are freed and the registered ones are returned.
+	 *
+	 * @param _dictionary A pointer to the dictionaries allocated with malloc, stored back to back.
+	 * @param _dictionary_size The total size of the dictionaries in bytes.
+	 * @param _dictionaries A pointer to the dictionary records allocated with malloc.
+	 * @param _dictionary_count The number of dictionary records.
+	 * @param _content_id The content id of the dictionaries.
+	 * @return A pointer to the registered gpak_shared_dictionary_t, or NULL if a dictionary cannot be loaded.
+	 */
+	GPAK_API gpak_shared_dictionary_t* _gpak_shared_dictionary_register(char* _dictionary, uint32_t _dictionary_size, pak_dictionary_t* _dictionaries, uint32_t _dictionary_count, uint64_t _content_id);
+
+	/**
+	 * @brief Removes dictionaries from the process-wide dictionary registry.
+	 * This function releases the reference held by the registry, archives still using the dictionaries keep them alive until they are closed.
+	 *
+	 * @param _content_id The content id of the dictionaries.
+	 * @return GPAK_ERROR_OK on success, or GPAK_ERROR_DICTIONARY_NOT_REGISTERED if no dictionaries have this content id.
+	 */
+	GPAK_API int _gpak_shared_dictionary_unregister(uint64_t _content_id);
+
+	/**
+	 * @brief Looks up registered dictionaries and takes a reference on them.
+	 *
+	 * @param _content_id The content id of the dictionaries.
+	 * @return A pointer to the gpak_shared_dictionary_t, or NULL if no dictionaries have this content id.
+	 */
+	GPAK_API gpak_shared_dictionary_t* _gpak_shared_dictionary_acquire(uint64_t _content_id);
+
+	/**
+	 * @brief Releases a reference taken with _gpak_shared_dictionary_acquire or held by the registry.
+	 * This function frees the dictionaries once the last reference is released.
+	 *
+	 * @param _shared A pointer to the gpak_shared_dictionary_t.
+	 */
+	GPAK_API void _gpak_shared_dictionary_release(gpak_shared_dictionary_t* _shared);
+
 #ifdef __cplusplus
 }
 #endif
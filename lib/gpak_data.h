@@ -102,6 +102,13 @@ enum gpak_compression_zstd
  */
 typedef enum gpak_compression_zstd gpak_compression_zstd_t;
 
+/**
+ * @brief The revision of the on-disk G-PAK format written by this version of the library.
+ *
+ * Archives with a different revision are rejected when opened.
+ */
+#define GPAK_FORMAT_VERSION 10
+
 /**
  * @brief Structure representing the header of a G-PAK archive.
  *
@@ -113,7 +120,9 @@ struct gpak_header
 	gpak_header_compression_algorithm_t compression_; /**< The compression algorithm used in the G-PAK archive. */
 	char compression_level_; /**< The compression level applied to the entries in the G-PAK archive. */
 	uint32_t entry_count_; /**< The number of entries in the G-PAK archive. */
-	uint32_t dictionary_size_; /**< The size of the dictionary used for compression in the G-PAK archive. */
+	uint32_t dictionary_size_; /**< The total size of the dictionaries used for compression in the G-PAK archive. */
+	uint32_t version_; /**< The revision of the on-disk format, see GPAK_FORMAT_VERSION. */
+	uint32_t alignment_; /**< The power of two every entry payload and solid block starts at a multiple of, 0 or 1 if payloads are not aligned. */
 };
 
 /**
@@ -124,17 +133,273 @@ struct gpak_header
 typedef struct gpak_header pak_header_t;
 
 
+/**
+ * @brief Structure representing the seek table header of a chunked G-PAK entry.
+ *
+ * Chunked entries are split into chunks of chunk_size_ uncompressed bytes (the last one may be shorter) that are compressed
+ * independently. The payload of such an entry starts with this header followed by chunk_count_ pak_chunk_t records and the chunk data.
+ */
+struct gpak_chunk_table
+{
+	uint32_t chunk_size_; /**< The uncompressed size of every chunk except the last one. */
+	uint32_t chunk_count_; /**< The number of chunks in the entry. */
+};
+
+/**
+ * @brief Typedef for the gpak_chunk_table structure.
+ *
+ * This typedef is used to create an alias for the gpak_chunk_table structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_chunk_table pak_chunk_table_t;
+
+/**
+ * @brief Structure representing a seek table record of a chunked G-PAK entry.
+ *
+ * A chunk whose compressed size equals its uncompressed size is stored without compression.
+ */
+struct gpak_chunk
+{
+	uint64_t offset_; /**< The offset of the chunk data from the beginning of the entry payload. */
+	uint32_t compressed_size_; /**< The compressed size of the chunk in bytes. */
+	uint32_t crc32_; /**< The CRC-32 checksum of the uncompressed chunk. */
+};
+
+/**
+ * @brief Typedef for the gpak_chunk structure.
+ *
+ * This typedef is used to create an alias for the gpak_chunk structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_chunk pak_chunk_t;
+
+
+/**
+ * @brief Structure representing a solid block record stored in the central directory.
+ *
+ * A solid block holds the contents of several small files concatenated and compressed as a single frame, or a single
+ * content-defined chunk shared by the chunk lists of several entries. A block whose compressed size equals its uncompressed
+ * size is stored without compression.
+ */
+struct gpak_block
+{
+	uint64_t offset_; /**< The offset of the block data from the beginning of the archive. */
+	uint32_t compressed_size_; /**< The compressed size of the block in bytes. */
+	uint32_t uncompressed_size_; /**< The uncompressed size of the block in bytes. */
+	uint32_t crc32_; /**< The CRC-32 checksum of the uncompressed block. */
+	uint32_t dictionary_id_; /**< The dictionary the block is compressed with, see pak_entry_t::dictionary_id_. */
+};
+
+/**
+ * @brief Typedef for the gpak_block structure.
+ *
+ * This typedef is used to create an alias for the gpak_block structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_block pak_block_t;
+
+
+/**
+ * @brief The maximum number of compression dictionaries trained for a G-PAK archive.
+ */
+#define GPAK_MAX_DICTIONARIES 16
+
+/**
+ * @brief The size of the null-terminated class name stored with every dictionary.
+ */
+#define GPAK_DICTIONARY_CLASS_SIZE 24
+
+/**
+ * @brief Structure representing a dictionary record stored in the central directory.
+ *
+ * The dictionaries of an archive are stored back to back at the beginning of the central directory. Each one is trained on
+ * the files of one class, by default the files sharing an extension, and the class name is kept so that files added in
+ * update mode are compressed with the matching dictionary.
+ */
+struct gpak_dictionary
+{
+	uint32_t offset_; /**< The offset of the dictionary from the beginning of the central directory. */
+	uint32_t size_; /**< The size of the dictionary in bytes. */
+	char class_[GPAK_DICTIONARY_CLASS_SIZE]; /**< The null-terminated class of the files the dictionary was trained on, "*" for the remaining files. */
+};
+
+/**
+ * @brief Typedef for the gpak_dictionary structure.
+ *
+ * This typedef is used to create an alias for the gpak_dictionary structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_dictionary pak_dictionary_t;
+
+/**
+ * @brief Flags describing where the dictionaries of a G-PAK archive are stored.
+ */
+enum gpak_dictionary_table_flag
+{
+	GPAK_DICTIONARY_TABLE_FLAG_NONE = 0,			/**< The dictionaries are stored in the archive. */
+	GPAK_DICTIONARY_TABLE_FLAG_SHARED = 1 << 0		/**< The dictionaries are stored in the standalone dictionary file identified by shared_id_. */
+};
+
+/**
+ * @brief Structure representing the header of the dictionary table in the central directory.
+ *
+ * It is followed by dictionary_count_ pak_dictionary_t records, unless the archive references a shared dictionary
+ * file, in which case the records and dictionaries are taken from the registered file.
+ */
+struct gpak_dictionary_table
+{
+	uint32_t dictionary_count_; /**< The number of dictionaries the entries may reference. */
+	uint32_t flags_; /**< A combination of gpak_dictionary_table_flag values. */
+	uint64_t shared_id_; /**< The content id of the shared dictionary file, or 0 if the dictionaries are stored in the archive. */
+};
+
+/**
+ * @brief Typedef for the gpak_dictionary_table structure.
+ *
+ * This typedef is used to create an alias for the gpak_dictionary_table structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_dictionary_table pak_dictionary_table_t;
+
+/**
+ * @brief The revision of the standalone dictionary file format.
+ */
+#define GPAK_DICTIONARY_FORMAT_VERSION 1
+
+/**
+ * @brief Structure representing the header of a standalone dictionary file.
+ *
+ * The header is followed by dictionary_count_ pak_dictionary_t records and dictionary_size_ bytes of dictionaries.
+ * The content id is a hash of the records and the dictionaries, archives packed with the file store it to find the
+ * file in the dictionary registry.
+ */
+struct gpak_dictionary_file_header
+{
+	char format_[8]; /**< A null-terminated string identifying a standalone dictionary file, "gpakdct". */
+	uint32_t version_; /**< The revision of the dictionary file format, see GPAK_DICTIONARY_FORMAT_VERSION. */
+	uint32_t dictionary_count_; /**< The number of dictionaries in the file. */
+	uint32_t dictionary_size_; /**< The total size of the dictionaries in bytes. */
+	uint32_t reserved_; /**< Reserved, always zero. */
+	uint64_t content_id_; /**< The content id of the dictionaries. */
+};
+
+/**
+ * @brief Typedef for the gpak_dictionary_file_header structure.
+ *
+ * This typedef is used to create an alias for the gpak_dictionary_file_header structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_dictionary_file_header pak_dictionary_file_header_t;
+
+/**
+ * @brief Structure representing a standalone dictionary file loaded into the process-wide dictionary registry.
+ *
+ * The dictionaries are digested once and shared by every archive that references them. The record is freed when it
+ * is unregistered and the last archive using it is closed.
+ */
+struct gpak_shared_dictionary
+{
+	uint64_t content_id_; /**< The content id of the dictionary file. */
+	uint32_t reference_count_; /**< The number of archives using the dictionaries, plus one while it is registered. */
+	uint32_t dictionary_count_; /**< The number of dictionaries. */
+	uint32_t dictionary_size_; /**< The total size of the dictionaries in bytes. */
+	char* dictionary_; /**< The dictionaries, stored back to back. */
+	pak_dictionary_t* dictionaries_; /**< The dictionary table locating every dictionary inside dictionary_. */
+	struct ZSTD_DDict_s** ddicts_; /**< The prepared decompression dictionaries, one per dictionary. */
+	struct gpak_shared_dictionary* next_; /**< The next registered dictionary file. */
+};
+
+/**
+ * @brief Typedef for the gpak_shared_dictionary structure.
+ *
+ * This typedef is used to create an alias for the gpak_shared_dictionary structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_shared_dictionary gpak_shared_dictionary_t;
+
+
+/**
+ * @brief Structure representing the footer of a G-PAK archive.
+ *
+ * The footer is the last thing written to the archive. It locates the central directory, a single contiguous
+ * block holding the compression dictionary, the pak_entry_t records of all files, the offsets of their names
+ * followed by the names themselves, the path index, the solid block table, the chunk lists and the dictionary table, so that an archive
+ * can be indexed without walking its payloads.
+ */
+struct gpak_footer
+{
+	uint64_t directory_offset_; /**< The offset of the central directory from the beginning of the archive. */
+	uint64_t directory_size_; /**< The size of the central directory in bytes. */
+	uint64_t entries_offset_; /**< The offset of the entry records from the beginning of the central directory. */
+	uint64_t names_offset_; /**< The offset of the entry names from the beginning of the central directory. */
+	uint64_t index_offset_; /**< The offset of the path index from the beginning of the central directory. */
+	uint64_t blocks_offset_; /**< The offset of the solid block table from the beginning of the central directory. */
+	uint64_t chunk_list_offset_; /**< The offset of the chunk list table from the beginning of the central directory. */
+	uint64_t dictionaries_offset_; /**< The offset of the dictionary table from the beginning of the central directory. */
+	char magic_[8]; /**< A null-terminated string identifying the footer ("gpakdir"). */
+};
+
+/**
+ * @brief Typedef for the gpak_footer structure.
+ *
+ * This typedef is used to create an alias for the gpak_footer structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_footer pak_footer_t;
+
+
+/**
+ * @brief Structure representing a bucket of the path index stored in the central directory.
+ *
+ * The path index is an open addressing hash table over the full internal paths of all entries. Its size is a power of two
+ * and it is kept at most half full, so a lookup hashes the path once and usually compares a single name.
+ */
+struct gpak_index_bucket
+{
+	uint64_t hash_; /**< The 64-bit hash of the full internal path. */
+	uint32_t entry_; /**< The index of the entry in the central directory, or UINT32_MAX for an empty bucket. */
+	uint32_t reserved_; /**< Reserved, always zero. */
+};
+
+/**
+ * @brief Typedef for the gpak_index_bucket structure.
+ *
+ * This typedef is used to create an alias for the gpak_index_bucket structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_index_bucket pak_index_bucket_t;
+
+
+/**
+ * @brief Enumeration representing the storage flags of a G-PAK entry.
+ *
+ * This enumeration contains values describing how the payload of an entry is laid out in the archive.
+ */
+enum gpak_entry_flag
+{
+	GPAK_ENTRY_FLAG_NONE = 0,			/**< The payload is a single compressed stream. */
+	GPAK_ENTRY_FLAG_CHUNKED = 1 << 0,	/**< The payload starts with a pak_chunk_table_t and is split into independently compressed chunks. */
+	GPAK_ENTRY_FLAG_SOLID = 1 << 1,		/**< The entry is stored in the solid block block_index_, offset_ is its offset inside the uncompressed block. */
+	GPAK_ENTRY_FLAG_SHARED = 1 << 2,	/**< The payload is shared with other entries of byte-identical content. */
+	GPAK_ENTRY_FLAG_CHUNK_LIST = 1 << 3	/**< The entry is the concatenation of block_count_ blocks listed in the chunk list table starting at block_index_. */
+};
+
+/**
+ * @brief Typedef for the gpak_entry_flag enumeration.
+ *
+ * This typedef is used to create an alias for the gpak_entry_flag enumeration, providing a more convenient way to use the enumeration in the code.
+ */
+typedef enum gpak_entry_flag gpak_entry_flag_t;
+
 /**
  * @brief Structure representing an entry header in a G-PAK archive.
  *
  * This structure contains information about a single entry within a G-PAK archive, including its compressed and uncompressed sizes, the offset at which it is stored, and its CRC-32 checksum.
+ * It is also the on-disk record of the central directory: all fields have explicit widths and are laid out without padding, so the
+ * 48-byte records are used in place by readers. Multi-byte fields are stored in little-endian order.
  */
 struct gpak_entry_header
 {
-	uint32_t compressed_size_; /**< The compressed size of the entry in bytes. */
-	uint32_t uncompressed_size_; /**< The uncompressed size of the entry in bytes. */
-	size_t offset_; /**< The offset at which the entry is stored in the G-PAK archive. */
+	uint64_t compressed_size_; /**< The compressed size of the entry in bytes, zero for entries stored in solid blocks or chunk lists. */
+	uint64_t uncompressed_size_; /**< The uncompressed size of the entry in bytes. */
+	uint64_t offset_; /**< The offset at which the entry is stored in the G-PAK archive, or inside its solid block. */
 	uint32_t crc32_; /**< The CRC-32 checksum of the entry. */
+	uint32_t flags_; /**< A combination of gpak_entry_flag values describing how the entry is stored. */
+	uint32_t block_index_; /**< The index of the solid block holding the entry, or of its first chunk list record with GPAK_ENTRY_FLAG_CHUNK_LIST. */
+	uint32_t block_count_; /**< The number of chunk list records describing the entry, only meaningful with GPAK_ENTRY_FLAG_CHUNK_LIST. */
+	uint32_t dictionary_id_; /**< The index of the dictionary the entry is compressed with plus one, or 0 if it is compressed without a dictionary. */
+	uint32_t reserved_; /**< Reserved, always zero. */
 };
 
 /**
@@ -186,7 +451,29 @@ enum gpak_error
 
 	// dictionary
 	GPAK_ERROR_INVALID_DICTIONARY = -23,			/**< The dictionary is invalid. */
-	GPAK_ERROR_FAILED_TO_CREATE_DICTIONARY = -24	/**< Failed to create a dictionary. */
+	GPAK_ERROR_FAILED_TO_CREATE_DICTIONARY = -24,	/**< Failed to create a dictionary. */
+
+	// directory
+	GPAK_ERROR_INVALID_DIRECTORY = -25,				/**< The central directory is missing or corrupted. */
+
+	// alignment
+	GPAK_ERROR_INVALID_ALIGNMENT = -26,				/**< The payload alignment is not a power of two or cannot be changed. */
+
+	// shared dictionary
+	GPAK_ERROR_DICTIONARY_NOT_REGISTERED = -27,		/**< The shared dictionary file referenced by the archive is not registered. */
+
+	// buffer
+	GPAK_ERROR_BUFFER_TOO_SMALL = -28,				/**< The destination buffer is smaller than the decoded file. */
+
+	// request queue
+	GPAK_ERROR_CANCELLED = -29,						/**< The request was cancelled before it completed. */
+	GPAK_ERROR_DEADLINE_EXCEEDED = -30,				/**< The request could not be completed before its deadline. */
+
+	// raw entries
+	GPAK_ERROR_NOT_PLAIN_ENTRY = -31,				/**< The entry is chunked, packed in a solid block or deduplicated and has no payload of its own. */
+
+	// extraction
+	GPAK_ERROR_UNSAFE_PATH = -32					/**< The internal path would be extracted outside of the destination directory. */
 };
 
 /**
@@ -206,7 +493,8 @@ enum gpak_mode_flag
 	GPAK_MODE_NONE = 0,					/**< No specific mode flag is set. */
 	GPAK_MODE_CREATE = 1 << 0,			/**< Create mode: allows writing to the archive. Analogous to write byte operation. */
 	GPAK_MODE_READ_ONLY = 1 << 1,		/**< Read-only mode: allows only reading from the archive. Analogous to read byte operation. */
-	GPAK_MODE_UPDATE = 1 << 2			/**< Update mode: allows both reading and writing to the archive. */
+	GPAK_MODE_UPDATE = 1 << 2,			/**< Update mode: allows both reading and writing to the archive. */
+	GPAK_MODE_MEMORY_MAP = 1 << 3		/**< Memory-mapped mode: read-only mode that maps the archive and reads headers, directory and payloads from the mapping. */
 };
 
 /**
@@ -246,6 +534,126 @@ typedef void (*gpak_error_handler_t)(const char*, int32_t, void*);
  */
 typedef void (*gpak_progress_handler_t)(const char*, size_t, size_t, int32_t, void*);
 
+/**
+ * @typedef gpak_dictionary_classifier_t
+ * @brief A callback function returning the dictionary class of a file from its internal path, or NULL to use its extension.
+ */
+typedef const char* (*gpak_dictionary_classifier_t)(const char*, void*);
+
+
+/**
+ * @brief The number of decoded blocks, chunks and shared payloads kept in memory by an open archive.
+ */
+#define GPAK_BLOCK_CACHE_SIZE 16
+
+/**
+ * @brief The size of each of the two output buffers of a streamed file, one is read while the other one is decoded.
+ */
+#define GPAK_STREAM_SLOT_SIZE (256u * 1024u)
+
+/**
+ * @brief The number of compressed bytes a streamed file reads from the archive at once.
+ */
+#define GPAK_STREAM_INPUT_SIZE (128u * 1024u)
+
+/**
+ * @brief The largest scratch buffer a pooled decoder keeps once it is returned to the pool.
+ */
+#define GPAK_DECODER_SCRATCH_LIMIT (1024u * 1024u)
+
+/**
+ * @brief The number of reads an asynchronous read queue keeps in flight when created with a depth of 0.
+ */
+#define GPAK_ASYNC_QUEUE_DEPTH 64u
+
+/**
+ * @brief The largest gap between two payloads a batch read reads through instead of issuing a second read.
+ */
+#define GPAK_BATCH_GAP_SIZE (64u * 1024u)
+
+/**
+ * @brief The size up to which a batch read merges neighbouring payloads into one sequential read.
+ */
+#define GPAK_BATCH_READ_SIZE (4u * 1024u * 1024u)
+
+/**
+ * @brief The amount of decoded content an extraction reads at once, larger files are streamed to disk on their own.
+ */
+#define GPAK_EXTRACT_WINDOW_SIZE (64u * 1024u * 1024u)
+
+/**
+ * @brief The amount of decoded content an extraction keeps waiting for the writers before it stops reading.
+ */
+#define GPAK_EXTRACT_BUFFER_SIZE (4ull * GPAK_EXTRACT_WINDOW_SIZE)
+
+/**
+ * @brief The size of the writes an extraction streams large files to disk with.
+ */
+#define GPAK_EXTRACT_WRITE_SIZE (4u * 1024u * 1024u)
+
+/**
+ * @brief The amount of file content packing reads ahead of the writer, the compressor workers stop being fed beyond it.
+ */
+#define GPAK_PACK_BUFFER_SIZE (256ull * 1024ull * 1024ull)
+
+/**
+ * @brief The largest file a compressor worker packs in memory, larger files that are not chunked are streamed by the writer.
+ */
+#define GPAK_PACK_JOB_SIZE (64u * 1024u * 1024u)
+
+/**
+ * @brief The number of reads and compressions packing queues ahead of the writer, whatever their size.
+ */
+#define GPAK_PACK_QUEUE_LENGTH 1024u
+
+/**
+ * @brief The number of filled solid blocks packing keeps compressing before the writer waits for the oldest one.
+ */
+#define GPAK_PACK_PENDING_BLOCKS 16u
+
+/**
+ * @brief Structure representing a decoded solid block or shared payload kept in memory.
+ *
+ * Sibling files usually share a block and deduplicated entries share a payload, so the most recently used ones are kept
+ * decoded to avoid decompressing them again.
+ */
+struct gpak_block_cache_entry
+{
+	uint64_t offset_; /**< The archive offset of the block or payload, used as the cache key. */
+	char* data_; /**< The uncompressed data, or NULL if the slot is empty. */
+	uint64_t last_used_; /**< The value of the cache clock when the block was last used. */
+};
+
+/**
+ * @brief Typedef for the gpak_block_cache_entry structure.
+ *
+ * This typedef is used to create an alias for the gpak_block_cache_entry structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_block_cache_entry gpak_block_cache_entry_t;
+
+/**
+ * @brief Structure representing the counters of the decoded entry cache of an archive.
+ *
+ * The counters are filled by gpak_get_cache_stats, hits and misses only count lookups made while the cache is enabled or holds pinned entries.
+ */
+struct gpak_cache_stats
+{
+	uint64_t hits_; /**< The number of files opened from an already decoded entry. */
+	uint64_t misses_; /**< The number of files that had to be decoded. */
+	uint64_t evictions_; /**< The number of entries dropped to stay within the budget. */
+	uint64_t size_; /**< The number of decoded bytes currently held. */
+	uint64_t budget_; /**< The number of decoded bytes the cache may hold. */
+	uint64_t entry_count_; /**< The number of entries currently held. */
+	uint64_t pinned_count_; /**< The number of entries that are never evicted. */
+};
+
+/**
+ * @brief Typedef for the gpak_cache_stats structure.
+ *
+ * This typedef is used to create an alias for the gpak_cache_stats structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_cache_stats gpak_cache_stats_t;
+
 
 /**
  * @brief Structure representing a G-PAK archive.
@@ -256,14 +664,44 @@ struct gpak
 {
 	int mode_; /**< The access mode of the G-PAK archive (read, write, update, etc.). */
 	pak_header_t header_; /**< The header information of the G-PAK archive. */
+	pak_footer_t footer_; /**< The footer of the G-PAK archive locating its central directory. */
 	FILE* stream_; /**< The file stream associated with the G-PAK archive. */
 	struct filesystem_tree_node* root_; /**< The root node of the filesystem tree representing the archive's directory structure. */
-	int last_error_; /**< The last error code encountered during G-PAK operations. */
-	char* dictionary_; /**< The compression dictionary for the G-PAK archive. */
+	char* dictionary_; /**< The compression dictionaries of the G-PAK archive, stored back to back. */
+	pak_dictionary_t* dictionaries_; /**< The dictionary table locating every dictionary inside dictionary_. */
+	uint32_t dictionary_count_; /**< The number of dictionaries. */
+	struct ZSTD_CDict_s** cdicts_; /**< The prepared compression dictionaries, one per dictionary, created when packing. */
+	struct ZSTD_DDict_s** ddicts_; /**< The prepared decompression dictionaries, one per dictionary. */
+	gpak_dictionary_classifier_t dictionary_classifier_; /**< The user rule grouping files by dictionary, or NULL to group them by extension. */
+	gpak_shared_dictionary_t* shared_dictionary_; /**< The registered dictionary file the dictionaries belong to, or NULL if they are stored in the archive. */
+	const char* directory_; /**< The central directory of the archive, entry records, names and the path index are used in place. */
+	char* directory_buffer_; /**< The copy of the central directory read from stream_, or NULL if directory_ points into memory_. */
+	const char* memory_; /**< The archive image when it is read from memory or a mapped file, or NULL if it is read through stream_. */
+	uint64_t memory_size_; /**< The size of the archive image in bytes. */
+	void* memory_handle_; /**< The platform handle of the mapping backing memory_, only meaningful if memory_mapped_ is set. */
+	int memory_mapped_; /**< Whether memory_ is a mapping owned by the archive and released when it is closed. */
+	const pak_entry_t* entries_; /**< The entry records inside the central directory, in central directory order. */
+	const pak_index_bucket_t* index_; /**< The path index inside the central directory, or NULL if the archive has none. */
+	uint32_t index_mask_; /**< The number of path index buckets minus one. */
+	const char** entry_paths_; /**< The full internal paths of the entries, in central directory order. */
+	struct filesystem_tree_file** entry_files_; /**< The filesystem tree files of the entries, in central directory order. */
 	char* current_file_; /**< The current file being processed during G-PAK operations. */
 	gpak_error_handler_t error_handler_; /**< The error handler function for G-PAK operations. */
 	gpak_progress_handler_t progress_handler_; /**< The progress handler function for G-PAK operations. */
 	void* user_data_; /**< User-defined data associated with the G-PAK archive. */
+	uint32_t chunk_size_; /**< The chunk size used to split large files when packing, or 0 to store them as a single stream. */
+	struct gpak_thread_pool* thread_pool_; /**< The worker threads used to decode chunks in parallel, created on first use. */
+	uint32_t solid_block_size_; /**< The size of the solid blocks small files are packed into, or 0 to store every file on its own. */
+	pak_block_t* blocks_; /**< The solid block table, read from the central directory and extended while packing. */
+	uint32_t block_count_; /**< The number of solid blocks. */
+	uint32_t content_chunk_size_; /**< The average size of content-defined chunks used to deduplicate large files when packing, or 0 to disable it. */
+	uint32_t* chunk_list_; /**< The chunk list table, block indices referenced by entries with GPAK_ENTRY_FLAG_CHUNK_LIST. */
+	uint32_t chunk_list_count_; /**< The number of records in the chunk list table. */
+	struct gpak_decoder_pool* decoder_pool_; /**< The decoding contexts and scratch buffers reused across reads, shared by the threads reading the archive. */
+	struct gpak_entry_cache* entry_cache_; /**< The decoded entries shared by the handles opened on them, bounded by a byte budget. */
+	struct gpak_block_cache* block_cache_; /**< The most recently decoded solid blocks and shared payloads, guarded for the threads reading the archive. */
+	uint64_t stream_threshold_; /**< The uncompressed size from which entries are streamed instead of decoded at once, or 0 to never stream them. */
+	int in_place_decoding_; /**< Whether plain payloads read from stream_ are decoded in place in their destination buffer. */
 };
 
 /**
@@ -277,13 +715,23 @@ typedef struct gpak gpak_t;
 /**
  * @brief Structure representing a file within a G-PAK archive.
  *
- * This structure contains information about a file in a G-PAK archive, including its data, file stream, and CRC32 checksum.
+ * This structure contains information about a file in a G-PAK archive, including its data, read position, and CRC32 checksum.
  */
 struct gpak_file
 {
-	char* data_; /**< The data of the file in the G-PAK archive. */
-	FILE* stream_; /**< The file stream associated with the file in the G-PAK archive. */
+	char* data_; /**< The data of the file in the G-PAK archive, or the currently decoded chunk of a chunked file. */
 	uint32_t crc32_; /**< The CRC32 checksum of the file in the G-PAK archive. */
+	gpak_t* pak_; /**< The archive the file was opened from. */
+	pak_entry_t entry_; /**< The entry header of the file. */
+	pak_chunk_table_t chunk_table_; /**< The seek table header of a chunked file. */
+	pak_chunk_t* chunks_; /**< The seek table of a chunked file, or NULL if the file was decoded at once. */
+	uint32_t chunk_index_; /**< The index of the chunk held in data_, or UINT32_MAX if none is decoded. */
+	uint32_t chunk_batch_; /**< The number of whole chunks a large read of a chunked file decodes at once. */
+	uint64_t position_; /**< The read position in the file. */
+	int eof_; /**< Whether a read went past the end of the file. */
+	int pushback_; /**< The character pushed back by gpak_ungetc plus one, or 0 if there is none. */
+	struct gpak_stream_reader* reader_; /**< The background decoder of a streamed file, or NULL if the file is not streamed. */
+	struct gpak_cached_entry* cached_; /**< The entry cache item data_ belongs to, or NULL if data_ is owned by the file. */
 };
 
 /**
@@ -293,6 +741,92 @@ struct gpak_file
  */
 typedef struct gpak_file gpak_file_t;
 
+/**
+ * @brief Structure representing the whole content of an entry returned by gpak_fmap.
+ *
+ * Stored entries of archives read from memory or a mapped file point straight into the archive image, other entries
+ * are decoded into a buffer owned by the view.
+ */
+struct gpak_view
+{
+	const char* data_; /**< The content of the entry. */
+	uint64_t size_; /**< The size of the content in bytes. */
+	char* buffer_; /**< The decoded content data_ points to, or NULL if data_ points into the archive image or the entry cache. */
+	struct gpak_cached_entry* cached_; /**< The entry cache item data_ belongs to, or NULL. */
+};
+
+/**
+ * @brief Typedef for the gpak_view structure.
+ *
+ * This typedef is used to create an alias for the gpak_view structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_view gpak_view_t;
+
+/**
+ * @brief Structure representing the compressed payload of an entry returned by gpak_fmap_raw or gpak_stat_raw.
+ *
+ * The payload is a single stream of the codec of the archive, it is decoded by the codec alone given the dictionary
+ * if any, and the decoded content matches crc32_.
+ */
+struct gpak_raw_entry
+{
+	const char* data_; /**< The compressed payload, or NULL if it was not mapped. */
+	uint64_t offset_; /**< The offset of the payload from the beginning of the archive, to read or send it directly from the archive file. */
+	uint64_t compressed_size_; /**< The size of the payload in bytes. */
+	uint64_t uncompressed_size_; /**< The size of the decoded content in bytes. */
+	uint32_t crc32_; /**< The CRC-32 checksum of the decoded content. */
+	int compression_; /**< The codec of the payload, GPAK_HEADER_COMPRESSION_NONE for stored payloads. */
+	uint32_t dictionary_id_; /**< The dictionary the payload is compressed with, 0 for none, see pak_entry_t::dictionary_id_. */
+	const char* dictionary_; /**< The content of the dictionary, owned by the archive, or NULL for none. */
+	uint64_t dictionary_size_; /**< The size of the dictionary in bytes. */
+	char* buffer_; /**< The buffer data_ was read into, or NULL if data_ points into the archive image. */
+};
+
+/**
+ * @brief Typedef for the gpak_raw_entry structure.
+ *
+ * This typedef is used to create an alias for the gpak_raw_entry structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_raw_entry gpak_raw_entry_t;
+
+/**
+ * @typedef gpak_read_handler_t
+ * @brief A callback function receiving an entry read by gpak_async_read, its path, the error code, the view taking over the content and user data.
+ */
+typedef void (*gpak_read_handler_t)(const char*, int32_t, gpak_view_t*, void*);
+
+/**
+ * @brief Typedef for the opaque gpak_async structure, a queue of asynchronous entry reads created by gpak_async_create.
+ */
+typedef struct gpak_async gpak_async_t;
+
+/**
+ * @brief Typedef for the opaque gpak_queue structure, a prioritized queue of entry reads created by gpak_queue_create.
+ */
+typedef struct gpak_queue gpak_queue_t;
+
+/**
+ * @brief Structure representing one file of a batch read made with gpak_read_batch.
+ *
+ * The path and destination are filled by the caller, the error and, without a destination buffer, the view are filled
+ * by gpak_read_batch.
+ */
+struct gpak_batch_read
+{
+	const char* path_; /**< The internal path of the file. */
+	void* dst_; /**< The buffer receiving the content, or NULL to decode it into view_. */
+	size_t dst_size_; /**< The size of dst_, at least the uncompressed size of the file. */
+	gpak_view_t view_; /**< The content of the file if dst_ is NULL, release it with gpak_funmap. */
+	int32_t error_; /**< GPAK_ERROR_OK if the file was read, or a negative error code. */
+};
+
+/**
+ * @brief Typedef for the gpak_batch_read structure.
+ *
+ * This typedef is used to create an alias for the gpak_batch_read structure, providing a more convenient way to use the structure in the code.
+ */
+typedef struct gpak_batch_read gpak_batch_read_t;
+
 
 /**
  * @brief Structure representing a file within a filesystem tree.
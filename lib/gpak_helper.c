@@ -1,17 +1,58 @@
+#ifndef _WIN32
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include "gpak_helper.h"
+#include "gpak_threads.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Readers sharing one archive keep their error and the path they work on per thread
+static GPAK_THREAD_LOCAL int _gpak_thread_error = GPAK_ERROR_OK;
+static GPAK_THREAD_LOCAL const char* _gpak_thread_path = NULL;
 
 int _gpak_make_error(gpak_t* _pak, int _error_code)
 {
-	_pak->last_error_ = _error_code;
+	_gpak_thread_error = _error_code;
 
 	if (_pak->error_handler_ && _error_code != GPAK_ERROR_OK)
 	{
-		_pak->error_handler_(_pak->current_file_, _error_code, _pak->user_data_);
+		_pak->error_handler_(_gpak_thread_path ? _gpak_thread_path : _pak->current_file_, _error_code, _pak->user_data_);
 	}
 
 	return _error_code;
 }
 
+int _gpak_last_error()
+{
+	return _gpak_thread_error;
+}
+
+void _gpak_set_thread_path(const char* _path)
+{
+	_gpak_thread_path = _path;
+}
+
+const char* _gpak_get_thread_path()
+{
+	return _gpak_thread_path;
+}
+
 void _gpak_pass_progress(gpak_t* _pak, size_t _done, size_t _total, int32_t _stage)
 {
 	if (_pak->progress_handler_)
@@ -26,4 +67,239 @@ size_t _fwriteb(const void* _data, size_t _elemSize, size_t _elemCount, FILE* _f
 size_t _freadb(void* _data, size_t _elemSize, size_t _elemCount, FILE* _file)
 {
 	return fread(_data, _elemSize, _elemCount, _file) * _elemSize;
+}
+
+int64_t _gpak_ftell64(FILE* _file)
+{
+#ifdef _WIN32
+	return _ftelli64(_file);
+#else
+	return (int64_t)ftello(_file);
+#endif
+}
+
+int _gpak_fseek64(FILE* _file, int64_t _offset, int _origin)
+{
+#ifdef _WIN32
+	return _fseeki64(_file, _offset, _origin);
+#else
+	return fseeko(_file, (off_t)_offset, _origin);
+#endif
+}
+
+size_t _gpak_pread(FILE* _file, uint64_t _offset, void* _dst, size_t _size)
+{
+	size_t total_readed = 0ull;
+
+#ifdef _WIN32
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(_file));
+	while (total_readed < _size)
+	{
+		uint64_t position = _offset + total_readed;
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(OVERLAPPED));
+		overlapped.Offset = (DWORD)position;
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+
+		size_t remaining = _size - total_readed;
+		DWORD readed = 0;
+		if (!ReadFile(handle, (char*)_dst + total_readed, remaining > 0x40000000ull ? 0x40000000u : (DWORD)remaining, &readed, &overlapped) || readed == 0)
+			break;
+
+		total_readed += readed;
+	}
+#else
+	int descriptor = fileno(_file);
+	while (total_readed < _size)
+	{
+		ssize_t readed = pread(descriptor, (char*)_dst + total_readed, _size - total_readed, (off_t)(_offset + total_readed));
+		if (readed <= 0)
+			break;
+
+		total_readed += (size_t)readed;
+	}
+#endif
+
+	return total_readed;
+}
+
+uint32_t _gpak_crc32_bytes(const void* _data, uint64_t _size)
+{
+	const Bytef* data = (const Bytef*)_data;
+	uLong _crc32 = crc32(0L, Z_NULL, 0);
+
+	// zlib takes 32-bit lengths
+	while (_size > 0ull)
+	{
+		uInt slice = _size > (1ull << 30u) ? (uInt)(1u << 30u) : (uInt)_size;
+		_crc32 = crc32(_crc32, data, slice);
+		data += slice;
+		_size -= slice;
+	}
+
+	return (uint32_t)_crc32;
+}
+
+uint64_t _gpak_hash_path(const char* _path)
+{
+	uint64_t hash = 14695981039346656037ull;
+	while (*_path)
+	{
+		hash ^= (uint8_t)*_path++;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+const char* _gpak_map_file(const char* _path, uint64_t* _size, void** _handle)
+{
+	*_size = 0ull;
+	*_handle = NULL;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+
+	// The view keeps the mapping alive, the file handle is not needed once it exists
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return NULL;
+
+	const char* data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return NULL;
+	}
+
+	*_size = (uint64_t)file_size.QuadPart;
+	*_handle = mapping;
+	return data;
+#else
+	int file = open(_path, O_RDONLY);
+	if (file < 0)
+		return NULL;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size <= 0)
+	{
+		close(file);
+		return NULL;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	*_size = (uint64_t)info.st_size;
+	return (const char*)data;
+#endif
+}
+
+void _gpak_unmap_file(const char* _data, uint64_t _size, void* _handle)
+{
+	if (!_data)
+		return;
+
+#ifdef _WIN32
+	(void)_size;
+	UnmapViewOfFile(_data);
+	CloseHandle((HANDLE)_handle);
+#else
+	(void)_handle;
+	munmap((void*)_data, (size_t)_size);
+#endif
+}
+
+uint64_t _gpak_hash_bytes(uint64_t _hash, const void* _data, size_t _size)
+{
+	const uint8_t* bytes = (const uint8_t*)_data;
+	for (size_t idx = 0ull; idx < _size; ++idx)
+	{
+		_hash ^= bytes[idx];
+		_hash *= 1099511628211ull;
+	}
+
+	return _hash;
+}
+
+// Creates one directory, an existing one counts as created
+static int _gpak_make_directory(const char* _path)
+{
+#ifdef _WIN32
+	if (_mkdir(_path) == 0 || errno == EEXIST)
+		return 1;
+#else
+	if (mkdir(_path, 0755) == 0 || errno == EEXIST)
+		return 1;
+#endif
+	return 0;
+}
+
+int _gpak_make_directories(const char* _path)
+{
+	char* path = strdup(_path);
+	size_t length = strlen(path);
+	int result = 1;
+
+	// Every parent is created in turn, skipping the root of absolute paths
+	for (size_t idx = 1ull; idx < length && result; ++idx)
+	{
+		if (path[idx] != '/' && path[idx] != '\\')
+			continue;
+		if (path[idx - 1ull] == '/' || path[idx - 1ull] == '\\' || path[idx - 1ull] == ':')
+			continue;
+
+		char separator = path[idx];
+		path[idx] = '\0';
+		result = _gpak_make_directory(path);
+		path[idx] = separator;
+	}
+
+	if (result && length > 0ull)
+		result = _gpak_make_directory(path);
+
+	free(path);
+	return result;
+}
+
+FILE* _gpak_create_output(const char* _path, uint64_t _size)
+{
+	FILE* file = fopen(_path, "wb");
+	if (!file)
+		return NULL;
+
+#if defined(__linux__)
+	// Reserving the whole file keeps large outputs from being extended write after write
+	if (_size > 0ull)
+		posix_fallocate(fileno(file), 0, (off_t)_size);
+#else
+	(void)_size;
+#endif
+
+	return file;
+}
+
+int _gpak_truncate(FILE* _file, uint64_t _size)
+{
+	if (fflush(_file) != 0)
+		return 0;
+
+#ifdef _WIN32
+	return _chsize_s(_fileno(_file), (__int64)_size) == 0;
+#else
+	return ftruncate(fileno(_file), (off_t)_size) == 0;
+#endif
 }
\ No newline at end of file
@@ -19,6 +19,33 @@ extern "C" {
 	 */
 	GPAK_API int _gpak_make_error(gpak_t* _pak, int _error_code);
 
+	/**
+	 * @brief Returns the last error code set on the calling thread.
+	 *
+	 * This function returns the error code of the last call to _gpak_make_error made by the calling thread, whatever the archive.
+	 *
+	 * @return The last error code of the calling thread, or GPAK_ERROR_OK if none was set.
+	 */
+	GPAK_API int _gpak_last_error();
+
+	/**
+	 * @brief Sets the path errors of the calling thread are reported against.
+	 *
+	 * This function sets the path passed to the error handler for errors made by the calling thread. Readers use it instead of the shared current file of the archive.
+	 *
+	 * @param _path The internal path of the file being read, or NULL to report against the current file of the archive.
+	 */
+	GPAK_API void _gpak_set_thread_path(const char* _path);
+
+	/**
+	 * @brief Returns the path errors of the calling thread are reported against.
+	 *
+	 * This function returns the path last set with _gpak_set_thread_path by the calling thread, so it can be restored after reporting against another one.
+	 *
+	 * @return The internal path set for the calling thread, or NULL if errors are reported against the current file of the archive.
+	 */
+	GPAK_API const char* _gpak_get_thread_path();
+
 	/**
 	 * @brief Notifies the progress handler for the specified G-PAK archive.
 	 *
@@ -57,6 +84,127 @@ extern "C" {
 	 */
 	GPAK_API size_t _freadb(void* _data, size_t _elemSize, size_t _elemCount, FILE* _file);
 
+	/**
+	 * @brief Returns the current position of a file as a 64-bit value.
+	 *
+	 * This function is an ftell replacement that is not limited to 2 GiB on platforms where long is 32 bits wide.
+	 *
+	 * @param _file A pointer to the FILE.
+	 * @return The current position in the file or -1 if an error occurred.
+	 */
+	GPAK_API int64_t _gpak_ftell64(FILE* _file);
+
+	/**
+	 * @brief Sets the position of a file using a 64-bit offset.
+	 *
+	 * This function is an fseek replacement that is not limited to 2 GiB on platforms where long is 32 bits wide.
+	 *
+	 * @param _file A pointer to the FILE.
+	 * @param _offset The offset in bytes from the _origin.
+	 * @param _origin The reference position in the file (SEEK_SET, SEEK_CUR, or SEEK_END).
+	 * @return Zero if the operation is successful, or a non-zero value if an error occurred.
+	 */
+	GPAK_API int _gpak_fseek64(FILE* _file, int64_t _offset, int _origin);
+
+	/**
+	 * @brief Reads binary data at a given offset of a file.
+	 *
+	 * This function reads with pread or an overlapped ReadFile, without using or moving the position of the FILE, so several threads can read the same file at once.
+	 *
+	 * @param _file A pointer to the FILE to read from.
+	 * @param _offset The offset in bytes from the start of the file.
+	 * @param _dst A pointer to the buffer to store the read data.
+	 * @param _size The number of bytes to read.
+	 * @return The number of bytes successfully read.
+	 */
+	GPAK_API size_t _gpak_pread(FILE* _file, uint64_t _offset, void* _dst, size_t _size);
+
+	/**
+	 * @brief Computes the CRC-32 checksum of a buffer.
+	 *
+	 * This function hashes the buffer in slices that fit the 32-bit length taken by zlib, so entries of 4 GiB and more are checked as a whole.
+	 *
+	 * @param _data A pointer to the bytes to hash.
+	 * @param _size The number of bytes to hash.
+	 * @return The CRC-32 checksum of the buffer.
+	 */
+	GPAK_API uint32_t _gpak_crc32_bytes(const void* _data, uint64_t _size);
+
+	/**
+	 * @brief Hashes an internal path for the path index.
+	 *
+	 * This function computes the 64-bit FNV-1a hash of a null-terminated path. It is used both when the path index is written and when it is queried.
+	 *
+	 * @param _path The null-terminated internal path.
+	 * @return The 64-bit hash of the path.
+	 */
+	GPAK_API uint64_t _gpak_hash_path(const char* _path);
+
+	/**
+	 * @brief Maps a file into memory for reading.
+	 *
+	 * This function maps the whole file read-only, with mmap or a Win32 file mapping. The mapping has to be released with _gpak_unmap_file.
+	 *
+	 * @param _path The path of the file.
+	 * @param _size A pointer that receives the size of the file in bytes.
+	 * @param _handle A pointer that receives the platform handle of the mapping, or NULL if the platform needs none.
+	 * @return A pointer to the mapped file, or NULL if the file cannot be opened, is empty or cannot be mapped.
+	 */
+	GPAK_API const char* _gpak_map_file(const char* _path, uint64_t* _size, void** _handle);
+
+	/**
+	 * @brief Releases a mapping created with _gpak_map_file.
+	 *
+	 * @param _data The pointer returned by _gpak_map_file, or NULL.
+	 * @param _size The size of the mapped file in bytes.
+	 * @param _handle The platform handle returned by _gpak_map_file.
+	 */
+	GPAK_API void _gpak_unmap_file(const char* _data, uint64_t _size, void* _handle);
+
+	/**
+	 * @brief Hashes a block of memory.
+	 *
+	 * This function continues the 64-bit FNV-1a hash _hash over _size bytes, so that several blocks can be hashed as one.
+	 *
+	 * @param _hash The hash of the preceding blocks, or 14695981039346656037 for the first one.
+	 * @param _data A pointer to the data.
+	 * @param _size The size of the data in bytes.
+	 * @return The 64-bit hash of the preceding blocks and the data.
+	 */
+	GPAK_API uint64_t _gpak_hash_bytes(uint64_t _hash, const void* _data, size_t _size);
+
+	/**
+	 * @brief Creates a directory and every missing parent of it.
+	 *
+	 * This function behaves like mkdir -p, directories that already exist are not an error, so several threads can create overlapping paths at once.
+	 *
+	 * @param _path The path of the directory.
+	 * @return 1 if the directory exists once the function returns, 0 otherwise.
+	 */
+	GPAK_API int _gpak_make_directories(const char* _path);
+
+	/**
+	 * @brief Creates a file to be written with a known final size.
+	 *
+	 * This function opens the file for binary writing and, where the platform supports it, reserves its final size up front so that large outputs are laid out in one piece.
+	 *
+	 * @param _path The path of the file.
+	 * @param _size The final size of the file in bytes.
+	 * @return A pointer to the opened FILE, or NULL if the file cannot be created.
+	 */
+	GPAK_API FILE* _gpak_create_output(const char* _path, uint64_t _size);
+
+	/**
+	 * @brief Cuts a file down to the specified size.
+	 *
+	 * This function flushes the FILE and truncates the file behind it, so bytes left past the end of an updated archive are dropped.
+	 *
+	 * @param _file A pointer to the FILE, opened for writing.
+	 * @param _size The new size of the file in bytes.
+	 * @return 1 on success, 0 otherwise.
+	 */
+	GPAK_API int _gpak_truncate(FILE* _file, uint64_t _size);
+
 #ifdef __cplusplus
 }
 #endif
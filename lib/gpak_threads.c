@@ -0,0 +1,326 @@
+#include "gpak_threads.h"
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <time.h>
+#endif
+
+struct gpak_task
+{
+	gpak_task_func_t func_;
+	void* arg_;
+	struct gpak_task* next_;
+};
+
+struct gpak_thread_pool
+{
+	gpak_mutex_t mutex_;
+	gpak_cond_t cond_;
+	struct gpak_task* head_;
+	struct gpak_task* tail_;
+	int stop_;
+	gpak_thread_t* threads_;
+	uint32_t thread_count_;
+};
+
+struct gpak_parallel_loop
+{
+	gpak_mutex_t mutex_;
+	gpak_cond_t cond_;
+	gpak_parallel_func_t func_;
+	void* arg_;
+	size_t count_;
+	size_t next_;
+	uint32_t active_helpers_;
+};
+
+uint32_t _gpak_hardware_concurrency()
+{
+	long num_threads;
+
+#ifdef _WIN32
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+	num_threads = sysinfo.dwNumberOfProcessors;
+#else
+	num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	return num_threads > 0 ? (uint32_t)num_threads : 1u;
+}
+
+uint64_t _gpak_time_ms()
+{
+#ifdef _WIN32
+	return (uint64_t)GetTickCount64();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+#endif
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK _gpak_once_entry(PINIT_ONCE _once, PVOID _param, PVOID* _context)
+{
+	(void)_once;
+	(void)_context;
+	((void (*)(void))_param)();
+	return TRUE;
+}
+
+void _gpak_call_once(gpak_once_t* _once, void (*_func)(void)) { InitOnceExecuteOnce(_once, &_gpak_once_entry, (PVOID)_func, NULL); }
+
+void _gpak_mutex_init(gpak_mutex_t* _mutex) { InitializeCriticalSection(_mutex); }
+void _gpak_mutex_destroy(gpak_mutex_t* _mutex) { DeleteCriticalSection(_mutex); }
+void _gpak_mutex_lock(gpak_mutex_t* _mutex) { EnterCriticalSection(_mutex); }
+void _gpak_mutex_unlock(gpak_mutex_t* _mutex) { LeaveCriticalSection(_mutex); }
+
+void _gpak_cond_init(gpak_cond_t* _cond) { InitializeConditionVariable(_cond); }
+void _gpak_cond_destroy(gpak_cond_t* _cond) { (void)_cond; }
+void _gpak_cond_wait(gpak_cond_t* _cond, gpak_mutex_t* _mutex) { SleepConditionVariableCS(_cond, _mutex, INFINITE); }
+void _gpak_cond_signal(gpak_cond_t* _cond) { WakeConditionVariable(_cond); }
+void _gpak_cond_broadcast(gpak_cond_t* _cond) { WakeAllConditionVariable(_cond); }
+
+struct gpak_thread_start
+{
+	gpak_task_func_t func_;
+	void* arg_;
+};
+
+static DWORD WINAPI _gpak_thread_entry(LPVOID _param)
+{
+	struct gpak_thread_start start = *(struct gpak_thread_start*)_param;
+	free(_param);
+	start.func_(start.arg_);
+	return 0;
+}
+
+int _gpak_thread_create(gpak_thread_t* _thread, gpak_task_func_t _func, void* _arg)
+{
+	struct gpak_thread_start* start = (struct gpak_thread_start*)malloc(sizeof(struct gpak_thread_start));
+	start->func_ = _func;
+	start->arg_ = _arg;
+
+	*_thread = CreateThread(NULL, 0, &_gpak_thread_entry, start, 0, NULL);
+	if (*_thread == NULL)
+	{
+		free(start);
+		return -1;
+	}
+
+	return 0;
+}
+
+void _gpak_thread_join(gpak_thread_t _thread)
+{
+	WaitForSingleObject(_thread, INFINITE);
+	CloseHandle(_thread);
+}
+#else
+void _gpak_call_once(gpak_once_t* _once, void (*_func)(void)) { pthread_once(_once, _func); }
+
+void _gpak_mutex_init(gpak_mutex_t* _mutex) { pthread_mutex_init(_mutex, NULL); }
+void _gpak_mutex_destroy(gpak_mutex_t* _mutex) { pthread_mutex_destroy(_mutex); }
+void _gpak_mutex_lock(gpak_mutex_t* _mutex) { pthread_mutex_lock(_mutex); }
+void _gpak_mutex_unlock(gpak_mutex_t* _mutex) { pthread_mutex_unlock(_mutex); }
+
+void _gpak_cond_init(gpak_cond_t* _cond) { pthread_cond_init(_cond, NULL); }
+void _gpak_cond_destroy(gpak_cond_t* _cond) { pthread_cond_destroy(_cond); }
+void _gpak_cond_wait(gpak_cond_t* _cond, gpak_mutex_t* _mutex) { pthread_cond_wait(_cond, _mutex); }
+void _gpak_cond_signal(gpak_cond_t* _cond) { pthread_cond_signal(_cond); }
+void _gpak_cond_broadcast(gpak_cond_t* _cond) { pthread_cond_broadcast(_cond); }
+
+struct gpak_thread_start
+{
+	gpak_task_func_t func_;
+	void* arg_;
+};
+
+static void* _gpak_thread_entry(void* _param)
+{
+	struct gpak_thread_start start = *(struct gpak_thread_start*)_param;
+	free(_param);
+	start.func_(start.arg_);
+	return NULL;
+}
+
+int _gpak_thread_create(gpak_thread_t* _thread, gpak_task_func_t _func, void* _arg)
+{
+	struct gpak_thread_start* start = (struct gpak_thread_start*)malloc(sizeof(struct gpak_thread_start));
+	start->func_ = _func;
+	start->arg_ = _arg;
+
+	if (pthread_create(_thread, NULL, &_gpak_thread_entry, start) != 0)
+	{
+		free(start);
+		return -1;
+	}
+
+	return 0;
+}
+
+void _gpak_thread_join(gpak_thread_t _thread)
+{
+	pthread_join(_thread, NULL);
+}
+#endif
+
+static void _gpak_thread_pool_worker(void* _arg)
+{
+	gpak_thread_pool_t* pool = (gpak_thread_pool_t*)_arg;
+
+	_gpak_mutex_lock(&pool->mutex_);
+	while (1)
+	{
+		while (!pool->head_ && !pool->stop_)
+			_gpak_cond_wait(&pool->cond_, &pool->mutex_);
+
+		// Queued tasks are drained before the worker exits
+		if (!pool->head_)
+			break;
+
+		struct gpak_task* task = pool->head_;
+		pool->head_ = task->next_;
+		if (!pool->head_)
+			pool->tail_ = NULL;
+
+		_gpak_mutex_unlock(&pool->mutex_);
+		task->func_(task->arg_);
+		free(task);
+		_gpak_mutex_lock(&pool->mutex_);
+	}
+	_gpak_mutex_unlock(&pool->mutex_);
+}
+
+gpak_thread_pool_t* _gpak_thread_pool_create(uint32_t _thread_count)
+{
+	if (_thread_count == 0u)
+		_thread_count = _gpak_hardware_concurrency();
+
+	gpak_thread_pool_t* pool = (gpak_thread_pool_t*)calloc(1, sizeof(gpak_thread_pool_t));
+	_gpak_mutex_init(&pool->mutex_);
+	_gpak_cond_init(&pool->cond_);
+
+	pool->threads_ = (gpak_thread_t*)malloc(sizeof(gpak_thread_t) * _thread_count);
+	for (uint32_t idx = 0u; idx < _thread_count; ++idx)
+	{
+		if (_gpak_thread_create(&pool->threads_[pool->thread_count_], &_gpak_thread_pool_worker, pool) == 0)
+			++pool->thread_count_;
+	}
+
+	if (pool->thread_count_ == 0u)
+	{
+		_gpak_thread_pool_free(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+void _gpak_thread_pool_free(gpak_thread_pool_t* _pool)
+{
+	if (!_pool)
+		return;
+
+	_gpak_mutex_lock(&_pool->mutex_);
+	_pool->stop_ = 1;
+	_gpak_cond_broadcast(&_pool->cond_);
+	_gpak_mutex_unlock(&_pool->mutex_);
+
+	for (uint32_t idx = 0u; idx < _pool->thread_count_; ++idx)
+		_gpak_thread_join(_pool->threads_[idx]);
+
+	_gpak_cond_destroy(&_pool->cond_);
+	_gpak_mutex_destroy(&_pool->mutex_);
+	free(_pool->threads_);
+	free(_pool);
+}
+
+uint32_t _gpak_thread_pool_size(gpak_thread_pool_t* _pool)
+{
+	return _pool ? _pool->thread_count_ : 0u;
+}
+
+void _gpak_thread_pool_submit(gpak_thread_pool_t* _pool, gpak_task_func_t _func, void* _arg)
+{
+	struct gpak_task* task = (struct gpak_task*)malloc(sizeof(struct gpak_task));
+	task->func_ = _func;
+	task->arg_ = _arg;
+	task->next_ = NULL;
+
+	_gpak_mutex_lock(&_pool->mutex_);
+	if (_pool->tail_)
+		_pool->tail_->next_ = task;
+	else
+		_pool->head_ = task;
+	_pool->tail_ = task;
+	_gpak_cond_signal(&_pool->cond_);
+	_gpak_mutex_unlock(&_pool->mutex_);
+}
+
+static void _gpak_parallel_loop_run(struct gpak_parallel_loop* _loop)
+{
+	while (1)
+	{
+		_gpak_mutex_lock(&_loop->mutex_);
+		size_t index = _loop->next_++;
+		_gpak_mutex_unlock(&_loop->mutex_);
+
+		if (index >= _loop->count_)
+			break;
+
+		_loop->func_(_loop->arg_, index);
+	}
+}
+
+static void _gpak_parallel_loop_helper(void* _arg)
+{
+	struct gpak_parallel_loop* loop = (struct gpak_parallel_loop*)_arg;
+
+	_gpak_parallel_loop_run(loop);
+
+	_gpak_mutex_lock(&loop->mutex_);
+	if (--loop->active_helpers_ == 0u)
+		_gpak_cond_signal(&loop->cond_);
+	_gpak_mutex_unlock(&loop->mutex_);
+}
+
+void _gpak_thread_pool_parallel_for(gpak_thread_pool_t* _pool, size_t _count, gpak_parallel_func_t _func, void* _arg)
+{
+	if (!_pool || _count < 2ull)
+	{
+		for (size_t idx = 0ull; idx < _count; ++idx)
+			_func(_arg, idx);
+		return;
+	}
+
+	struct gpak_parallel_loop loop;
+	_gpak_mutex_init(&loop.mutex_);
+	_gpak_cond_init(&loop.cond_);
+	loop.func_ = _func;
+	loop.arg_ = _arg;
+	loop.count_ = _count;
+	loop.next_ = 0ull;
+
+	// The calling thread runs one share of the loop itself
+	uint32_t helpers = _pool->thread_count_;
+	if (helpers > _count - 1ull)
+		helpers = (uint32_t)(_count - 1ull);
+	loop.active_helpers_ = helpers;
+
+	for (uint32_t idx = 0u; idx < helpers; ++idx)
+		_gpak_thread_pool_submit(_pool, &_gpak_parallel_loop_helper, &loop);
+
+	_gpak_parallel_loop_run(&loop);
+
+	_gpak_mutex_lock(&loop.mutex_);
+	while (loop.active_helpers_ != 0u)
+		_gpak_cond_wait(&loop.cond_, &loop.mutex_);
+	_gpak_mutex_unlock(&loop.mutex_);
+
+	_gpak_cond_destroy(&loop.cond_);
+	_gpak_mutex_destroy(&loop.mutex_);
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+/**
+ * @file gpak_threads.h
+ * @author AdamFull
+ * @date 17.10.2026
+ * @brief The gpak_threads.h header file contains the portable threading
+ *        primitives used internally by the Gpak library.
+ *
+ * This header file defines thin wrappers around the native mutex, condition
+ * variable and thread APIs (Win32 or POSIX threads) and a small thread pool
+ * built on top of them. The pool is used to decode and encode independent
+ * pieces of archive data on several cores.
+ */
+
+#ifndef GPAK_THREADS_H
+#define GPAK_THREADS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	#include "gpak_export.h"
+
+	#include <stddef.h>
+	#include <stdint.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+
+	typedef CRITICAL_SECTION gpak_mutex_t;
+	typedef CONDITION_VARIABLE gpak_cond_t;
+	typedef HANDLE gpak_thread_t;
+	typedef INIT_ONCE gpak_once_t;
+
+	#define GPAK_ONCE_INIT INIT_ONCE_STATIC_INIT
+#else
+	#include <pthread.h>
+
+	typedef pthread_mutex_t gpak_mutex_t;
+	typedef pthread_cond_t gpak_cond_t;
+	typedef pthread_t gpak_thread_t;
+	typedef pthread_once_t gpak_once_t;
+
+	#define GPAK_ONCE_INIT PTHREAD_ONCE_INIT
+#endif
+
+#if defined(_MSC_VER)
+	#define GPAK_THREAD_LOCAL __declspec(thread)
+#else
+	#define GPAK_THREAD_LOCAL _Thread_local
+#endif
+
+	/**
+	 * @typedef gpak_task_func_t
+	 * @brief A function executed by a worker thread of the thread pool.
+	 */
+	typedef void (*gpak_task_func_t)(void*);
+
+	/**
+	 * @typedef gpak_parallel_func_t
+	 * @brief A function executed for every index of a parallel loop.
+	 */
+	typedef void (*gpak_parallel_func_t)(void*, size_t);
+
+	/**
+	 * @brief Typedef for the opaque gpak_thread_pool structure.
+	 */
+	typedef struct gpak_thread_pool gpak_thread_pool_t;
+
+	/**
+	 * @brief Returns the number of hardware threads available to the process.
+	 *
+	 * @return The number of logical processors, at least 1.
+	 */
+	GPAK_API uint32_t _gpak_hardware_concurrency();
+
+	/**
+	 * @brief Returns the time elapsed since an arbitrary point in the past, unaffected by changes of the system clock.
+	 *
+	 * @return The monotonic time in milliseconds.
+	 */
+	GPAK_API uint64_t _gpak_time_ms();
+
+	/**
+	 * @brief Calls a function exactly once per process, even when several threads get here at the same time.
+	 *
+	 * @param _once A pointer to a gpak_once_t initialized with GPAK_ONCE_INIT.
+	 * @param _func The function to call.
+	 */
+	GPAK_API void _gpak_call_once(gpak_once_t* _once, void (*_func)(void));
+
+	/**
+	 * @brief Initializes a mutex.
+	 *
+	 * @param _mutex A pointer to the gpak_mutex_t to initialize.
+	 */
+	GPAK_API void _gpak_mutex_init(gpak_mutex_t* _mutex);
+
+	/**
+	 * @brief Destroys a mutex previously initialized with _gpak_mutex_init.
+	 *
+	 * @param _mutex A pointer to the gpak_mutex_t to destroy.
+	 */
+	GPAK_API void _gpak_mutex_destroy(gpak_mutex_t* _mutex);
+
+	/**
+	 * @brief Locks a mutex.
+	 *
+	 * @param _mutex A pointer to the gpak_mutex_t to lock.
+	 */
+	GPAK_API void _gpak_mutex_lock(gpak_mutex_t* _mutex);
+
+	/**
+	 * @brief Unlocks a mutex.
+	 *
+	 * @param _mutex A pointer to the gpak_mutex_t to unlock.
+	 */
+	GPAK_API void _gpak_mutex_unlock(gpak_mutex_t* _mutex);
+
+	/**
+	 * @brief Initializes a condition variable.
+	 *
+	 * @param _cond A pointer to the gpak_cond_t to initialize.
+	 */
+	GPAK_API void _gpak_cond_init(gpak_cond_t* _cond);
+
+	/**
+	 * @brief Destroys a condition variable previously initialized with _gpak_cond_init.
+	 *
+	 * @param _cond A pointer to the gpak_cond_t to destroy.
+	 */
+	GPAK_API void _gpak_cond_destroy(gpak_cond_t* _cond);
+
+	/**
+	 * @brief Atomically unlocks the mutex and waits for the condition variable to be signaled.
+	 *
+	 * @param _cond A pointer to the gpak_cond_t to wait for.
+	 * @param _mutex A pointer to the locked gpak_mutex_t protecting the condition.
+	 */
+	GPAK_API void _gpak_cond_wait(gpak_cond_t* _cond, gpak_mutex_t* _mutex);
+
+	/**
+	 * @brief Wakes one thread waiting for the condition variable.
+	 *
+	 * @param _cond A pointer to the gpak_cond_t to signal.
+	 */
+	GPAK_API void _gpak_cond_signal(gpak_cond_t* _cond);
+
+	/**
+	 * @brief Wakes all threads waiting for the condition variable.
+	 *
+	 * @param _cond A pointer to the gpak_cond_t to signal.
+	 */
+	GPAK_API void _gpak_cond_broadcast(gpak_cond_t* _cond);
+
+	/**
+	 * @brief Starts a new thread.
+	 *
+	 * @param _thread A pointer to the gpak_thread_t receiving the thread handle.
+	 * @param _func The function to run on the new thread.
+	 * @param _arg The argument passed to _func.
+	 * @return Zero if the thread was started, or a non-zero value if an error occurred.
+	 */
+	GPAK_API int _gpak_thread_create(gpak_thread_t* _thread, gpak_task_func_t _func, void* _arg);
+
+	/**
+	 * @brief Waits for a thread to finish and releases its handle.
+	 *
+	 * @param _thread The gpak_thread_t to join.
+	 */
+	GPAK_API void _gpak_thread_join(gpak_thread_t _thread);
+
+	/**
+	 * @brief Creates a thread pool.
+	 *
+	 * @param _thread_count The number of worker threads, or 0 to use one per hardware thread.
+	 * @return A pointer to the created gpak_thread_pool_t or NULL if an error occurred.
+	 */
+	GPAK_API gpak_thread_pool_t* _gpak_thread_pool_create(uint32_t _thread_count);
+
+	/**
+	 * @brief Destroys a thread pool.
+	 *
+	 * This function waits for the already queued tasks to complete and joins all worker threads.
+	 *
+	 * @param _pool A pointer to the gpak_thread_pool_t to destroy.
+	 */
+	GPAK_API void _gpak_thread_pool_free(gpak_thread_pool_t* _pool);
+
+	/**
+	 * @brief Returns the number of worker threads of a thread pool.
+	 *
+	 * @param _pool A pointer to the gpak_thread_pool_t.
+	 * @return The number of worker threads.
+	 */
+	GPAK_API uint32_t _gpak_thread_pool_size(gpak_thread_pool_t* _pool);
+
+	/**
+	 * @brief Queues a task for execution on a worker thread.
+	 *
+	 * @param _pool A pointer to the gpak_thread_pool_t.
+	 * @param _func The function to execute.
+	 * @param _arg The argument passed to _func.
+	 */
+	GPAK_API void _gpak_thread_pool_submit(gpak_thread_pool_t* _pool, gpak_task_func_t _func, void* _arg);
+
+	/**
+	 * @brief Runs a function for every index in [0, _count) on the thread pool and waits for completion.
+	 *
+	 * The calling thread takes part in the loop, so the call makes progress even when all workers are busy.
+	 *
+	 * @param _pool A pointer to the gpak_thread_pool_t, or NULL to run the loop on the calling thread.
+	 * @param _count The number of indices.
+	 * @param _func The function called with _arg and each index.
+	 * @param _arg The argument passed to _func.
+	 */
+	GPAK_API void _gpak_thread_pool_parallel_for(gpak_thread_pool_t* _pool, size_t _count, gpak_parallel_func_t _func, void* _arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPAK_THREADS_H
\ No newline at end of file
@@ -0,0 +1,242 @@
+#if defined(__linux__)
+#define _DEFAULT_SOURCE
+#endif
+
+#include "gpak_uring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+struct gpak_uring
+{
+	int descriptor_;
+	void* sq_ring_;
+	size_t sq_ring_size_;
+	void* cq_ring_;
+	size_t cq_ring_size_;
+	struct io_uring_sqe* sqes_;
+	size_t sqes_size_;
+	unsigned* sq_head_;
+	unsigned* sq_tail_;
+	unsigned* sq_mask_;
+	unsigned* sq_array_;
+	unsigned sq_entries_;
+	unsigned* cq_head_;
+	unsigned* cq_tail_;
+	unsigned* cq_mask_;
+	struct io_uring_cqe* cqes_;
+	uint32_t queued_;
+	uint32_t in_flight_;
+};
+
+// The rings are shared with the kernel, heads and tails are published with acquire and release ordering
+#define _URING_LOAD(_ptr) __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+#define _URING_STORE(_ptr, _value) __atomic_store_n((_ptr), (_value), __ATOMIC_RELEASE)
+
+int _gpak_uring_enter(gpak_uring_t* _ring, uint32_t _to_submit, uint32_t _min_complete, uint32_t _flags)
+{
+	int result = 0;
+	do
+		result = (int)syscall(__NR_io_uring_enter, _ring->descriptor_, _to_submit, _min_complete, _flags, NULL, 0);
+	while (result < 0 && errno == EINTR);
+
+	return result;
+}
+
+gpak_uring_t* _gpak_uring_create(uint32_t _entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	int descriptor = (int)syscall(__NR_io_uring_setup, _entries, &params);
+	if (descriptor < 0)
+		return NULL;
+
+	gpak_uring_t* ring = (gpak_uring_t*)calloc(1, sizeof(gpak_uring_t));
+	ring->descriptor_ = descriptor;
+	ring->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	// Recent kernels map both rings at once
+	int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single_mmap && ring->cq_ring_size_ > ring->sq_ring_size_)
+		ring->sq_ring_size_ = ring->cq_ring_size_;
+
+	ring->sq_ring_ = mmap(NULL, ring->sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+	ring->cq_ring_ = single_mmap ? ring->sq_ring_ : mmap(NULL, ring->cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_CQ_RING);
+	ring->sqes_ = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES);
+	if (ring->sq_ring_ == MAP_FAILED || ring->cq_ring_ == MAP_FAILED || (void*)ring->sqes_ == MAP_FAILED)
+	{
+		_gpak_uring_free(ring);
+		return NULL;
+	}
+
+	char* sq_ring = (char*)ring->sq_ring_;
+	ring->sq_head_ = (unsigned*)(sq_ring + params.sq_off.head);
+	ring->sq_tail_ = (unsigned*)(sq_ring + params.sq_off.tail);
+	ring->sq_mask_ = (unsigned*)(sq_ring + params.sq_off.ring_mask);
+	ring->sq_array_ = (unsigned*)(sq_ring + params.sq_off.array);
+	ring->sq_entries_ = params.sq_entries;
+
+	char* cq_ring = (char*)ring->cq_ring_;
+	ring->cq_head_ = (unsigned*)(cq_ring + params.cq_off.head);
+	ring->cq_tail_ = (unsigned*)(cq_ring + params.cq_off.tail);
+	ring->cq_mask_ = (unsigned*)(cq_ring + params.cq_off.ring_mask);
+	ring->cqes_ = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+
+	return ring;
+}
+
+void _gpak_uring_free(gpak_uring_t* _ring)
+{
+	if (!_ring)
+		return;
+
+	if (_ring->sqes_ && (void*)_ring->sqes_ != MAP_FAILED)
+		munmap(_ring->sqes_, _ring->sqes_size_);
+	if (_ring->cq_ring_ && _ring->cq_ring_ != MAP_FAILED && _ring->cq_ring_ != _ring->sq_ring_)
+		munmap(_ring->cq_ring_, _ring->cq_ring_size_);
+	if (_ring->sq_ring_ && _ring->sq_ring_ != MAP_FAILED)
+		munmap(_ring->sq_ring_, _ring->sq_ring_size_);
+
+	close(_ring->descriptor_);
+	free(_ring);
+}
+
+int _gpak_uring_queue_read(gpak_uring_t* _ring, int _descriptor, uint64_t _offset, void* _dst, uint32_t _size, uint64_t _user_data)
+{
+	// Completions are reaped as they come, reads are only queued while their completions are sure to fit
+	if (_ring->queued_ + _ring->in_flight_ >= _ring->sq_entries_)
+		return 0;
+
+	unsigned tail = *_ring->sq_tail_;
+	if (tail - _URING_LOAD(_ring->sq_head_) >= _ring->sq_entries_)
+		return 0;
+
+	unsigned index = tail & *_ring->sq_mask_;
+	struct io_uring_sqe* sqe = &_ring->sqes_[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = _descriptor;
+	sqe->off = _offset;
+	sqe->addr = (uint64_t)(uintptr_t)_dst;
+	sqe->len = _size;
+	sqe->user_data = _user_data;
+
+	_ring->sq_array_[index] = index;
+	_URING_STORE(_ring->sq_tail_, tail + 1u);
+	++_ring->queued_;
+
+	return 1;
+}
+
+int _gpak_uring_submit(gpak_uring_t* _ring)
+{
+	while (_ring->queued_ > 0u)
+	{
+		int submitted = _gpak_uring_enter(_ring, _ring->queued_, 0u, 0u);
+		if (submitted <= 0)
+			return 0;
+
+		_ring->queued_ -= (uint32_t)submitted;
+		_ring->in_flight_ += (uint32_t)submitted;
+	}
+
+	return 1;
+}
+
+int _gpak_uring_drop(gpak_uring_t* _ring, uint64_t* _user_data)
+{
+	if (_ring->queued_ == 0u)
+		return 0;
+
+	// The kernel consumes entries in order, the ones it has not taken yet are the last before the tail
+	unsigned tail = *_ring->sq_tail_ - 1u;
+	*_user_data = _ring->sqes_[_ring->sq_array_[tail & *_ring->sq_mask_]].user_data;
+
+	_URING_STORE(_ring->sq_tail_, tail);
+	--_ring->queued_;
+
+	return 1;
+}
+
+int _gpak_uring_reap(gpak_uring_t* _ring, uint64_t* _user_data, int32_t* _result, int _wait)
+{
+	unsigned head = *_ring->cq_head_;
+	while (head == _URING_LOAD(_ring->cq_tail_))
+	{
+		if (!_wait || _ring->in_flight_ == 0u || _gpak_uring_enter(_ring, 0u, 1u, IORING_ENTER_GETEVENTS) < 0)
+			return 0;
+	}
+
+	const struct io_uring_cqe* cqe = &_ring->cqes_[head & *_ring->cq_mask_];
+	*_user_data = cqe->user_data;
+	*_result = cqe->res;
+
+	_URING_STORE(_ring->cq_head_, head + 1u);
+	--_ring->in_flight_;
+
+	return 1;
+}
+
+uint32_t _gpak_uring_in_flight(gpak_uring_t* _ring)
+{
+	return _ring->in_flight_ + _ring->queued_;
+}
+
+#else
+
+// Without io_uring the queue is never created and the readers fall back to worker threads
+gpak_uring_t* _gpak_uring_create(uint32_t _entries)
+{
+	(void)_entries;
+	return NULL;
+}
+
+void _gpak_uring_free(gpak_uring_t* _ring)
+{
+	(void)_ring;
+}
+
+int _gpak_uring_queue_read(gpak_uring_t* _ring, int _descriptor, uint64_t _offset, void* _dst, uint32_t _size, uint64_t _user_data)
+{
+	(void)_ring; (void)_descriptor; (void)_offset; (void)_dst; (void)_size; (void)_user_data;
+	return 0;
+}
+
+int _gpak_uring_submit(gpak_uring_t* _ring)
+{
+	(void)_ring;
+	return 0;
+}
+
+int _gpak_uring_drop(gpak_uring_t* _ring, uint64_t* _user_data)
+{
+	(void)_ring; (void)_user_data;
+	return 0;
+}
+
+int _gpak_uring_reap(gpak_uring_t* _ring, uint64_t* _user_data, int32_t* _result, int _wait)
+{
+	(void)_ring; (void)_user_data; (void)_result; (void)_wait;
+	return 0;
+}
+
+uint32_t _gpak_uring_in_flight(gpak_uring_t* _ring)
+{
+	(void)_ring;
+	return 0u;
+}
+
+#endif
\ No newline at end of file
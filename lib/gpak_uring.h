@@ -0,0 +1,104 @@
+/**
+ * @file gpak_uring.h
+ * @author AdamFull
+ * @date 17.10.2026
+ * @brief The gpak_uring.h header file contains the asynchronous read queue
+ *        used internally by the Gpak library.
+ *
+ * This header file defines a minimal io_uring submission and completion queue
+ * driven through the raw system calls, so no extra library is needed. Reads are
+ * queued with a user value, submitted in batches and reaped as the kernel
+ * completes them. On platforms or kernels without io_uring the queue cannot be
+ * created and callers fall back to positional reads on worker threads.
+ */
+
+#ifndef GPAK_URING_H
+#define GPAK_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	#include "gpak_export.h"
+
+	#include <stddef.h>
+	#include <stdint.h>
+
+	/**
+	 * @brief Typedef for the opaque gpak_uring structure.
+	 */
+	typedef struct gpak_uring gpak_uring_t;
+
+	/**
+	 * @brief Creates an io_uring read queue.
+	 *
+	 * @param _entries The number of reads that may be queued at once, rounded up to a power of two by the kernel.
+	 * @return A pointer to the new gpak_uring_t, or NULL if io_uring is not available.
+	 */
+	GPAK_API gpak_uring_t* _gpak_uring_create(uint32_t _entries);
+
+	/**
+	 * @brief Destroys an io_uring read queue, reads still in flight are abandoned.
+	 *
+	 * @param _ring A pointer to the gpak_uring_t, or NULL.
+	 */
+	GPAK_API void _gpak_uring_free(gpak_uring_t* _ring);
+
+	/**
+	 * @brief Queues a positional read.
+	 *
+	 * This function only fills a submission entry, the read is handed to the kernel by _gpak_uring_submit.
+	 *
+	 * @param _ring A pointer to the gpak_uring_t.
+	 * @param _descriptor The file descriptor to read from.
+	 * @param _offset The offset in the file to read at.
+	 * @param _dst The buffer receiving the bytes.
+	 * @param _size The number of bytes to read.
+	 * @param _user_data The value reported back with the completion of the read.
+	 * @return 1 if the read was queued, 0 if the queue is full.
+	 */
+	GPAK_API int _gpak_uring_queue_read(gpak_uring_t* _ring, int _descriptor, uint64_t _offset, void* _dst, uint32_t _size, uint64_t _user_data);
+
+	/**
+	 * @brief Hands every queued read to the kernel.
+	 *
+	 * @param _ring A pointer to the gpak_uring_t.
+	 * @return 1 on success, 0 if the kernel refused the reads.
+	 */
+	GPAK_API int _gpak_uring_submit(gpak_uring_t* _ring);
+
+	/**
+	 * @brief Takes back one read queued and not handed to the kernel.
+	 *
+	 * This function is used after _gpak_uring_submit failed, so the reads it could not submit are served another way.
+	 *
+	 * @param _ring A pointer to the gpak_uring_t.
+	 * @param _user_data The value the read was queued with.
+	 * @return 1 if a read was taken back, 0 if none is left.
+	 */
+	GPAK_API int _gpak_uring_drop(gpak_uring_t* _ring, uint64_t* _user_data);
+
+	/**
+	 * @brief Reaps one completed read.
+	 *
+	 * @param _ring A pointer to the gpak_uring_t.
+	 * @param _user_data The value the read was queued with.
+	 * @param _result The number of bytes read, or a negated errno value.
+	 * @param _wait Whether to block until a read completes.
+	 * @return 1 if a completion was reaped, 0 otherwise.
+	 */
+	GPAK_API int _gpak_uring_reap(gpak_uring_t* _ring, uint64_t* _user_data, int32_t* _result, int _wait);
+
+	/**
+	 * @brief Returns the number of reads handed to the kernel and not reaped yet.
+	 *
+	 * @param _ring A pointer to the gpak_uring_t.
+	 * @return The number of reads in flight.
+	 */
+	GPAK_API uint32_t _gpak_uring_in_flight(gpak_uring_t* _ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPAK_URING_H
\ No newline at end of file
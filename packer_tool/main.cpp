@@ -214,43 +214,9 @@ int main(int argc, char** argv)
 	}
 	else if (params.mode == GPAK_MODE_READ_ONLY)
 	{
-		auto pak_root = gpak_get_root(_pak);
-
 		total_file_count = _pak->header_.entry_count_;
 
-		filesystem_tree_iterator_t* iterator = filesystem_iterator_create(pak_root);
-		filesystem_tree_node_t* next_directory = pak_root;
-		do
-		{
-			filesystem_tree_file_t* next_file = NULL;
-			while ((next_file = filesystem_iterator_next_file(iterator)))
-			{
-				std::filesystem::path _first_entry(params.srDestination);
-				char* internal_filepath = filesystem_tree_file_path(next_directory, next_file);
-				_first_entry = std::filesystem::weakly_canonical(_first_entry / internal_filepath);
-
-				if (!std::filesystem::exists(_first_entry.parent_path()))
-					std::filesystem::create_directories(_first_entry.parent_path());
-
-				auto* infile = gpak_fopen(_pak, internal_filepath);
-
-				std::ofstream outfile(_first_entry, std::ios_base::out | std::ios_base::binary);
-
-				char buffer[2048];
-				size_t readed{ 0ull }; size_t whole_readed{ 0ull };
-				do {
-					readed = gpak_fread(buffer, 1ull, 2048ull, infile);
-					outfile.write(buffer, readed);
-					whole_readed += readed;
-				} while (readed != 0ull);
-
-				outfile.close();
-				gpak_fclose(infile);
-				free(internal_filepath);
-			}
-		} while ((next_directory = filesystem_iterator_next_directory(iterator)));
-
-		filesystem_iterator_free(iterator);
+		gpak_extract_all(_pak, params.srDestination.c_str());
 	}
 
 	gpak_close(_pak);
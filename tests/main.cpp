@@ -12,6 +12,13 @@ extern "C" {
 #include <filesystem>
 #include <random>
 #include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
 
 namespace fs = std::filesystem;
 
@@ -66,6 +73,37 @@ void generate_test_file_tree(const fs::path _root, size_t _num_folders, size_t _
     }
 }
 
+// Writes json and lua files, two kinds of text that share little with each other
+std::map<std::string, std::string> generate_text_files(const fs::path& _root, size_t _count, uint32_t _seed)
+{
+    std::mt19937 _generator(_seed);
+    std::map<std::string, std::string> _sources;
+    for (size_t i = 0; i < _count; ++i)
+    {
+        std::string _json = "{\n";
+        std::string _lua = "local module = {}\n\n";
+        for (size_t j = 0; j < 48; ++j)
+        {
+            auto _value = std::to_string(_generator() % 100000u);
+            _json += "    \"property_" + std::to_string(j) + "\": { \"value\": " + _value + ", \"enabled\": true },\n";
+            _lua += "function module.handler_" + std::to_string(j) + "(self, value)\n    return self.base + " + _value + "\nend\n\n";
+        }
+        _json += "}\n";
+        _lua += "return module\n";
+
+        _sources["config_" + std::to_string(i) + ".json"] = _json;
+        _sources["script_" + std::to_string(i) + ".lua"] = _lua;
+    }
+
+    for (const auto& [_name, _content] : _sources)
+    {
+        std::ofstream file(_root / _name, std::ios::binary);
+        file.write(_content.data(), _content.size());
+    }
+
+    return _sources;
+}
+
 std::size_t number_of_files_in_directory(std::filesystem::path path)
 {
     using std::filesystem::recursive_directory_iterator;
@@ -95,46 +133,45 @@ void gpak_test_add_files(gpak_t* _pak, const fs::path& _fspath)
 
 void gpak_test_extract_files(gpak_t* _pak, const fs::path& _fspath)
 {
-    auto pak_root = gpak_get_root(_pak);
-
-    filesystem_tree_iterator_t* iterator = filesystem_iterator_create(pak_root);
-    filesystem_tree_node_t* next_directory = pak_root;
-    do
-    {
-        filesystem_tree_file_t* next_file = NULL;
-        while ((next_file = filesystem_iterator_next_file(iterator)))
-        {
-            std::filesystem::path _first_entry(_fspath);
-            char* internal_filepath = filesystem_tree_file_path(next_directory, next_file);
-            _first_entry = std::filesystem::weakly_canonical(_first_entry / internal_filepath);
+    gpak_extract_all(_pak, _fspath.string().c_str());
+}
 
-            if (!std::filesystem::exists(_first_entry.parent_path()))
-                std::filesystem::create_directories(_first_entry.parent_path());
+// Text files, optional plain files and one large file packed with solid blocks and chunking, returns the packed contents by path
+std::map<std::string, std::string> gpak_test_pack_sources(const fs::path& _archive_path, const fs::path& _source_path, size_t _text_count, uint32_t _seed,
+    uint32_t _chunk_size = 64u * 1024u, size_t _plain_count = 0ull, size_t _plain_size = 0ull, size_t _plain_step = 0ull)
+{
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, _text_count, _seed);
 
-            auto* infile = gpak_fopen(_pak, internal_filepath);
-            if (!infile)
-            {
-                ++test_gpak_error_count;
-                continue;
-            }
+    for (size_t idx = 0ull; idx < _plain_count; ++idx)
+    {
+        auto _name = "plain_" + std::to_string(idx) + ".dat";
+        generate_random_file(_source_path / _name, _plain_size + idx * _plain_step);
+        std::ifstream file(_source_path / _name, std::ios::binary);
+        _sources[_name].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
 
-            std::ofstream outfile(_first_entry, std::ios_base::out | std::ios_base::binary);
+    generate_random_file(_source_path / "large.dat", 300000ull);
+    {
+        std::ifstream file(_source_path / "large.dat", std::ios::binary);
+        _sources["large.dat"].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
 
-            char buffer[2048];
-            size_t readed{ 0ull }; size_t whole_readed{ 0ull };
-            do {
-                readed = gpak_fread(buffer, 1ull, 2048ull, infile);
-                outfile.write(buffer, readed);
-                whole_readed += readed;
-            } while (readed != 0ull);
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    EXPECT_NE(_pak, nullptr);
+    if (!_pak)
+        return _sources;
 
-            outfile.close();
-            gpak_fclose(infile);
-            free(internal_filepath);
-        }
-    } while ((next_directory = filesystem_iterator_next_directory(iterator)));
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_set_chunk_size(_pak, _chunk_size);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
 
-    filesystem_iterator_free(iterator);
+    return _sources;
 }
 
 TEST(filesystem_tree_test, filesystem_tree_add_files) 
@@ -296,6 +333,1810 @@ TEST(gpak_test, gpak_decompress_zstd)
     EXPECT_TRUE(files_unpacked == test_folder_count * test_files_per_folder_count && test_gpak_error_count == 0ull);
 }
 
+TEST(gpak_test, gpak_find_file_index)
+{
+    auto _archive_path = _tests_out_entry / "zstd.gpak";
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+
+    auto pak_root = gpak_get_root(_pak);
+    size_t files_found{ 0ull };
+
+    filesystem_tree_iterator_t* iterator = filesystem_iterator_create(pak_root);
+    filesystem_tree_node_t* next_directory = pak_root;
+    do
+    {
+        filesystem_tree_file_t* next_file = NULL;
+        while ((next_file = filesystem_iterator_next_file(iterator)))
+        {
+            char* internal_filepath = filesystem_tree_file_path(next_directory, next_file);
+            if (gpak_find_file(_pak, internal_filepath) == next_file)
+                ++files_found;
+            free(internal_filepath);
+        }
+    } while ((next_directory = filesystem_iterator_next_directory(iterator)));
+
+    filesystem_iterator_free(iterator);
+
+    EXPECT_EQ(files_found, test_folder_count * test_files_per_folder_count);
+    EXPECT_EQ(gpak_find_file(_pak, "folder0/missing.dat"), nullptr);
+    EXPECT_NE(gpak_find_file(_pak, "/folder0//file0.dat"), nullptr);
+
+    gpak_close(_pak);
+}
+
+TEST(gpak_test, gpak_find_file_full_index)
+{
+    auto _archive_path = _tests_out_entry / "full_index.gpak";
+    fs::copy_file(_tests_out_entry / "zstd.gpak", _archive_path, fs::copy_options::overwrite_existing);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    uint64_t _index_offset = _pak->footer_.directory_offset_ + _pak->footer_.index_offset_;
+    gpak_close(_pak);
+
+    // Every bucket is made to point at an entry, lookups of missing paths must still stop
+    {
+        std::fstream file(_archive_path, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t _bucket_count = 0u;
+        file.seekg((std::streamoff)_index_offset);
+        file.read((char*)&_bucket_count, sizeof(_bucket_count));
+
+        pak_index_bucket_t _bucket{};
+        std::vector<pak_index_bucket_t> _buckets(_bucket_count, _bucket);
+        file.seekp((std::streamoff)(_index_offset + 2u * sizeof(uint32_t)));
+        file.write((const char*)_buckets.data(), sizeof(pak_index_bucket_t) * _buckets.size());
+    }
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    EXPECT_EQ(gpak_find_file(_pak, "folder0/missing.dat"), nullptr);
+    gpak_close(_pak);
+}
+
+TEST(gpak_test, gpak_open_payload_out_of_range)
+{
+    auto _archive_path = _tests_out_entry / "payload_range.gpak";
+    fs::copy_file(_tests_out_entry / "zstd.gpak", _archive_path, fs::copy_options::overwrite_existing);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    uint64_t _directory_offset = _pak->footer_.directory_offset_;
+    uint64_t _record_offset = 0ull;
+    for (uint32_t idx = 0u; idx < _pak->header_.entry_count_ && _record_offset == 0ull; ++idx)
+    {
+        const auto& _entry = _pak->entries_[idx];
+        if (!(_entry.flags_ & (GPAK_ENTRY_FLAG_SOLID | GPAK_ENTRY_FLAG_CHUNK_LIST)) && _entry.compressed_size_ > 0u)
+            _record_offset = _directory_offset + _pak->footer_.entries_offset_ + idx * sizeof(pak_entry_t) + offsetof(pak_entry_t, offset_);
+    }
+    gpak_close(_pak);
+    ASSERT_NE(_record_offset, 0ull);
+
+    // A payload running into the directory is rejected when the archive is opened
+    {
+        std::fstream file(_archive_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp((std::streamoff)_record_offset);
+        file.write((const char*)&_directory_offset, sizeof(_directory_offset));
+    }
+
+    for (int _mode : { GPAK_MODE_READ_ONLY, GPAK_MODE_MEMORY_MAP })
+    {
+        _pak = gpak_open(_archive_path.string().c_str(), _mode);
+        EXPECT_EQ(_pak, nullptr);
+        if (_pak)
+        {
+            gpak_close(_pak);
+        }
+    }
+}
+
+TEST(gpak_test, gpak_entry_records_none)
+{
+    auto _source_path = _tests_out_entry / "records";
+    auto _archive_path = _tests_out_entry / "records.gpak";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+
+    generate_text_files(_source_path, 3ull, 53u);
+    generate_random_file(_source_path / "large.dat", 300000ull);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_NONE);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    // The records are used in place, they must be byte for byte what was written to the archive
+    uint32_t _entry_count = _pak->header_.entry_count_;
+    ASSERT_EQ(_entry_count, (uint32_t)number_of_files_in_directory(_source_path));
+    std::vector<char> _stored(sizeof(pak_entry_t) * _entry_count);
+    {
+        std::ifstream file(_archive_path, std::ios::binary);
+        file.seekg((std::streamoff)(_pak->footer_.directory_offset_ + _pak->footer_.entries_offset_));
+        file.read(_stored.data(), _stored.size());
+        ASSERT_TRUE(file.good());
+    }
+    EXPECT_EQ(std::memcmp(_stored.data(), _pak->entries_, _stored.size()), 0);
+
+    for (uint32_t idx = 0u; idx < _entry_count; ++idx)
+    {
+        // Sizes and offsets are read back as full 64-bit little-endian fields at fixed positions
+        const char* _record = _stored.data() + idx * sizeof(pak_entry_t);
+        uint64_t _uncompressed_size = 0ull, _offset = 0ull;
+        for (int byte = 7; byte >= 0; --byte)
+        {
+            _uncompressed_size = (_uncompressed_size << 8u) | (uint8_t)_record[8 + byte];
+            _offset = (_offset << 8u) | (uint8_t)_record[16 + byte];
+        }
+
+        std::string _path = _pak->entry_paths_[idx];
+        EXPECT_EQ(_uncompressed_size, fs::file_size(_source_path / _path));
+        EXPECT_EQ(_offset, _pak->entries_[idx].offset_);
+        EXPECT_GE(_offset, sizeof(pak_header_t));
+
+        auto* _file = gpak_find_file(_pak, _path.c_str());
+        ASSERT_NE(_file, nullptr);
+        EXPECT_EQ(std::memcmp(&_file->entry_, &_pak->entries_[idx], sizeof(pak_entry_t)), 0);
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_update_zstd)
+{
+    auto _archive_path = _tests_out_entry / "zstd.gpak";
+    auto _extra_path = _tests_out_entry / "extra.dat";
+    test_gpak_error_count = 0ull;
+
+    generate_random_file(_extra_path, 4096ull);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_UPDATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_add_file(_pak, _extra_path.string().c_str(), "extra/extra.dat");
+
+    // Files added in this session are not in the index loaded from disk
+    EXPECT_NE(gpak_find_file(_pak, "extra/extra.dat"), nullptr);
+    EXPECT_NE(gpak_find_file(_pak, "folder0/file0.dat"), nullptr);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    EXPECT_EQ(_pak->header_.entry_count_, test_folder_count * test_files_per_folder_count + 1ull);
+
+    auto* _file = gpak_fopen(_pak, "extra/extra.dat");
+    ASSERT_NE(_file, nullptr);
+
+    char buffer[4096];
+    EXPECT_EQ(gpak_fread(buffer, 1ull, sizeof(buffer), _file), sizeof(buffer));
+
+    gpak_fclose(_file);
+    gpak_close(_pak);
+
+    // Updating without changes rewrites the directory in place instead of appending one
+    auto _archive_size = fs::file_size(_archive_path);
+    for (int _session = 0; _session < 2; ++_session)
+    {
+        _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_UPDATE);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_close(_pak);
+
+        EXPECT_EQ(fs::file_size(_archive_path), _archive_size);
+    }
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    EXPECT_EQ(_pak->header_.entry_count_, test_folder_count * test_files_per_folder_count + 1ull);
+
+    _file = gpak_fopen(_pak, "extra/extra.dat");
+    ASSERT_NE(_file, nullptr);
+    EXPECT_EQ(gpak_fread(buffer, 1ull, sizeof(buffer), _file), sizeof(buffer));
+
+    gpak_fclose(_file);
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_chunked_zstd)
+{
+    auto _archive_path = _tests_out_entry / "chunked.gpak";
+    auto _source_path = _tests_out_entry / "chunked.dat";
+    test_gpak_error_count = 0ull;
+
+    // Half compressible text, half random bytes, so both encoded and stored chunks are produced
+    std::string _source;
+    for (size_t i = 0; _source.size() < 512ull * 1024ull; ++i)
+        _source += "line " + std::to_string(i) + "\n";
+    {
+        std::ofstream file(_source_path, std::ios::binary);
+        file.write(_source.data(), _source.size());
+    }
+    generate_random_file(_tests_out_entry / "chunked_random.dat", 300000ull);
+    {
+        std::ifstream file(_tests_out_entry / "chunked_random.dat", std::ios::binary);
+        _source.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        std::ofstream outfile(_source_path, std::ios::binary);
+        outfile.write(_source.data(), _source.size());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_chunk_size(_pak, 64u * 1024u);
+    gpak_add_file(_pak, _source_path.string().c_str(), "chunked.dat");
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    auto* _file = gpak_fopen(_pak, "chunked.dat");
+    ASSERT_NE(_file, nullptr);
+
+    std::string _readed(_source.size(), '\0');
+    EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _source.size());
+    EXPECT_TRUE(_readed == _source);
+    EXPECT_EQ(gpak_fgetc(_file), EOF);
+    EXPECT_NE(gpak_feof(_file), 0);
+
+    // Random access in the middle of a chunk and across a chunk boundary
+    const long _offset = 3l * 64l * 1024l - 100l;
+    EXPECT_EQ(gpak_fseek(_file, _offset, SEEK_SET), 0);
+    EXPECT_EQ(gpak_ftell(_file), _offset);
+
+    char _buffer[4096];
+    EXPECT_EQ(gpak_fread(_buffer, 1ull, sizeof(_buffer), _file), sizeof(_buffer));
+    EXPECT_EQ(std::memcmp(_buffer, _source.data() + _offset, sizeof(_buffer)), 0);
+
+    EXPECT_EQ(gpak_fseek(_file, -10l, SEEK_END), 0);
+    EXPECT_EQ(gpak_fread(_buffer, 1ull, sizeof(_buffer), _file), 10ull);
+    EXPECT_EQ(std::memcmp(_buffer, _source.data() + _source.size() - 10ull, 10ull), 0);
+
+    // Lines and characters are served from the decoded chunk, lines crossing a chunk boundary are joined
+    EXPECT_EQ(gpak_fseek(_file, 0l, SEEK_SET), 0);
+    std::string _lines;
+    char _line[16];
+    while (_lines.size() < 256ull * 1024ull && gpak_fgets(_file, _line, sizeof(_line)))
+        _lines += _line;
+    EXPECT_EQ(_lines, _source.substr(0ull, _lines.size()));
+
+    EXPECT_EQ(gpak_fseek(_file, 64l * 1024l - 2l, SEEK_SET), 0);
+    for (size_t idx = 64ull * 1024ull - 2ull; idx < 64ull * 1024ull + 2ull; ++idx)
+        EXPECT_EQ(gpak_fgetc(_file), (unsigned char)_source[idx]);
+
+    gpak_fclose(_file);
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_solid_zstd)
+{
+    auto _archive_path = _tests_out_entry / "solid.gpak";
+    auto _source_path = _tests_out_entry / "solid";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+
+    // Many small text files, like the json and shader files solid blocks are meant for
+    std::vector<std::string> _sources;
+    for (size_t i = 0; i < 64ull; ++i)
+    {
+        std::string _source = "{\n";
+        for (size_t j = 0; j < 4ull + i * 3ull; ++j)
+            _source += "    \"key" + std::to_string(j) + "\": " + std::to_string(i * j) + ",\n";
+        _source += "}\n";
+
+        std::ofstream file(_source_path / ("file" + std::to_string(i) + ".json"), std::ios::binary);
+        file.write(_source.data(), _source.size());
+        _sources.push_back(_source);
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    // Appending in update mode adds a block and keeps the existing ones
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_UPDATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_add_file(_pak, (_source_path / "file0.json").string().c_str(), "extra/file0.json");
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    EXPECT_EQ(_pak->header_.entry_count_, _sources.size() + 1ull);
+    EXPECT_GT(_pak->block_count_, 1u);
+    EXPECT_LT(_pak->block_count_, _sources.size());
+
+    for (size_t i = 0; i <= _sources.size(); ++i)
+    {
+        std::string _path = i < _sources.size() ? "file" + std::to_string(i) + ".json" : "extra/file0.json";
+        const std::string& _source = i < _sources.size() ? _sources[i] : _sources[0];
+
+        auto* _file = gpak_fopen(_pak, _path.c_str());
+        ASSERT_NE(_file, nullptr);
+        EXPECT_NE(_file->entry_.flags_ & GPAK_ENTRY_FLAG_SOLID, 0u);
+
+        std::string _readed(_source.size() + 16ull, '\0');
+        EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _source.size());
+        _readed.resize(_source.size());
+        EXPECT_TRUE(_readed == _source);
+
+        gpak_fclose(_file);
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_aligned_none)
+{
+    auto _archive_path = _tests_out_entry / "aligned.gpak";
+    test_gpak_error_count = 0ull;
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_NONE);
+    gpak_set_solid_block_size(_pak, 1024u);
+    EXPECT_EQ(gpak_set_alignment(_pak, 3000u), GPAK_ERROR_INVALID_ALIGNMENT);
+    EXPECT_EQ(gpak_set_alignment(_pak, 4096u), GPAK_ERROR_OK);
+    test_gpak_error_count = 0ull;
+
+    gpak_test_add_files(_pak, _tests_entry);
+    gpak_add_file(_pak, (_tests_out_entry / "extra.dat").string().c_str(), "extra/extra.dat");
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    EXPECT_EQ(_pak->header_.alignment_, 4096u);
+
+    for (uint32_t idx = 0u; idx < _pak->header_.entry_count_; ++idx)
+    {
+        if (!(_pak->entries_[idx].flags_ & GPAK_ENTRY_FLAG_SOLID))
+        {
+            EXPECT_EQ(_pak->entries_[idx].offset_ % 4096ull, 0ull);
+        }
+    }
+
+    for (uint32_t idx = 0u; idx < _pak->block_count_; ++idx)
+        EXPECT_EQ(_pak->blocks_[idx].offset_ % 4096ull, 0ull);
+
+    gpak_test_extract_files(_pak, _tests_out_entry / "aligned");
+    gpak_close(_pak);
+
+    EXPECT_EQ(number_of_files_in_directory(_tests_out_entry / "aligned"), test_folder_count * test_files_per_folder_count + 1ull);
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_dedup_zstd)
+{
+    auto _archive_path = _tests_out_entry / "dedup.gpak";
+    auto _source_path = _tests_out_entry / "dedup";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+
+    // Two copies of a large and of a small file, plus a file of the same size with different content
+    generate_random_file(_source_path / "texture.dat", 200000ull);
+    generate_random_file(_source_path / "other.dat", 200000ull);
+    generate_random_file(_source_path / "small.dat", 300ull);
+    fs::copy_file(_source_path / "texture.dat", _source_path / "texture_copy.dat");
+    fs::copy_file(_source_path / "small.dat", _source_path / "small_copy.dat");
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_solid_block_size(_pak, 4096u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    // Random data does not compress, one copy of each distinct file is stored
+    EXPECT_LT(fs::file_size(_archive_path), 3ull * 200000ull);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    auto* _texture = gpak_find_file(_pak, "texture.dat");
+    auto* _texture_copy = gpak_find_file(_pak, "texture_copy.dat");
+    auto* _other = gpak_find_file(_pak, "other.dat");
+    ASSERT_TRUE(_texture && _texture_copy && _other);
+    EXPECT_EQ(_texture->entry_.offset_, _texture_copy->entry_.offset_);
+    EXPECT_NE(_texture->entry_.offset_, _other->entry_.offset_);
+    EXPECT_NE(_texture->entry_.flags_ & GPAK_ENTRY_FLAG_SHARED, 0u);
+    EXPECT_EQ(_other->entry_.flags_ & GPAK_ENTRY_FLAG_SHARED, 0u);
+
+    auto* _small = gpak_find_file(_pak, "small.dat");
+    auto* _small_copy = gpak_find_file(_pak, "small_copy.dat");
+    ASSERT_TRUE(_small && _small_copy);
+    EXPECT_EQ(_small->entry_.block_index_, _small_copy->entry_.block_index_);
+    EXPECT_EQ(_small->entry_.offset_, _small_copy->entry_.offset_);
+
+    for (const char* _name : { "texture.dat", "texture_copy.dat", "other.dat", "small.dat", "small_copy.dat" })
+    {
+        std::ifstream _source_file(_source_path / _name, std::ios::binary);
+        std::string _source((std::istreambuf_iterator<char>(_source_file)), std::istreambuf_iterator<char>());
+
+        auto* _file = gpak_fopen(_pak, _name);
+        ASSERT_NE(_file, nullptr);
+
+        std::string _readed(_source.size(), '\0');
+        EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _source.size());
+        EXPECT_TRUE(_readed == _source);
+        gpak_fclose(_file);
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_content_chunking_zstd)
+{
+    auto _archive_path = _tests_out_entry / "cdc.gpak";
+    auto _source_path = _tests_out_entry / "cdc";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+
+    // A level and a variant of it with bytes inserted and changed in the middle
+    generate_random_file(_source_path / "level.dat", 600000ull);
+
+    std::string _level;
+    {
+        std::ifstream file(_source_path / "level.dat", std::ios::binary);
+        _level.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string _variant = _level;
+    _variant.insert(250000ull, "a few inserted bytes that shift everything after them");
+    _variant[450000ull] ^= 0x5a;
+    {
+        std::ofstream file(_source_path / "level_variant.dat", std::ios::binary);
+        file.write(_variant.data(), _variant.size());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_content_chunking(_pak, 16u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    // Random data does not compress, only the chunks around the edits are stored twice
+    EXPECT_LT(fs::file_size(_archive_path), _level.size() + _level.size() / 4ull);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    for (const auto& [_name, _source] : { std::make_pair("level.dat", &_level), std::make_pair("level_variant.dat", &_variant) })
+    {
+        auto* _file = gpak_fopen(_pak, _name);
+        ASSERT_NE(_file, nullptr);
+        EXPECT_NE(_file->entry_.flags_ & GPAK_ENTRY_FLAG_CHUNK_LIST, 0u);
+
+        std::string _readed(_source->size(), '\0');
+        EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _source->size());
+        EXPECT_TRUE(_readed == *_source);
+        gpak_fclose(_file);
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_dictionaries_zstd)
+{
+    auto _archive_path = _tests_out_entry / "dictionaries.gpak";
+    auto _source_path = _tests_out_entry / "dictionaries";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+
+    auto _sources = generate_text_files(_source_path, 24ull, 17u);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_solid_block_size(_pak, 32u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    // One dictionary per extension, solid blocks never mix them
+    EXPECT_EQ(_pak->dictionary_count_, 2u);
+
+    std::map<std::string, uint32_t> _dictionary_ids;
+    for (const auto& [_name, _content] : _sources)
+    {
+        auto* _file = gpak_fopen(_pak, _name.c_str());
+        ASSERT_NE(_file, nullptr);
+
+        auto _extension = fs::path(_name).extension().string();
+        EXPECT_NE(_file->entry_.dictionary_id_, 0u);
+        if (_dictionary_ids.count(_extension))
+        {
+            EXPECT_EQ(_file->entry_.dictionary_id_, _dictionary_ids[_extension]);
+        }
+        _dictionary_ids[_extension] = _file->entry_.dictionary_id_;
+
+        if (_file->entry_.flags_ & GPAK_ENTRY_FLAG_SOLID)
+        {
+            EXPECT_EQ(_pak->blocks_[_file->entry_.block_index_].dictionary_id_, _file->entry_.dictionary_id_);
+        }
+
+        std::string _readed(_content.size(), '\0');
+        EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _content.size());
+        EXPECT_TRUE(_readed == _content);
+        gpak_fclose(_file);
+    }
+
+    EXPECT_NE(_dictionary_ids[".json"], _dictionary_ids[".lua"]);
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_shared_dictionary_zstd)
+{
+    auto _base_path = _tests_out_entry / "shared_base.gpak";
+    auto _dictionary_path = _tests_out_entry / "shared.gdict";
+    auto _source_path = _tests_out_entry / "shared";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 24ull, 23u);
+
+    // The base archive trains the dictionaries the patches are packed with
+    auto* _pak = gpak_open(_base_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_base_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    EXPECT_EQ(gpak_save_dictionary(_pak, _dictionary_path.string().c_str()), GPAK_ERROR_OK);
+    gpak_close(_pak);
+
+    uint64_t _content_id{ 0ull };
+    ASSERT_EQ(gpak_register_dictionary(_dictionary_path.string().c_str(), &_content_id), GPAK_ERROR_OK);
+    EXPECT_NE(_content_id, 0ull);
+
+    uint64_t _same_id{ 0ull };
+    EXPECT_EQ(gpak_register_dictionary(_dictionary_path.string().c_str(), &_same_id), GPAK_ERROR_OK);
+    EXPECT_EQ(_same_id, _content_id);
+
+    std::vector<fs::path> _patches{ _tests_out_entry / "shared_patch0.gpak", _tests_out_entry / "shared_patch1.gpak" };
+    for (const auto& _patch_path : _patches)
+    {
+        _pak = gpak_open(_patch_path.string().c_str(), GPAK_MODE_CREATE);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+        gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+        EXPECT_EQ(gpak_set_shared_dictionary(_pak, _content_id), GPAK_ERROR_OK);
+        gpak_test_add_files(_pak, _source_path);
+        gpak_close(_pak);
+    }
+
+    std::vector<gpak_t*> _readers;
+    for (const auto& _patch_path : _patches)
+    {
+        _pak = gpak_open(_patch_path.string().c_str(), GPAK_MODE_READ_ONLY);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+
+        // Nothing is embedded, every reader uses the registered dictionaries
+        EXPECT_EQ(_pak->header_.dictionary_size_, 0u);
+        EXPECT_EQ(_pak->dictionary_count_, 2u);
+        if (!_readers.empty())
+        {
+            EXPECT_EQ(_pak->shared_dictionary_, _readers.front()->shared_dictionary_);
+        }
+        _readers.push_back(_pak);
+    }
+
+    // Open archives keep the dictionaries alive
+    EXPECT_EQ(gpak_unregister_dictionary(_content_id), GPAK_ERROR_OK);
+    EXPECT_EQ(gpak_unregister_dictionary(_content_id), GPAK_ERROR_DICTIONARY_NOT_REGISTERED);
+
+    for (auto* _reader : _readers)
+    {
+        for (const auto& [_name, _content] : _sources)
+        {
+            auto* _file = gpak_fopen(_reader, _name.c_str());
+            ASSERT_NE(_file, nullptr);
+            EXPECT_NE(_file->entry_.dictionary_id_, 0u);
+
+            std::string _readed(_content.size(), '\0');
+            EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _content.size());
+            EXPECT_TRUE(_readed == _content);
+            gpak_fclose(_file);
+        }
+
+        gpak_close(_reader);
+    }
+
+    // Without the dictionary file the patches cannot be read
+    EXPECT_EQ(gpak_open(_patches.front().string().c_str(), GPAK_MODE_READ_ONLY), nullptr);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_memory_zstd)
+{
+    auto _archive_path = _tests_out_entry / "memory.gpak";
+    auto _source_path = _tests_out_entry / "memory";
+    test_gpak_error_count = 0ull;
+
+    // Solid, chunked and plain entries all have to be readable from memory
+    auto _sources = gpak_test_pack_sources(_archive_path, _source_path, 12ull, 31u);
+
+    std::string _image;
+    {
+        std::ifstream file(_archive_path, std::ios::binary);
+        _image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // An image at an odd address, like an archive embedded without alignment
+    std::vector<char> _embedded(_image.size() + 1ull);
+    std::memcpy(_embedded.data() + 1, _image.data(), _image.size());
+
+    std::vector<gpak_t*> _readers{
+        gpak_open(_archive_path.string().c_str(), GPAK_MODE_MEMORY_MAP),
+        gpak_open_memory(_image.data(), _image.size()),
+        gpak_open_memory(_embedded.data() + 1, _image.size())
+    };
+
+    for (auto* _reader : _readers)
+    {
+        ASSERT_NE(_reader, nullptr);
+        gpak_set_error_handler(_reader, &error_handler);
+        EXPECT_EQ(_reader->stream_, nullptr);
+
+        for (const auto& [_name, _content] : _sources)
+        {
+            auto* _file = gpak_fopen(_reader, _name.c_str());
+            ASSERT_NE(_file, nullptr);
+
+            std::string _readed(_content.size(), '\0');
+            EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _content.size());
+            EXPECT_TRUE(_readed == _content);
+            gpak_fclose(_file);
+        }
+
+        gpak_close(_reader);
+    }
+
+    // A truncated image is rejected
+    EXPECT_EQ(gpak_open_memory(_image.data(), _image.size() - 1ull), nullptr);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_fmap_none)
+{
+    auto _archive_path = _tests_out_entry / "fmap.gpak";
+    auto _source_path = _tests_out_entry / "fmap";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 8ull, 37u);
+
+    generate_random_file(_source_path / "page.dat", 100000ull);
+    {
+        std::ifstream file(_source_path / "page.dat", std::ios::binary);
+        _sources["page.dat"].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_NONE);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    // Mapped stored entries are not copied
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_MEMORY_MAP);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    for (const auto& [_name, _content] : _sources)
+    {
+        gpak_view_t _view;
+        ASSERT_EQ(gpak_fmap(_pak, _name.c_str(), &_view, 1), GPAK_ERROR_OK);
+        EXPECT_EQ(_view.buffer_, nullptr);
+        EXPECT_GE(_view.data_, _pak->memory_);
+        EXPECT_LE(_view.data_ + _view.size_, _pak->memory_ + _pak->memory_size_);
+        EXPECT_TRUE(std::string(_view.data_, _view.size_) == _content);
+        gpak_funmap(&_view);
+    }
+
+    gpak_view_t _missing;
+    EXPECT_EQ(gpak_fmap(_pak, "missing.dat", &_missing, 1), GPAK_ERROR_FILE_NOT_FOUND);
+    --test_gpak_error_count;
+
+    gpak_close(_pak);
+
+    // Archives read through a stream fall back to a decoded copy
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    for (const auto& [_name, _content] : _sources)
+    {
+        gpak_view_t _view;
+        ASSERT_EQ(gpak_fmap(_pak, _name.c_str(), &_view, 0), GPAK_ERROR_OK);
+        EXPECT_NE(_view.buffer_, nullptr);
+        EXPECT_TRUE(std::string(_view.data_, _view.size_) == _content);
+        gpak_funmap(&_view);
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_streaming_zstd)
+{
+    auto _archive_path = _tests_out_entry / "streaming.gpak";
+    auto _source_path = _tests_out_entry / "streaming.dat";
+    test_gpak_error_count = 0ull;
+
+    // Several stream windows of text followed by random bytes
+    std::string _source;
+    for (size_t i = 0; _source.size() < 700ull * 1024ull; ++i)
+        _source += "streamed line " + std::to_string(i) + "\n";
+    generate_random_file(_tests_out_entry / "streaming_random.dat", 300000ull);
+    {
+        std::ifstream file(_tests_out_entry / "streaming_random.dat", std::ios::binary);
+        _source.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        std::ofstream outfile(_source_path, std::ios::binary);
+        outfile.write(_source.data(), _source.size());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_add_file(_pak, _source_path.string().c_str(), "streaming.dat");
+    gpak_close(_pak);
+
+    for (int _mode : { GPAK_MODE_READ_ONLY, GPAK_MODE_MEMORY_MAP })
+    {
+        _pak = gpak_open(_archive_path.string().c_str(), _mode);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_set_stream_threshold(_pak, 512ull * 1024ull);
+
+        auto* _file = gpak_fopen(_pak, "streaming.dat");
+        ASSERT_NE(_file, nullptr);
+        EXPECT_NE(_file->reader_, nullptr);
+
+        // Reads of an odd size straddle the window boundaries
+        std::string _readed;
+        char _buffer[10007];
+        size_t _readed_size = 0ull;
+        while ((_readed_size = gpak_fread(_buffer, 1ull, sizeof(_buffer), _file)) > 0ull)
+            _readed.append(_buffer, _readed_size);
+        EXPECT_TRUE(_readed == _source);
+        EXPECT_EQ(gpak_fgetc(_file), EOF);
+        EXPECT_NE(gpak_feof(_file), 0);
+
+        // Seeking backwards decodes again from the start
+        EXPECT_EQ(gpak_fseek(_file, 123456l, SEEK_SET), 0);
+        EXPECT_EQ(gpak_ftell(_file), 123456l);
+        char _line[64];
+        ASSERT_NE(gpak_fgets(_file, _line, sizeof(_line)), nullptr);
+        EXPECT_EQ(std::string(_line), _source.substr(123456ull, _source.find('\n', 123456ull) + 1ull - 123456ull));
+
+        // A pushed back character does not move the decoded window
+        long _position = gpak_ftell(_file);
+        EXPECT_EQ(gpak_ungetc(_file, '#'), '#');
+        EXPECT_EQ(gpak_ftell(_file), _position - 1l);
+        EXPECT_EQ(gpak_fgetc(_file), '#');
+        EXPECT_EQ(gpak_fgetc(_file), (unsigned char)_source[(size_t)_position]);
+
+        EXPECT_EQ(gpak_fseek(_file, -10l, SEEK_END), 0);
+        EXPECT_EQ(gpak_fread(_buffer, 1ull, sizeof(_buffer), _file), 10ull);
+        EXPECT_EQ(std::memcmp(_buffer, _source.data() + _source.size() - 10ull, 10ull), 0);
+
+        gpak_fclose(_file);
+        gpak_close(_pak);
+    }
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+
+    // Damage is reported once the end of the file is reached
+    uint64_t _payload_end = 0ull;
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    auto* _entry = gpak_find_file(_pak, "streaming.dat");
+    ASSERT_NE(_entry, nullptr);
+    _payload_end = _entry->entry_.offset_ + _entry->entry_.compressed_size_;
+    gpak_close(_pak);
+    {
+        std::fstream file(_archive_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg((std::streamoff)(_payload_end - 1000ull));
+        char _byte = static_cast<char>(file.get() ^ 0x5a);
+        file.seekp((std::streamoff)(_payload_end - 1000ull));
+        file.put(_byte);
+    }
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_stream_threshold(_pak, 512ull * 1024ull);
+
+    auto* _file = gpak_fopen(_pak, "streaming.dat");
+    ASSERT_NE(_file, nullptr);
+    std::string _readed(_source.size(), '\0');
+    gpak_fread(_readed.data(), 1ull, _readed.size(), _file);
+    EXPECT_GE(test_gpak_error_count, 1ull);
+
+    gpak_fclose(_file);
+    gpak_close(_pak);
+}
+
+TEST(gpak_test, gpak_read_entry_into_zstd)
+{
+    auto _archive_path = _tests_out_entry / "read_into.gpak";
+    auto _source_path = _tests_out_entry / "read_into";
+    test_gpak_error_count = 0ull;
+
+    auto _sources = gpak_test_pack_sources(_archive_path, _source_path, 12ull, 41u);
+
+    for (int _mode : { GPAK_MODE_READ_ONLY, GPAK_MODE_MEMORY_MAP })
+    {
+        auto* _pak = gpak_open(_archive_path.string().c_str(), _mode);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+
+        // Every entry kind lands in a buffer the caller owns
+        for (const auto& [_name, _content] : _sources)
+        {
+            std::vector<char> _buffer(_content.size() + 16ull);
+            ASSERT_EQ(gpak_read_entry_into(_pak, _name.c_str(), _buffer.data(), _buffer.size()), GPAK_ERROR_OK);
+            EXPECT_TRUE(std::string(_buffer.data(), _content.size()) == _content);
+        }
+
+        char _small[16];
+        EXPECT_EQ(gpak_read_entry_into(_pak, "large.dat", _small, sizeof(_small)), GPAK_ERROR_BUFFER_TOO_SMALL);
+        EXPECT_EQ(gpak_read_entry_into(_pak, "missing.dat", _small, sizeof(_small)), GPAK_ERROR_FILE_NOT_FOUND);
+        test_gpak_error_count -= 2ull;
+
+        gpak_close(_pak);
+    }
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_concurrent_readers_zstd)
+{
+    auto _archive_path = _tests_out_entry / "concurrent.gpak";
+    auto _source_path = _tests_out_entry / "concurrent";
+
+    auto _sources = gpak_test_pack_sources(_archive_path, _source_path, 24ull, 43u);
+
+    // One handle, one index, every thread opening files from it at once
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+
+    std::vector<std::pair<std::string, std::string>> _entries(_sources.begin(), _sources.end());
+    std::atomic<size_t> _mismatches{ 0ull };
+    std::atomic<size_t> _thread_errors{ 0ull };
+
+    std::vector<std::thread> _threads;
+    for (uint32_t t = 0u; t < 8u; ++t)
+    {
+        _threads.emplace_back([&, t]()
+        {
+            auto _order = _entries;
+            std::shuffle(_order.begin(), _order.end(), std::mt19937(t));
+
+            for (uint32_t pass = 0u; pass < 3u; ++pass)
+            {
+                for (const auto& [_name, _content] : _order)
+                {
+                    std::string _readed(_content.size(), '\0');
+                    if ((pass + t) % 2u == 0u)
+                    {
+                        auto* _file = gpak_fopen(_pak, _name.c_str());
+                        if (!_file || gpak_fread(_readed.data(), 1ull, _readed.size(), _file) != _content.size())
+                            ++_mismatches;
+                        if (_file)
+                            gpak_fclose(_file);
+                    }
+                    else if (gpak_read_entry_into(_pak, _name.c_str(), _readed.data(), _readed.size()) != GPAK_ERROR_OK)
+                        ++_mismatches;
+
+                    if (_readed != _content)
+                        ++_mismatches;
+                }
+            }
+
+            if (gpak_get_last_error() != GPAK_ERROR_OK)
+                ++_thread_errors;
+        });
+    }
+
+    for (auto& _thread : _threads)
+        _thread.join();
+
+    EXPECT_EQ(_mismatches.load(), 0ull);
+    EXPECT_EQ(_thread_errors.load(), 0ull);
+
+    // Errors stay on the thread that made them
+    EXPECT_EQ(gpak_fopen(_pak, "missing.dat"), nullptr);
+    EXPECT_EQ(gpak_get_last_error(), GPAK_ERROR_FILE_NOT_FOUND);
+    int _other_error = GPAK_ERROR_FILE_NOT_FOUND;
+    std::thread([&]() { _other_error = gpak_get_last_error(); }).join();
+    EXPECT_EQ(_other_error, GPAK_ERROR_OK);
+
+    gpak_close(_pak);
+}
+
+TEST(gpak_test, gpak_pooled_decoders_deflate)
+{
+    auto _archive_path = _tests_out_entry / "pooled.gpak";
+    auto _source_path = _tests_out_entry / "pooled";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 48ull, 47u);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_DEFLATE);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_DEFLATE_FAST);
+    gpak_set_solid_block_size(_pak, 4u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    // Every read reuses the same inflate context and scratch buffer, which must not leak state between entries
+    for (uint32_t pass = 0u; pass < 2u; ++pass)
+    {
+        for (const auto& [_name, _content] : _sources)
+        {
+            auto* _file = gpak_fopen(_pak, _name.c_str());
+            ASSERT_NE(_file, nullptr);
+
+            std::string _readed(_content.size(), '\0');
+            EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _content.size());
+            EXPECT_TRUE(_readed == _content);
+            gpak_fclose(_file);
+        }
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_entry_cache_zstd)
+{
+    auto _archive_path = _tests_out_entry / "entry_cache.gpak";
+    auto _source_path = _tests_out_entry / "entry_cache";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 8ull, 53u);
+
+    generate_random_file(_source_path / "atlas.dat", 200000ull);
+    {
+        std::ifstream file(_source_path / "atlas.dat", std::ios::binary);
+        _sources["atlas.dat"].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    auto _read_all = [&](const std::string& _name)
+    {
+        auto* _file = gpak_fopen(_pak, _name.c_str());
+        if (!_file)
+            return std::string();
+
+        std::string _readed(_sources[_name].size(), '\0');
+        _readed.resize(gpak_fread(_readed.data(), 1ull, _readed.size(), _file));
+        gpak_fclose(_file);
+        return _readed;
+    };
+
+    // Disabled by default, nothing is counted
+    gpak_cache_stats_t _stats;
+    EXPECT_TRUE(_read_all("atlas.dat") == _sources["atlas.dat"]);
+    gpak_get_cache_stats(_pak, &_stats);
+    EXPECT_EQ(_stats.misses_, 0ull);
+    EXPECT_EQ(_stats.entry_count_, 0ull);
+
+    // A hot entry is decoded once and shared by every handle
+    gpak_set_entry_cache_budget(_pak, 256ull * 1024ull);
+    auto* _first = gpak_fopen(_pak, "atlas.dat");
+    auto* _second = gpak_fopen(_pak, "atlas.dat");
+    ASSERT_NE(_first, nullptr);
+    ASSERT_NE(_second, nullptr);
+    EXPECT_EQ(_first->data_, _second->data_);
+    gpak_get_cache_stats(_pak, &_stats);
+    EXPECT_EQ(_stats.misses_, 1ull);
+    EXPECT_EQ(_stats.hits_, 1ull);
+    EXPECT_EQ(_stats.size_, _sources["atlas.dat"].size());
+
+    // Referenced entries survive pressure, the content is still readable
+    for (const auto& [_name, _content] : _sources)
+        EXPECT_TRUE(_read_all(_name) == _content);
+    std::string _readed(_sources["atlas.dat"].size(), '\0');
+    EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _second), _readed.size());
+    EXPECT_TRUE(_readed == _sources["atlas.dat"]);
+    gpak_fclose(_first);
+    gpak_fclose(_second);
+
+    // Unreferenced entries are evicted to fit a smaller budget, pinned ones stay
+    const std::string _pinned_name = _sources.rbegin()->first;
+    EXPECT_EQ(gpak_pin_entry(_pak, _pinned_name.c_str()), GPAK_ERROR_OK);
+    gpak_set_entry_cache_budget(_pak, 1ull);
+    gpak_get_cache_stats(_pak, &_stats);
+    EXPECT_GT(_stats.evictions_, 0ull);
+    EXPECT_EQ(_stats.entry_count_, 1ull);
+    EXPECT_EQ(_stats.pinned_count_, 1ull);
+
+    uint64_t _hits = _stats.hits_;
+    EXPECT_TRUE(_read_all(_pinned_name) == _sources[_pinned_name]);
+    gpak_view_t _view;
+    ASSERT_EQ(gpak_fmap(_pak, _pinned_name.c_str(), &_view, 1), GPAK_ERROR_OK);
+    EXPECT_NE(_view.cached_, nullptr);
+    EXPECT_TRUE(std::string(_view.data_, _view.size_) == _sources[_pinned_name]);
+    gpak_funmap(&_view);
+    gpak_get_cache_stats(_pak, &_stats);
+    EXPECT_EQ(_stats.hits_, _hits + 2ull);
+
+    EXPECT_EQ(gpak_unpin_entry(_pak, _pinned_name.c_str()), GPAK_ERROR_OK);
+    gpak_get_cache_stats(_pak, &_stats);
+    EXPECT_EQ(_stats.entry_count_, 0ull);
+    EXPECT_EQ(_stats.size_, 0ull);
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_read_batch_zstd)
+{
+    auto _archive_path = _tests_out_entry / "batch.gpak";
+    auto _source_path = _tests_out_entry / "batch";
+    test_gpak_error_count = 0ull;
+
+    auto _sources = gpak_test_pack_sources(_archive_path, _source_path, 32ull, 53u, 128u * 1024u, 8ull, 30000ull, 5000ull);
+
+    for (int _mode : { GPAK_MODE_READ_ONLY, GPAK_MODE_MEMORY_MAP })
+    {
+        auto* _pak = gpak_open(_archive_path.string().c_str(), _mode);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+
+        // Half of the files land in caller buffers, the other half in views, in reverse archive order
+        std::vector<std::pair<std::string, std::string>> _entries(_sources.rbegin(), _sources.rend());
+        std::vector<std::vector<char>> _buffers(_entries.size());
+        std::vector<gpak_batch_read_t> _reads(_entries.size());
+        for (size_t idx = 0ull; idx < _entries.size(); ++idx)
+        {
+            _reads[idx].path_ = _entries[idx].first.c_str();
+            if (idx % 2ull == 0ull)
+            {
+                _buffers[idx].resize(_entries[idx].second.size() + 8ull);
+                _reads[idx].dst_ = _buffers[idx].data();
+                _reads[idx].dst_size_ = _buffers[idx].size();
+            }
+        }
+
+        ASSERT_EQ(gpak_read_batch(_pak, _reads.data(), _reads.size()), GPAK_ERROR_OK);
+        for (size_t idx = 0ull; idx < _entries.size(); ++idx)
+        {
+            const auto& _content = _entries[idx].second;
+            EXPECT_EQ(_reads[idx].error_, GPAK_ERROR_OK);
+            if (_reads[idx].dst_)
+                EXPECT_TRUE(std::string(_buffers[idx].data(), _content.size()) == _content);
+            else
+            {
+                EXPECT_EQ(_reads[idx].view_.size_, _content.size());
+                EXPECT_TRUE(std::string(_reads[idx].view_.data_, _reads[idx].view_.size_) == _content);
+                gpak_funmap(&_reads[idx].view_);
+            }
+        }
+
+        // Files that cannot be read do not hold back the others
+        char _small[16];
+        gpak_batch_read_t _mixed[3]{};
+        _mixed[0].path_ = "missing.dat";
+        _mixed[1].path_ = "large.dat";
+        _mixed[1].dst_ = _small;
+        _mixed[1].dst_size_ = sizeof(_small);
+        _mixed[2].path_ = "plain_3.dat";
+        EXPECT_EQ(gpak_read_batch(_pak, _mixed, 3ull), GPAK_ERROR_FILE_NOT_FOUND);
+        EXPECT_EQ(_mixed[1].error_, GPAK_ERROR_BUFFER_TOO_SMALL);
+        EXPECT_EQ(_mixed[2].error_, GPAK_ERROR_OK);
+        EXPECT_TRUE(std::string(_mixed[2].view_.data_, _mixed[2].view_.size_) == _sources["plain_3.dat"]);
+        gpak_funmap(&_mixed[2].view_);
+        test_gpak_error_count -= 2ull;
+
+        gpak_close(_pak);
+    }
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_read_batch_corrupt_block_none)
+{
+    auto _archive_path = _tests_out_entry / "batch_corrupt.gpak";
+    auto _source_path = _tests_out_entry / "batch_corrupt";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 1ull, 71u);
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_NONE);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    ASSERT_EQ(_pak->block_count_, 1u);
+    uint64_t _block_offset = _pak->blocks_[0].offset_;
+    gpak_close(_pak);
+
+    // A byte of the stored block is flipped, both files share the damaged block
+    {
+        std::fstream file(_archive_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg((std::streamoff)_block_offset);
+        char _byte = 0;
+        file.read(&_byte, 1);
+        _byte ^= 0x5a;
+        file.seekp((std::streamoff)_block_offset);
+        file.write(&_byte, 1);
+    }
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    gpak_batch_read_t _reads[2]{};
+    _reads[0].path_ = "config_0.json";
+    _reads[1].path_ = "script_0.lua";
+    EXPECT_NE(gpak_read_batch(_pak, _reads, 2ull), GPAK_ERROR_OK);
+    EXPECT_EQ(_reads[0].error_, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+    EXPECT_EQ(_reads[1].error_, GPAK_ERROR_FILE_CRC_NOT_MATCH);
+
+    // The damaged block must not be served from the block cache to later readers
+    for (auto _path : { "config_0.json", "script_0.lua" })
+    {
+        auto* _file = gpak_fopen(_pak, _path);
+        EXPECT_EQ(_file, nullptr);
+        if (_file)
+            gpak_fclose(_file);
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_GT(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_async_read_zstd)
+{
+    auto _archive_path = _tests_out_entry / "async.gpak";
+    auto _source_path = _tests_out_entry / "async";
+    test_gpak_error_count = 0ull;
+
+    auto _sources = gpak_test_pack_sources(_archive_path, _source_path, 16ull, 47u, 128u * 1024u, 12ull, 40000ull, 1000ull);
+
+    struct async_results
+    {
+        std::map<std::string, std::string> contents_;
+        size_t errors_{ 0ull };
+    };
+
+    auto _handler = [](const char* _path, int32_t _error, gpak_view_t* _view, void* _user_data)
+    {
+        auto* _results = static_cast<async_results*>(_user_data);
+        if (_error != GPAK_ERROR_OK)
+            ++_results->errors_;
+        else
+            _results->contents_[_path].assign(_view->data_, _view->size_);
+        gpak_funmap(_view);
+    };
+
+    for (int _mode : { GPAK_MODE_READ_ONLY, GPAK_MODE_MEMORY_MAP })
+    {
+        auto* _pak = gpak_open(_archive_path.string().c_str(), _mode);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+
+        // A shallow queue keeps some reads waiting for a free slot
+        async_results _results;
+        auto* _async = gpak_async_create(_pak, 4u);
+        ASSERT_NE(_async, nullptr);
+
+        for (const auto& [_name, _content] : _sources)
+            ASSERT_EQ(gpak_async_read(_async, _name.c_str(), _handler, &_results), GPAK_ERROR_OK);
+        EXPECT_EQ(gpak_async_read(_async, "missing.dat", _handler, &_results), GPAK_ERROR_FILE_NOT_FOUND);
+        test_gpak_error_count -= 1ull;
+
+        while (gpak_async_pending(_async) > 0u)
+            EXPECT_GT(gpak_async_poll(_async, 1), 0u);
+        EXPECT_EQ(gpak_async_poll(_async, 1), 0u);
+
+        EXPECT_EQ(_results.errors_, 0ull);
+        EXPECT_TRUE(_results.contents_ == _sources);
+
+        // Reads left pending are completed when the queue is freed
+        async_results _late_results;
+        for (const auto& [_name, _content] : _sources)
+            gpak_async_read(_async, _name.c_str(), _handler, &_late_results);
+        gpak_async_free(_async);
+        EXPECT_TRUE(_late_results.contents_ == _sources);
+
+        gpak_close(_pak);
+    }
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_file_cursor_zstd)
+{
+    auto _archive_path = _tests_out_entry / "cursor.gpak";
+    auto _source_path = _tests_out_entry / "cursor";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+
+    std::string _text;
+    for (uint32_t idx = 0u; idx < 200u; ++idx)
+        _text += "line " + std::to_string(idx) + std::string(idx % 37u, 'x') + "\n";
+    _text += "last line without end";
+    {
+        std::ofstream file(_source_path / "lines.txt", std::ios::binary);
+        file << _text;
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    auto* _file = gpak_fopen(_pak, "lines.txt");
+    ASSERT_NE(_file, nullptr);
+
+    // Lines come back as fgets would return them, long lines are split at the buffer size
+    std::string _readed;
+    char _line[16];
+    while (gpak_fgets(_file, _line, sizeof(_line)))
+    {
+        EXPECT_LT(std::strlen(_line), sizeof(_line));
+        _readed += _line;
+    }
+    EXPECT_TRUE(_readed == _text);
+    EXPECT_NE(gpak_feof(_file), 0);
+    EXPECT_EQ(gpak_fgetc(_file), EOF);
+    EXPECT_EQ(gpak_ftell(_file), (long)_text.size());
+
+    EXPECT_EQ(gpak_fseek(_file, 5l, SEEK_SET), 0);
+    EXPECT_EQ(gpak_feof(_file), 0);
+    EXPECT_EQ(gpak_fgetc(_file), '0');
+    EXPECT_EQ(gpak_ungetc(_file, '0'), '0');
+    EXPECT_EQ(gpak_ftell(_file), 5l);
+    ASSERT_NE(gpak_fgets(_file, _line, sizeof(_line)), nullptr);
+    EXPECT_STREQ(_line, "0\n");
+
+    // The character given is the one read back, also at the start of the file, and only one is kept
+    EXPECT_EQ(gpak_fseek(_file, 0l, SEEK_SET), 0);
+    EXPECT_EQ(gpak_ungetc(_file, '#'), '#');
+    EXPECT_EQ(gpak_ungetc(_file, '$'), EOF);
+    EXPECT_EQ(gpak_ftell(_file), 0l);
+    EXPECT_EQ(gpak_fgetc(_file), '#');
+    EXPECT_EQ(gpak_fgetc(_file), 'l');
+    EXPECT_EQ(gpak_ungetc(_file, 'L'), 'L');
+    EXPECT_EQ(gpak_ftell(_file), 0l);
+    ASSERT_NE(gpak_fgets(_file, _line, sizeof(_line)), nullptr);
+    EXPECT_STREQ(_line, "Line 0\n");
+    EXPECT_EQ(gpak_ungetc(_file, '*'), '*');
+    char _head[4]{};
+    EXPECT_EQ(gpak_fread(_head, 1ull, 3ull, _file), 3ull);
+    EXPECT_STREQ(_head, "*li");
+    EXPECT_EQ(gpak_ungetc(_file, 'x'), 'x');
+    EXPECT_EQ(gpak_fseek(_file, 1l, SEEK_CUR), 0);
+    EXPECT_EQ(gpak_fgetc(_file), 'n');
+
+    EXPECT_EQ(gpak_fseek(_file, -4l, SEEK_END), 0);
+    char _tail[8]{};
+    EXPECT_EQ(gpak_fread(_tail, 1ull, sizeof(_tail), _file), 4ull);
+    EXPECT_STREQ(_tail, " end");
+    EXPECT_NE(gpak_feof(_file), 0);
+    EXPECT_EQ(gpak_fseek(_file, -1l, SEEK_SET), -1);
+
+    gpak_fclose(_file);
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_request_queue_zstd)
+{
+    auto _archive_path = _tests_out_entry / "queue.gpak";
+    auto _source_path = _tests_out_entry / "queue";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 24ull, 59u);
+
+    for (uint32_t idx = 0u; idx < 3u; ++idx)
+    {
+        auto _name = "large_" + std::to_string(idx) + ".dat";
+        generate_random_file(_source_path / _name, 400000ull + idx * 50000ull);
+        std::ifstream file(_source_path / _name, std::ios::binary);
+        _sources[_name].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_compression_level(_pak, GPAK_COMPRESSION_ZST_FAST);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_set_chunk_size(_pak, 32u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    struct queue_results
+    {
+        std::map<std::string, std::string> contents_;
+        std::map<std::string, int32_t> errors_;
+    };
+
+    auto _handler = [](const char* _path, int32_t _error, gpak_view_t* _view, void* _user_data)
+    {
+        auto* _results = static_cast<queue_results*>(_user_data);
+        _results->errors_[_path] = _error;
+        if (_error == GPAK_ERROR_OK)
+            _results->contents_[_path].assign(_view->data_, _view->size_);
+        gpak_funmap(_view);
+    };
+
+    // A single worker has to interleave the large files with the urgent requests made after them
+    auto* _queue = gpak_queue_create(_pak, 1u);
+    ASSERT_NE(_queue, nullptr);
+
+    queue_results _results;
+    std::map<std::string, uint64_t> _requests;
+    for (uint32_t idx = 0u; idx < 3u; ++idx)
+    {
+        auto _name = "large_" + std::to_string(idx) + ".dat";
+        _requests[_name] = gpak_queue_request(_queue, _name.c_str(), -1, 0u, _handler, &_results);
+        EXPECT_NE(_requests[_name], 0ull);
+    }
+
+    // Gives the worker time to start on the first large file, the next requests preempt it
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+    int32_t _priority = 0;
+    for (const auto& [_name, _content] : _sources)
+    {
+        if (_requests.count(_name) == 0ull)
+            _requests[_name] = gpak_queue_request(_queue, _name.c_str(), _priority++ % 4, 0u, _handler, &_results);
+    }
+
+    EXPECT_EQ(gpak_queue_request(_queue, "missing.dat", 0, 0u, _handler, &_results), 0ull);
+    test_gpak_error_count -= 1ull;
+
+    // Requests not handed to their handler yet can always be cancelled
+    EXPECT_EQ(gpak_queue_cancel(_queue, _requests["large_1.dat"]), 1);
+    EXPECT_EQ(gpak_queue_cancel(_queue, 123456ull), 0);
+    EXPECT_EQ(gpak_queue_set_priority(_queue, 123456ull, 1), 0);
+    gpak_queue_set_priority(_queue, _requests["large_2.dat"], 8);
+
+    while (gpak_queue_pending(_queue) > 0u)
+        gpak_queue_poll(_queue, 1);
+
+    EXPECT_EQ(_results.errors_["large_1.dat"], GPAK_ERROR_CANCELLED);
+    EXPECT_EQ(gpak_queue_cancel(_queue, _requests["large_0.dat"]), 0);
+
+    for (const auto& [_name, _content] : _sources)
+    {
+        EXPECT_EQ(_results.errors_.count(_name), 1ull);
+        if (_name != "large_1.dat")
+        {
+            EXPECT_EQ(_results.errors_[_name], GPAK_ERROR_OK);
+            EXPECT_TRUE(_results.contents_[_name] == _content);
+        }
+    }
+
+    // Freeing the queue cancels what is left, every handler is still called
+    queue_results _late_results;
+    for (const auto& [_name, _content] : _sources)
+        gpak_queue_request(_queue, _name.c_str(), 0, 0u, _handler, &_late_results);
+    gpak_queue_free(_queue);
+
+    EXPECT_EQ(_late_results.errors_.size(), _sources.size());
+    for (const auto& [_name, _error] : _late_results.errors_)
+    {
+        EXPECT_TRUE(_error == GPAK_ERROR_OK || _error == GPAK_ERROR_CANCELLED);
+        if (_error == GPAK_ERROR_OK)
+        {
+            EXPECT_TRUE(_late_results.contents_[_name] == _sources[_name]);
+        }
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_in_place_zstd)
+{
+    auto _source_path = _tests_out_entry / "in_place";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 8ull, 61u);
+
+    for (uint32_t idx = 0u; idx < 3u; ++idx)
+    {
+        auto _name = "blob_" + std::to_string(idx) + ".dat";
+        generate_random_file(_source_path / _name, 200000ull + idx * 100000ull);
+        std::ifstream file(_source_path / _name, std::ios::binary);
+        _sources[_name].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    for (int _algorithm : { GPAK_HEADER_COMPRESSION_ZST, GPAK_HEADER_COMPRESSION_NONE, GPAK_HEADER_COMPRESSION_DEFLATE })
+    {
+        auto _archive_path = _tests_out_entry / ("in_place_" + std::to_string(_algorithm) + ".gpak");
+
+        auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_set_compression_algorithm(_pak, _algorithm);
+        gpak_test_add_files(_pak, _source_path);
+        gpak_close(_pak);
+
+        _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_set_in_place_decoding(_pak, 1);
+
+        for (const auto& [_name, _content] : _sources)
+        {
+            auto* _file = gpak_fopen(_pak, _name.c_str());
+            ASSERT_NE(_file, nullptr);
+
+            std::string _readed(_content.size(), '\0');
+            EXPECT_EQ(gpak_fread(_readed.data(), 1ull, _readed.size(), _file), _content.size());
+            EXPECT_TRUE(_readed == _content);
+            gpak_fclose(_file);
+
+            // Only zstd payloads need room past the decoded content
+            uint64_t _in_place_size = gpak_get_in_place_size(_pak, _name.c_str());
+            if (_algorithm == GPAK_HEADER_COMPRESSION_ZST)
+                EXPECT_GT(_in_place_size, _content.size());
+            else
+                EXPECT_EQ(_in_place_size, _content.size());
+
+            std::vector<char> _buffer(_in_place_size);
+            ASSERT_EQ(gpak_read_entry_into(_pak, _name.c_str(), _buffer.data(), _buffer.size()), GPAK_ERROR_OK);
+            EXPECT_TRUE(std::string(_buffer.data(), _content.size()) == _content);
+        }
+
+        EXPECT_EQ(gpak_get_in_place_size(_pak, "missing.dat"), 0ull);
+        gpak_close(_pak);
+    }
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_raw_entry_zstd)
+{
+    auto _source_path = _tests_out_entry / "raw";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::create_directories(_source_path);
+    auto _sources = generate_text_files(_source_path, 6ull, 67u);
+
+    std::string _text;
+    for (uint32_t idx = 0u; idx < 4000u; ++idx)
+        _text += "entry " + std::to_string(idx % 97u) + " of a compressible text file\n";
+    {
+        std::ofstream file(_source_path / "plain.txt", std::ios::binary);
+        file << _text;
+    }
+
+    generate_random_file(_source_path / "large.dat", 600000ull);
+
+    for (int _algorithm : { GPAK_HEADER_COMPRESSION_ZST, GPAK_HEADER_COMPRESSION_NONE })
+    {
+        auto _archive_path = _tests_out_entry / ("raw_" + std::to_string(_algorithm) + ".gpak");
+
+        auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+        ASSERT_NE(_pak, nullptr);
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_set_compression_algorithm(_pak, _algorithm);
+        gpak_set_solid_block_size(_pak, 16u * 1024u);
+        gpak_set_chunk_size(_pak, 256u * 1024u);
+        gpak_test_add_files(_pak, _source_path);
+        gpak_close(_pak);
+
+        for (int _mode : { GPAK_MODE_READ_ONLY, GPAK_MODE_MEMORY_MAP })
+        {
+            _pak = gpak_open(_archive_path.string().c_str(), _mode);
+            ASSERT_NE(_pak, nullptr);
+            gpak_set_error_handler(_pak, &error_handler);
+
+            gpak_raw_entry_t _raw;
+            ASSERT_EQ(gpak_fmap_raw(_pak, "plain.txt", &_raw), GPAK_ERROR_OK);
+            ASSERT_NE(_raw.data_, nullptr);
+            EXPECT_EQ(_raw.compression_, _algorithm);
+            EXPECT_EQ(_raw.uncompressed_size_, _text.size());
+            EXPECT_EQ(_raw.buffer_ == nullptr, _mode == GPAK_MODE_MEMORY_MAP);
+
+            // Stored payloads are the content itself, compressed ones are handed out undecoded
+            std::string _payload(_raw.data_, _raw.compressed_size_);
+            if (_algorithm == GPAK_HEADER_COMPRESSION_NONE)
+                EXPECT_TRUE(_payload == _text);
+            else
+                EXPECT_LT(_raw.compressed_size_, _raw.uncompressed_size_);
+
+            std::vector<char> _buffer(_raw.compressed_size_);
+            ASSERT_EQ(gpak_read_raw(_pak, "plain.txt", _buffer.data(), _buffer.size()), GPAK_ERROR_OK);
+            EXPECT_TRUE(std::string(_buffer.data(), _buffer.size()) == _payload);
+            EXPECT_EQ(gpak_read_raw(_pak, "plain.txt", _buffer.data(), _buffer.size() - 1ull), GPAK_ERROR_BUFFER_TOO_SMALL);
+            gpak_funmap_raw(&_raw);
+
+            // Files without a payload of their own are refused
+            EXPECT_EQ(gpak_stat_raw(_pak, "large.dat", &_raw), GPAK_ERROR_NOT_PLAIN_ENTRY);
+            EXPECT_EQ(gpak_stat_raw(_pak, _sources.begin()->first.c_str(), &_raw), GPAK_ERROR_NOT_PLAIN_ENTRY);
+            EXPECT_EQ(gpak_fmap_raw(_pak, "missing.dat", &_raw), GPAK_ERROR_FILE_NOT_FOUND);
+            test_gpak_error_count -= 4ull;
+
+            gpak_close(_pak);
+        }
+    }
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_extract_directory_zstd)
+{
+    auto _source_path = _tests_out_entry / "extract";
+    auto _archive_path = _tests_out_entry / "extract.gpak";
+    auto _out_path = _tests_out_entry / "extract_out";
+    auto _subtree_path = _tests_out_entry / "extract_subtree";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::remove_all(_out_path);
+    fs::remove_all(_subtree_path);
+    fs::create_directories(_source_path / "assets" / "nested");
+
+    generate_text_files(_source_path, 4ull, 91u);
+    generate_random_file(_source_path / "assets" / "large.dat", 400000ull);
+
+    std::string _shared(50000ull, 's');
+    for (auto _name : { "assets/copy_a.txt", "assets/nested/copy_b.txt" })
+    {
+        std::ofstream file(_source_path / _name, std::ios::binary);
+        file << _shared;
+    }
+    std::ofstream(_source_path / "assets" / "nested" / "empty.txt", std::ios::binary).close();
+
+    // Larger than an extraction window, streamed to disk on its own
+    {
+        std::string _huge(GPAK_EXTRACT_WINDOW_SIZE + 4096ull, '\0');
+        for (size_t idx = 0ull; idx < _huge.size(); ++idx)
+            _huge[idx] = (char)('a' + (idx / 4093ull) % 26ull);
+        std::ofstream file(_source_path / "huge.bin", std::ios::binary);
+        file.write(_huge.data(), _huge.size());
+    }
+
+    auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+    gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+    gpak_set_solid_block_size(_pak, 16u * 1024u);
+    gpak_set_chunk_size(_pak, 128u * 1024u);
+    gpak_test_add_files(_pak, _source_path);
+    gpak_close(_pak);
+
+    auto _read_file = [](const fs::path& _path)
+    {
+        std::string _content(fs::file_size(_path), '\0');
+        std::ifstream file(_path, std::ios::binary);
+        file.read(_content.data(), _content.size());
+        return _content;
+    };
+
+    _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    EXPECT_EQ(gpak_extract_all(_pak, _out_path.string().c_str()), GPAK_ERROR_OK);
+    EXPECT_EQ(number_of_files_in_directory(_out_path), number_of_files_in_directory(_source_path));
+    for (auto& entry : fs::recursive_directory_iterator(_source_path))
+    {
+        if (entry.is_regular_file())
+        {
+            EXPECT_TRUE(_read_file(entry.path()) == _read_file(_out_path / fs::relative(entry.path(), _source_path)));
+        }
+    }
+
+    // Subtrees are extracted relative to the requested directory
+    EXPECT_EQ(gpak_extract_directory(_pak, "assets", _subtree_path.string().c_str()), GPAK_ERROR_OK);
+    EXPECT_EQ(number_of_files_in_directory(_subtree_path), 4ull);
+    EXPECT_TRUE(_read_file(_subtree_path / "nested" / "copy_b.txt") == _shared);
+    EXPECT_TRUE(_read_file(_subtree_path / "large.dat") == _read_file(_source_path / "assets" / "large.dat"));
+
+    EXPECT_EQ(gpak_extract_directory(_pak, "missing", _subtree_path.string().c_str()), GPAK_ERROR_FILE_NOT_FOUND);
+    --test_gpak_error_count;
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
+TEST(gpak_test, gpak_parallel_pack_zstd)
+{
+    auto _source_path = _tests_out_entry / "parallel";
+    auto _out_path = _tests_out_entry / "parallel_out";
+    test_gpak_error_count = 0ull;
+
+    fs::remove_all(_source_path);
+    fs::remove_all(_out_path);
+    fs::create_directories(_source_path / "blocks");
+
+    generate_text_files(_source_path / "blocks", 64ull, 17u);
+    generate_text_files(_source_path, 8ull, 29u);
+    for (size_t idx = 0ull; idx < 4ull; ++idx)
+        generate_random_file(_source_path / ("medium_" + std::to_string(idx) + ".dat"), 60000ull + idx * 7000ull);
+    generate_random_file(_source_path / "large_a.dat", 900000ull);
+    fs::copy_file(_source_path / "large_a.dat", _source_path / "large_b.dat");
+    fs::copy_file(_source_path / "medium_1.dat", _source_path / "blocks" / "medium_copy.dat");
+
+    // Files are compressed out of order, the archive must not depend on which worker finishes first
+    auto _pack = [&](const fs::path& _archive_path)
+    {
+        auto* _pak = gpak_open(_archive_path.string().c_str(), GPAK_MODE_CREATE);
+        if (!_pak)
+            return;
+        gpak_set_error_handler(_pak, &error_handler);
+        gpak_set_compression_algorithm(_pak, GPAK_HEADER_COMPRESSION_ZST);
+        gpak_set_solid_block_size(_pak, 16u * 1024u);
+        gpak_set_chunk_size(_pak, 128u * 1024u);
+        gpak_test_add_files(_pak, _source_path);
+        gpak_close(_pak);
+    };
+
+    auto _read_file = [](const fs::path& _path)
+    {
+        std::string _content(fs::file_size(_path), '\0');
+        std::ifstream file(_path, std::ios::binary);
+        file.read(_content.data(), _content.size());
+        return _content;
+    };
+
+    _pack(_tests_out_entry / "parallel_a.gpak");
+    _pack(_tests_out_entry / "parallel_b.gpak");
+    EXPECT_TRUE(_read_file(_tests_out_entry / "parallel_a.gpak") == _read_file(_tests_out_entry / "parallel_b.gpak"));
+
+    auto* _pak = gpak_open((_tests_out_entry / "parallel_a.gpak").string().c_str(), GPAK_MODE_READ_ONLY);
+    ASSERT_NE(_pak, nullptr);
+    gpak_set_error_handler(_pak, &error_handler);
+
+    EXPECT_EQ(gpak_extract_all(_pak, _out_path.string().c_str()), GPAK_ERROR_OK);
+    EXPECT_EQ(number_of_files_in_directory(_out_path), number_of_files_in_directory(_source_path));
+    for (auto& entry : fs::recursive_directory_iterator(_source_path))
+    {
+        if (entry.is_regular_file())
+        {
+            EXPECT_TRUE(_read_file(entry.path()) == _read_file(_out_path / fs::relative(entry.path(), _source_path)));
+        }
+    }
+
+    gpak_close(_pak);
+
+    EXPECT_EQ(test_gpak_error_count, 0ull);
+}
+
 int main(int argc, char** argv) 
 {
     // Prepare test data